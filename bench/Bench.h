@@ -0,0 +1,45 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Shared bits for the benchmarks: a fast deterministic byte source and a
+// stopwatch. Same seed, same bytes, so runs are comparable across machines.
+namespace Bench {
+
+class Rng {
+public:
+    explicit Rng(uint64_t seed) : m_state(seed ? seed : 1) {}
+    uint64_t Next() {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 7;
+        m_state ^= m_state << 17;
+        return m_state;
+    }
+    void Fill(uint8_t* p, size_t n) {
+        for (size_t i = 0; i < n; ++i) p[i] = (uint8_t)(Next() >> 56);
+    }
+    std::vector<uint8_t> Bytes(size_t n) {
+        std::vector<uint8_t> out(n);
+        Fill(out.data(), n);
+        return out;
+    }
+
+private:
+    uint64_t m_state;
+};
+
+class Stopwatch {
+public:
+    Stopwatch() : m_start(std::chrono::steady_clock::now()) {}
+    double Seconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+inline double MiB(double bytes) { return bytes / (1024.0 * 1024.0); }
+
+}
@@ -0,0 +1,131 @@
+#include "Bench.h"
+#include "Chunker.h"
+#include "Hash.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_set>
+
+using namespace ClipboardPush;
+
+// What a re-push of an edited file costs on the wire. The receiver's chunk
+// store already holds every chunk of the previous version, so only chunks
+// it hasn't seen travel. Chunk IDs are an HMAC of the content in the app;
+// here an XXH64 of it stands in, which dedups the same way.
+//
+// Content-defined chunks are compared with fixed 64 KB blocks (what a naive
+// chunker would do) and with resending the whole file.
+
+static const size_t kFileBytes = 32 * 1024 * 1024;
+static const size_t kFixedBlock = 64 * 1024;
+
+using Spans = std::vector<Chunker::Span>;
+
+static Spans Fixed(size_t size) {
+    Spans out;
+    for (size_t off = 0; off < size; off += kFixedBlock) out.push_back({ off, std::min(kFixedBlock, size - off) });
+    return out;
+}
+
+static std::unordered_set<uint64_t> Ids(const std::vector<uint8_t>& data, const Spans& spans) {
+    std::unordered_set<uint64_t> ids;
+    for (const auto& s : spans) ids.insert(Hash::XXH64(data.data() + s.offset, s.length));
+    return ids;
+}
+
+// Bytes of `edited` whose chunks aren't among `known`
+static size_t Missing(const std::vector<uint8_t>& edited, const Spans& spans, const std::unordered_set<uint64_t>& known) {
+    size_t bytes = 0;
+    std::unordered_set<uint64_t> sent;
+    for (const auto& s : spans) {
+        uint64_t id = Hash::XXH64(edited.data() + s.offset, s.length);
+        if (!known.count(id) && sent.insert(id).second) bytes += s.length;
+    }
+    return bytes;
+}
+
+struct Edit {
+    const char* name;
+    std::vector<uint8_t> (*apply)(const std::vector<uint8_t>& base, Bench::Rng& rng);
+};
+
+static const Edit kEdits[] = {
+    { "insert 100 B in the middle", [](const std::vector<uint8_t>& b, Bench::Rng& rng) {
+        auto out = b;
+        auto ins = rng.Bytes(100);
+        out.insert(out.begin() + out.size() / 2, ins.begin(), ins.end());
+        return out;
+    } },
+    { "prepend 10 B", [](const std::vector<uint8_t>& b, Bench::Rng& rng) {
+        std::vector<uint8_t> out(b.size() + 10);
+        rng.Fill(out.data(), 10);
+        memcpy(out.data() + 10, b.data(), b.size());
+        return out;
+    } },
+    { "overwrite 4 KB at 10 places", [](const std::vector<uint8_t>& b, Bench::Rng& rng) {
+        auto out = b;
+        for (int i = 0; i < 10; ++i) {
+            size_t at = (size_t)(rng.Next() % (out.size() - 4096));
+            rng.Fill(out.data() + at, 4096);
+        }
+        return out;
+    } },
+    { "delete 1 MB in the middle", [](const std::vector<uint8_t>& b, Bench::Rng&) {
+        // Not block-aligned, or fixed blocks would line up again by luck
+        auto out = b;
+        auto mid = out.begin() + out.size() / 2 + 1000;
+        out.erase(mid, mid + 1000 * 1000);
+        return out;
+    } },
+    { "append 1 MB", [](const std::vector<uint8_t>& b, Bench::Rng& rng) {
+        auto out = b;
+        auto tail = rng.Bytes(1024 * 1024);
+        out.insert(out.end(), tail.begin(), tail.end());
+        return out;
+    } },
+    { "unchanged", [](const std::vector<uint8_t>& b, Bench::Rng&) { return b; } },
+};
+
+static void Throughput(const std::vector<uint8_t>& data) {
+    // Warm up, then take the best of a few passes
+    Chunker::Split(data.data(), data.size());
+    double best = 1e9;
+    size_t chunks = 0;
+    for (int i = 0; i < 5; ++i) {
+        Bench::Stopwatch sw;
+        chunks = Chunker::Split(data.data(), data.size()).size();
+        best = std::min(best, sw.Seconds());
+    }
+    double hashBest = 1e9;
+    volatile uint64_t sink = 0;
+    for (int i = 0; i < 5; ++i) {
+        Bench::Stopwatch sw;
+        sink = sink + Hash::XXH64(data.data(), data.size());
+        hashBest = std::min(hashBest, sw.Seconds());
+    }
+    printf("Chunking %.0f MB: %zu chunks (avg %.1f KB), %.0f MB/s; XXH64 over the same bytes %.0f MB/s\n",
+        Bench::MiB((double)data.size()), chunks, (double)data.size() / (double)chunks / 1024.0,
+        Bench::MiB((double)data.size()) / best, Bench::MiB((double)data.size()) / hashBest);
+}
+
+int main() {
+    Bench::Rng rng(0x5eed);
+    auto base = rng.Bytes(kFileBytes);
+
+    Throughput(base);
+
+    auto baseCdc = Ids(base, Chunker::Split(base.data(), base.size()));
+    auto baseFixed = Ids(base, Fixed(base.size()));
+
+    printf("\n%-30s %12s %14s %14s %10s\n", "Edit (32 MB file)", "whole file", "fixed 64 KB", "content-defined", "dedup");
+    for (const auto& e : kEdits) {
+        auto edited = e.apply(base, rng);
+        size_t cdc = Missing(edited, Chunker::Split(edited.data(), edited.size()), baseCdc);
+        size_t fixed = Missing(edited, Fixed(edited.size()), baseFixed);
+        printf("%-30s %9.2f MB %11.2f MB %12.2f MB %9.1f%%\n", e.name,
+            Bench::MiB((double)edited.size()), Bench::MiB((double)fixed), Bench::MiB((double)cdc),
+            100.0 * (1.0 - (double)cdc / (double)edited.size()));
+    }
+    return 0;
+}
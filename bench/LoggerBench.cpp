@@ -0,0 +1,137 @@
+#include "Bench.h"
+#include "Logger.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ClipboardPush;
+using Clock = std::chrono::steady_clock;
+
+// What a log call costs the thread that makes it. Producers log in bursts
+// that fit the ring and then pause so the sink can drain, which is how the
+// app logs: a few lines per transfer step, not a flood. Each call is timed
+// on its own (clock overhead subtracted) to get the tail, not just the mean.
+//
+// The baseline formats and writes under a lock on the calling thread, as a
+// plain synchronous logger would. The sink's output goes to the null device
+// so the terminal isn't what gets measured; results go to stderr.
+
+static const int kBurst = 256;
+static const int kBursts = 200;
+
+static double g_clockNs = 0;
+
+struct Result {
+    std::vector<double> ns;
+    void Add(const std::vector<double>& more) { ns.insert(ns.end(), more.begin(), more.end()); }
+    void Print(const char* name) {
+        std::sort(ns.begin(), ns.end());
+        double sum = 0;
+        for (double v : ns) sum += v;
+        auto pct = [&](double p) { return ns[std::min(ns.size() - 1, (size_t)(p * (double)ns.size()))]; };
+        fprintf(stderr, "%-44s %8.0f %8.0f %8.0f %9.0f\n", name, sum / (double)ns.size(), pct(0.50), pct(0.99), pct(0.999));
+    }
+};
+
+static double Calibrate() {
+    double best = 1e9;
+    for (int i = 0; i < 1000; ++i) {
+        auto a = Clock::now();
+        auto b = Clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(b - a).count());
+    }
+    return best;
+}
+
+template <typename F>
+static std::vector<double> Producer(int bursts, F call) {
+    std::vector<double> ns;
+    ns.reserve((size_t)bursts * kBurst);
+    for (int b = 0; b < bursts; ++b) {
+        for (int i = 0; i < kBurst; ++i) {
+            auto start = Clock::now();
+            call(i);
+            auto end = Clock::now();
+            ns.push_back(std::max(0.0, std::chrono::duration<double, std::nano>(end - start).count() - g_clockNs));
+        }
+        // Let the sink catch up; the pause is not part of any sample
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return ns;
+}
+
+template <typename F>
+static Result Run(int threads, F call) {
+    Result result;
+    std::mutex mutex;
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&] {
+            auto ns = Producer(kBursts / threads, call);
+            std::lock_guard<std::mutex> lock(mutex);
+            result.Add(ns);
+        });
+    }
+    for (auto& t : pool) t.join();
+    return result;
+}
+
+static std::mutex g_syncMutex;
+static FILE* g_null = nullptr;
+
+// Format and write on the caller, one line at a time
+static void SyncLog(const char* format, int a, const char* b, double c) {
+    char line[512];
+    auto now = std::chrono::system_clock::now();
+    std::time_t t = std::chrono::system_clock::to_time_t(now);
+    std::tm tm_struct;
+#ifdef _WIN32
+    localtime_s(&tm_struct, &t);
+#else
+    localtime_r(&t, &tm_struct);
+#endif
+    int n = snprintf(line, sizeof(line), "[%02d:%02d:%02d] INFO  ", tm_struct.tm_hour, tm_struct.tm_min, tm_struct.tm_sec);
+    snprintf(line + n, sizeof(line) - (size_t)n, format, a, b, c);
+    std::lock_guard<std::mutex> lock(g_syncMutex);
+    fputs(line, g_null);
+    fputc('\n', g_null);
+    fflush(g_null);
+}
+
+int main() {
+#ifdef _WIN32
+    const char* nullDevice = "NUL";
+#else
+    const char* nullDevice = "/dev/null";
+#endif
+    if (!freopen(nullDevice, "w", stdout)) return 1;
+    g_null = fopen(nullDevice, "w");
+    if (!g_null) return 1;
+
+    g_clockNs = Calibrate();
+    std::string peer = "device-7f3a9c";
+
+    fprintf(stderr, "ns per call, bursts of %d (clock overhead %.0f ns removed)\n", kBurst, g_clockNs);
+    fprintf(stderr, "%-44s %8s %8s %8s %9s\n", "", "mean", "p50", "p99", "p99.9");
+
+    // Warm the ring and the sink thread
+    Run(1, [&](int i) { LOG_INFO("warmup %d", i); });
+
+    Run(1, [&](int) { LOG_INFO("Transfer started"); }).Print("ring, no arguments, 1 thread");
+    Run(1, [&](int i) { LOG_INFO("chunk %d from %s at %.1f MB/s", i, peer.c_str(), 42.5); }).Print("ring, int + string + double, 1 thread");
+    Run(4, [&](int i) { LOG_INFO("chunk %d from %s at %.1f MB/s", i, peer.c_str(), 42.5); }).Print("ring, int + string + double, 4 threads");
+    Run(1, [&](int i) { SyncLog("chunk %d from %s at %.1f MB/s", i, peer.c_str(), 42.5); }).Print("synchronous format + write, 1 thread");
+    Run(4, [&](int i) { SyncLog("chunk %d from %s at %.1f MB/s", i, peer.c_str(), 42.5); }).Print("synchronous format + write, 4 threads");
+#ifdef NDEBUG
+    Run(1, [&](int) { LOG_DEBUG("chunk from %s", peer.c_str()); }).Print("LOG_DEBUG (compiled out in this build)");
+#endif
+
+    Logger::Shutdown();
+    fclose(g_null);
+    return 0;
+}
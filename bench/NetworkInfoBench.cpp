@@ -0,0 +1,60 @@
+#include "Bench.h"
+#include "NetworkInfo.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace ClipboardPush;
+
+// What a caller pays to learn the machine's addresses: a fresh enumeration
+// (adapters, routes, neighbour table) against the cached snapshot every
+// announcement and pull now reads, alone and with other threads reading it
+// at the same time.
+
+// Keeps the optimizer from dropping the calls being timed
+static std::atomic<size_t> g_sink{ 0 };
+
+template <typename F>
+static double MicrosPerCall(int calls, F call) {
+    Bench::Stopwatch sw;
+    for (int i = 0; i < calls; ++i) call();
+    return sw.Seconds() * 1e6 / calls;
+}
+
+int main() {
+    NetworkInfo& info = NetworkInfo::Instance();
+    NetworkMetadata m = info.Snapshot();
+    printf("%zu address(es), private_ip %s\n\n", m.addresses.size(), m.private_ip.c_str());
+
+    size_t sink = 0;
+    double query = MicrosPerCall(200, [&] { sink += NetworkInfo::Query().addresses.size(); });
+    double refresh = MicrosPerCall(200, [&] {
+        info.Invalidate();
+        sink += info.Snapshot().addresses.size();
+    });
+    double cached = MicrosPerCall(200000, [&] { sink += info.Snapshot().addresses.size(); });
+
+    // Readers on other threads share the cache; nobody enumerates
+    const int kThreads = 4;
+    std::vector<double> perThread(kThreads);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < kThreads; ++t) {
+        pool.emplace_back([&, t] {
+            size_t local = 0;
+            perThread[t] = MicrosPerCall(100000, [&] { local += info.Snapshot().addresses.size(); });
+            g_sink += local;
+        });
+    }
+    for (auto& t : pool) t.join();
+    double contended = *std::max_element(perThread.begin(), perThread.end());
+
+    printf("%-40s %10.2f us\n", "Query() (fresh enumeration)", query);
+    printf("%-40s %10.2f us\n", "Invalidate() + Snapshot()", refresh);
+    printf("%-40s %10.3f us\n", "Snapshot() (cached)", cached);
+    printf("%-40s %10.3f us\n", "Snapshot() (cached, 4 threads)", contended);
+    printf("\ncached is %.0fx cheaper than enumerating\n", query / cached);
+    g_sink += sink;
+    return 0;
+}
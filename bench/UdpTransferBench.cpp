@@ -0,0 +1,207 @@
+// MUST include winsock2 before windows.h
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include "Bench.h"
+#include "UdpTransfer.h"
+#include "BlobStore.h"
+#include "Config.h"
+#include "Crypto.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+using namespace ClipboardPush;
+
+// Throughput of a UDP pull from a local server through a shim that drops
+// datagrams at random and delays the rest, the way a busy Wi-Fi link does.
+// The shim sits between Fetch and the server in both directions, so acks
+// are lost as well as data. The payload goes through the real path: sealed
+// by BlobStore, served by UdpTransfer, opened by GcmDecryptor in the sink.
+
+static const size_t kPayloadBytes = 64 * 1024 * 1024;
+static const int kOneWayDelayMs = 2;
+
+// Forwards one client's datagrams to the server and the replies back,
+// dropping each with probability `loss`
+class LossShim {
+public:
+    LossShim(int serverPort, double loss, uint64_t seed) : m_loss(loss), m_rng(seed) {
+        int buf = 4 * 1024 * 1024;
+        sockaddr_in local = {};
+        local.sin_family = AF_INET;
+        local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        m_front = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        bind(m_front, (sockaddr*)&local, sizeof(local));
+        int len = sizeof(local);
+        getsockname(m_front, (sockaddr*)&local, &len);
+        m_port = ntohs(local.sin_port);
+
+        sockaddr_in server = {};
+        server.sin_family = AF_INET;
+        server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        server.sin_port = htons((unsigned short)serverPort);
+        m_back = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        connect(m_back, (sockaddr*)&server, sizeof(server));
+
+        for (SOCKET s : { m_front, m_back }) {
+            u_long nonBlocking = 1;
+            ioctlsocket(s, FIONBIO, &nonBlocking);
+            setsockopt(s, SOL_SOCKET, SO_SNDBUF, (const char*)&buf, sizeof(buf));
+            setsockopt(s, SOL_SOCKET, SO_RCVBUF, (const char*)&buf, sizeof(buf));
+        }
+        m_thread = std::thread([this] { Run(); });
+    }
+
+    ~LossShim() {
+        m_running = false;
+        m_thread.join();
+        closesocket(m_front);
+        closesocket(m_back);
+    }
+
+    int Port() const { return m_port; }
+    uint64_t Dropped() const { return m_dropped; }
+
+private:
+    struct Datagram {
+        std::chrono::steady_clock::time_point due;
+        bool toServer;
+        std::vector<char> bytes;
+    };
+
+    void Run() {
+        std::deque<Datagram> queue;
+        sockaddr_in client = {};
+        bool haveClient = false;
+        char buf[2048];
+
+        while (m_running) {
+            auto now = std::chrono::steady_clock::now();
+            long waitUs = 10000;
+            if (!queue.empty()) {
+                auto left = std::chrono::duration_cast<std::chrono::microseconds>(queue.front().due - now).count();
+                waitUs = (long)std::max<long long>(0, std::min<long long>(left, waitUs));
+            }
+            fd_set readable;
+            FD_ZERO(&readable);
+            FD_SET(m_front, &readable);
+            FD_SET(m_back, &readable);
+            timeval tv = { 0, waitUs };
+            select(0, &readable, nullptr, nullptr, &tv);
+
+            now = std::chrono::steady_clock::now();
+            auto due = now + std::chrono::milliseconds(kOneWayDelayMs);
+            for (;;) {
+                sockaddr_in from = {};
+                int fromLen = sizeof(from);
+                int n = recvfrom(m_front, buf, sizeof(buf), 0, (sockaddr*)&from, &fromLen);
+                if (n <= 0) break;
+                client = from;
+                haveClient = true;
+                Admit(queue, due, true, buf, n);
+            }
+            for (;;) {
+                int n = recv(m_back, buf, sizeof(buf), 0);
+                if (n <= 0) break;
+                Admit(queue, due, false, buf, n);
+            }
+
+            // Every datagram waits the same delay, so the queue stays in due order
+            while (!queue.empty() && queue.front().due <= now) {
+                Datagram& d = queue.front();
+                if (d.toServer) {
+                    send(m_back, d.bytes.data(), (int)d.bytes.size(), 0);
+                } else if (haveClient) {
+                    sendto(m_front, d.bytes.data(), (int)d.bytes.size(), 0, (sockaddr*)&client, sizeof(client));
+                }
+                queue.pop_front();
+            }
+        }
+    }
+
+    void Admit(std::deque<Datagram>& queue, std::chrono::steady_clock::time_point due, bool toServer, const char* data, int len) {
+        double roll = (double)(m_rng.Next() >> 11) * (1.0 / 9007199254740992.0);
+        if (roll < m_loss) {
+            ++m_dropped;
+            return;
+        }
+        queue.push_back({ due, toServer, std::vector<char>(data, data + len) });
+    }
+
+    double m_loss;
+    Bench::Rng m_rng;
+    SOCKET m_front = INVALID_SOCKET;
+    SOCKET m_back = INVALID_SOCKET;
+    int m_port = 0;
+    std::atomic<uint64_t> m_dropped{ 0 };
+    std::atomic<bool> m_running{ true };
+    std::thread m_thread;
+};
+
+static int FreeUdpPort() {
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(s, (sockaddr*)&local, sizeof(local));
+    int len = sizeof(local);
+    getsockname(s, (sockaddr*)&local, &len);
+    closesocket(s);
+    return ntohs(local.sin_port);
+}
+
+// Pulls the blob once; false if the fetch failed or the plaintext differs
+static bool Pull(int port, const std::string& name, const std::vector<uint8_t>& key, const std::vector<uint8_t>& expected) {
+    std::atomic<bool> cancelled{ false };
+    Crypto::GcmDecryptor decryptor(key);
+    std::vector<uint8_t> plain;
+    plain.reserve(expected.size());
+    bool ok = UdpTransfer::Fetch("127.0.0.1", port, name, Config::Instance().Get()->room_id, std::chrono::seconds(5), cancelled,
+        [&](const uint8_t* data, size_t len) { return decryptor.Update(data, len, plain); });
+    return ok && decryptor.Finish(plain) && plain == expected;
+}
+
+int main() {
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return 1;
+
+    Config::Instance().Update([](ConfigData& c) { c.room_id = "bench-room"; });
+    BlobStore::Instance().Init(std::filesystem::temp_directory_path() / "ClipboardPushBench", 2 * (uint64_t)kPayloadBytes);
+
+    Bench::Rng rng(44);
+    std::vector<uint8_t> key = rng.Bytes(32);
+    std::vector<uint8_t> payload = rng.Bytes(kPayloadBytes);
+    auto blob = BlobStore::Instance().Put(key, payload.data(), payload.size());
+    int serverPort = FreeUdpPort();
+    if (!blob || !UdpTransfer::Instance().Start(serverPort)) {
+        fprintf(stderr, "cannot set up the server\n");
+        return 1;
+    }
+
+    printf("%.0f MiB blob, %d ms each way through the shim\n\n", Bench::MiB((double)kPayloadBytes), kOneWayDelayMs);
+    printf("%-24s %10s %12s %10s\n", "path", "MiB/s", "dropped", "result");
+
+    Bench::Stopwatch direct;
+    bool ok = Pull(serverPort, blob->id, key, payload);
+    printf("%-24s %10.1f %12s %10s\n", "direct (no shim)", Bench::MiB((double)kPayloadBytes) / direct.Seconds(), "-", ok ? "ok" : "FAILED");
+
+    for (double loss : { 0.0, 0.005, 0.01, 0.02, 0.05 }) {
+        LossShim shim(serverPort, loss, 1000 + (uint64_t)(loss * 1000));
+        Bench::Stopwatch sw;
+        ok = Pull(shim.Port(), blob->id, key, payload);
+        double seconds = sw.Seconds();
+        char label[32];
+        snprintf(label, sizeof(label), "shim, %.1f%% loss", loss * 100);
+        printf("%-24s %10.1f %12llu %10s\n", label, Bench::MiB((double)kPayloadBytes) / seconds,
+            (unsigned long long)shim.Dropped(), ok ? "ok" : "FAILED");
+    }
+
+    BlobStore::Instance().Release(blob->id);
+    UdpTransfer::Instance().Stop();
+    WSACleanup();
+    return 0;
+}
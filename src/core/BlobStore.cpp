@@ -0,0 +1,192 @@
+#include "BlobStore.h"
+#include "Crypto.h"
+#include "Logger.h"
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+namespace ClipboardPush {
+
+static const size_t kBlobIdBytes = 16;
+static const size_t kPutPieceBytes = 1024 * 1024;
+
+struct BlobStore::Writer::Impl {
+    Impl(const std::vector<uint8_t>& key) : mac(key), enc(key) {}
+
+    Crypto::HmacSha256Stream mac;
+    Crypto::GcmEncryptor enc;
+    fs::path part;
+    std::ofstream file;
+    std::vector<uint8_t> buf;
+    uint64_t size = 0;
+    bool done = false;
+};
+
+BlobStore::Writer::Writer(std::unique_ptr<Impl> impl) : m_impl(std::move(impl)) {}
+
+BlobStore::Writer::~Writer() {
+    if (m_impl->done) return;
+    m_impl->file.close();
+    std::error_code ec;
+    fs::remove(m_impl->part, ec);
+}
+
+bool BlobStore::Writer::Write(const uint8_t* data, size_t len) {
+    Impl& w = *m_impl;
+    if (w.done || !w.file) return false;
+    w.buf.clear();
+    if (!w.mac.Update(data, len) || !w.enc.Update(data, len, w.buf)) return false;
+    w.file.write((const char*)w.buf.data(), w.buf.size());
+    w.size += w.buf.size();
+    return (bool)w.file;
+}
+
+std::optional<BlobStore::Blob> BlobStore::Writer::Commit() {
+    Impl& w = *m_impl;
+    if (w.done || !w.file) return std::nullopt;
+    w.buf.clear();
+    if (!w.enc.Finish(w.buf)) return std::nullopt;
+    w.file.write((const char*)w.buf.data(), w.buf.size());
+    w.size += w.buf.size();
+    w.file.close();
+    if (!w.file) return std::nullopt;
+
+    auto mac = w.mac.Finish();
+    if (mac.size() < kBlobIdBytes) return std::nullopt;
+    static const char digits[] = "0123456789abcdef";
+    std::string id;
+    for (size_t i = 0; i < kBlobIdBytes; ++i) {
+        id.push_back(digits[mac[i] >> 4]);
+        id.push_back(digits[mac[i] & 0xF]);
+    }
+
+    w.done = true;
+    return BlobStore::Instance().Adopt(w.part, id, w.size);
+}
+
+BlobStore& BlobStore::Instance() {
+    static BlobStore instance;
+    return instance;
+}
+
+void BlobStore::Init(const fs::path& dir, uint64_t budgetBytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dir = dir;
+    m_budget = budgetBytes;
+    m_total = 0;
+    m_entries.clear();
+    m_aliases.clear();
+    m_lru.clear();
+
+    // Blobs belong to pushes of a previous run; nobody can ask for them again
+    std::error_code ec;
+    fs::remove_all(m_dir, ec);
+    fs::create_directories(m_dir, ec);
+}
+
+std::unique_ptr<BlobStore::Writer> BlobStore::Create(const std::vector<uint8_t>& key) {
+    auto impl = std::make_unique<Writer::Impl>(key);
+    if (!impl->mac.IsValid() || !impl->enc.IsValid()) return nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_dir.empty()) return nullptr;
+        impl->part = m_dir / ("w" + std::to_string(m_nextPart++) + ".part");
+    }
+    impl->file.open(impl->part, std::ios::binary | std::ios::trunc);
+    if (!impl->file.is_open()) {
+        LOG_ERROR("Blob store: cannot create %s", impl->part.string().c_str());
+        return nullptr;
+    }
+    impl->file.write((const char*)impl->enc.Nonce(), 12);
+    impl->size = 12;
+    return std::unique_ptr<Writer>(new Writer(std::move(impl)));
+}
+
+std::optional<BlobStore::Blob> BlobStore::Put(const std::vector<uint8_t>& key, const uint8_t* data, size_t size) {
+    auto writer = Create(key);
+    if (!writer) return std::nullopt;
+    for (size_t off = 0; off < size; off += kPutPieceBytes) {
+        if (!writer->Write(data + off, std::min(kPutPieceBytes, size - off))) return std::nullopt;
+    }
+    return writer->Commit();
+}
+
+std::optional<BlobStore::Blob> BlobStore::Adopt(const fs::path& part, const std::string& id, uint64_t size) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::error_code ec;
+
+    // Same content pushed again: keep the blob we have
+    auto it = m_entries.find(id);
+    if (it != m_entries.end()) {
+        fs::remove(part, ec);
+        it->second.refs++;
+        m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+        return Blob{ id, m_dir / id, it->second.size };
+    }
+
+    fs::rename(part, m_dir / id, ec);
+    if (ec) {
+        LOG_ERROR("Blob store: cannot publish blob (%s)", ec.message().c_str());
+        fs::remove(part, ec);
+        return std::nullopt;
+    }
+    m_lru.push_front(id);
+    m_entries[id] = { size, 1, m_lru.begin() };
+    m_total += size;
+    EvictLocked();
+    return Blob{ id, m_dir / id, size };
+}
+
+std::optional<BlobStore::Blob> BlobStore::Acquire(const std::string& idOrAlias) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string id = idOrAlias;
+    auto alias = m_aliases.find(idOrAlias);
+    if (alias != m_aliases.end()) id = alias->second;
+
+    auto it = m_entries.find(id);
+    if (it == m_entries.end()) return std::nullopt;
+    it->second.refs++;
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+    return Blob{ id, m_dir / id, it->second.size };
+}
+
+void BlobStore::Release(const std::string& id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(id);
+    if (it == m_entries.end() || it->second.refs == 0) return;
+    if (--it->second.refs == 0) EvictLocked();
+}
+
+void BlobStore::SetAlias(const std::string& alias, const std::string& id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_aliases[alias] = id;
+}
+
+void BlobStore::RemoveAlias(const std::string& alias) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_aliases.erase(alias);
+}
+
+void BlobStore::EvictLocked() {
+    std::error_code ec;
+    for (auto it = m_lru.end(); it != m_lru.begin() && m_total > m_budget;) {
+        --it;
+        auto entry = m_entries.find(*it);
+        if (entry != m_entries.end() && entry->second.refs > 0) continue;
+        if (entry != m_entries.end()) {
+            m_total -= entry->second.size;
+            m_entries.erase(entry);
+        }
+        fs::remove(m_dir / *it, ec);
+        it = m_lru.erase(it);
+    }
+}
+
+bool BlobStore::IsValidName(const std::string& name) {
+    if (name.empty() || name.size() > 64) return false;
+    return std::all_of(name.begin(), name.end(), [](char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    });
+}
+
+}
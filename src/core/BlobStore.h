@@ -0,0 +1,84 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <optional>
+#include <filesystem>
+#include <cstdint>
+
+namespace ClipboardPush {
+
+// Whole-file envelopes (Nonce + Ciphertext + Tag) of outgoing transfers,
+// held once on disk and shared by the LAN /blobs route and the relay
+// uploader. A blob's ID is a room-keyed hash of its plaintext, so pushing
+// the same content twice reuses one file. Blobs in use are pinned; the rest
+// are evicted least recently used first once the byte budget is exceeded.
+// Nothing survives a restart: the directory is emptied by Init().
+class BlobStore {
+public:
+    struct Blob {
+        std::string id;
+        std::filesystem::path path;
+        uint64_t size = 0;
+    };
+
+    // Encrypts a payload fed in pieces into a new blob
+    class Writer {
+    public:
+        ~Writer();
+        bool Write(const uint8_t* data, size_t len);
+        // Returns the blob, pinned once for the caller; nullopt on failure
+        std::optional<Blob> Commit();
+
+    private:
+        friend class BlobStore;
+        struct Impl;
+        explicit Writer(std::unique_ptr<Impl> impl);
+        std::unique_ptr<Impl> m_impl;
+    };
+
+    static BlobStore& Instance();
+
+    void Init(const std::filesystem::path& dir, uint64_t budgetBytes);
+
+    std::unique_ptr<Writer> Create(const std::vector<uint8_t>& key);
+    // Create + Write + Commit for a payload that is already in memory or mapped
+    std::optional<Blob> Put(const std::vector<uint8_t>& key, const uint8_t* data, size_t size);
+
+    // Each Acquire (and Commit/Put) pins the blob until a matching Release
+    std::optional<Blob> Acquire(const std::string& idOrAlias);
+    void Release(const std::string& id);
+
+    // Lets a transfer ID stand for its blob in URLs announced before the blob exists
+    void SetAlias(const std::string& alias, const std::string& id);
+    void RemoveAlias(const std::string& alias);
+
+    static bool IsValidName(const std::string& name);
+
+private:
+    BlobStore() = default;
+
+    struct Entry {
+        uint64_t size;
+        int refs;
+        std::list<std::string>::iterator lru;
+    };
+
+    std::optional<Blob> Adopt(const std::filesystem::path& part, const std::string& id, uint64_t size);
+    void EvictLocked();
+
+    std::mutex m_mutex;
+    std::filesystem::path m_dir;
+    uint64_t m_budget = 0;
+    uint64_t m_total = 0;
+    uint64_t m_nextPart = 0;
+    std::map<std::string, Entry> m_entries;
+    std::map<std::string, std::string> m_aliases;
+    std::list<std::string> m_lru; // front = most recently used
+};
+
+}
@@ -0,0 +1,247 @@
+#include "ChunkPipeline.h"
+#include "ChunkStore.h"
+#include "Crypto.h"
+#include "Logger.h"
+#include <algorithm>
+
+namespace ClipboardPush {
+
+std::mutex ChunkPipeline::s_registryMutex;
+std::map<std::string, std::shared_ptr<ChunkPipeline>> ChunkPipeline::s_registry;
+
+// Queue waits are usually short (the neighbouring stage is mid-chunk), so
+// yield first and only start sleeping on longer stalls
+static void Backoff(int& spins) {
+    if (++spins < 64) std::this_thread::yield();
+    else std::this_thread::sleep_for(std::chrono::microseconds(500));
+}
+
+template <typename T, typename Aborted>
+static bool PushWait(SpscQueue<T>& q, T& item, const Aborted& aborted) {
+    int spins = 0;
+    while (!q.TryPush(item)) {
+        if (aborted()) return false;
+        Backoff(spins);
+    }
+    return true;
+}
+
+// False once the producer closed the queue and it is drained, or on abort
+template <typename T, typename Aborted>
+static bool PopWait(SpscQueue<T>& q, T& out, const Aborted& aborted) {
+    int spins = 0;
+    for (;;) {
+        if (q.TryPop(out)) return true;
+        if (q.Closed()) return q.TryPop(out);
+        if (aborted()) return false;
+        Backoff(spins);
+    }
+}
+
+std::shared_ptr<ChunkPipeline> ChunkPipeline::Create(const std::string& transferId, const std::vector<uint8_t>& key,
+    TransferSource source, bool wholeBlob, DoneCallback onDone) {
+    std::shared_ptr<ChunkPipeline> p(new ChunkPipeline(transferId, key, std::move(source), wholeBlob));
+    p->m_onDone = std::move(onDone);
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    s_registry[transferId] = p;
+    return p;
+}
+
+void ChunkPipeline::Run(const std::atomic<bool>& cancelled) {
+    m_cancelled = &cancelled;
+    m_started = std::chrono::steady_clock::now();
+    m_threads[kChunkStage] = std::thread(&ChunkPipeline::RunChunk, this);
+    m_threads[kSealStage] = std::thread(&ChunkPipeline::RunSeal, this);
+    RunPublish();
+    m_cancelled = nullptr;
+}
+
+std::shared_ptr<ChunkPipeline> ChunkPipeline::Find(const std::string& transferId) {
+    std::lock_guard<std::mutex> lock(s_registryMutex);
+    auto it = s_registry.find(transferId);
+    return it != s_registry.end() ? it->second : nullptr;
+}
+
+void ChunkPipeline::Release(const std::string& transferId) {
+    std::shared_ptr<ChunkPipeline> p;
+    {
+        std::lock_guard<std::mutex> lock(s_registryMutex);
+        auto it = s_registry.find(transferId);
+        if (it == s_registry.end()) return;
+        p = std::move(it->second);
+        s_registry.erase(it);
+    }
+    p->m_abort = true;
+}
+
+ChunkPipeline::ChunkPipeline(const std::string& transferId, const std::vector<uint8_t>& key, TransferSource source, bool wholeBlob)
+    : m_transferId(transferId), m_key(key), m_source(std::move(source)), m_wholeBlob(wholeBlob) {
+}
+
+ChunkPipeline::~ChunkPipeline() {
+    // Run() joins the stages before it returns; this only covers a pipeline
+    // torn down while its job is still unwinding
+    m_abort = true;
+    for (auto& t : m_threads) {
+        if (t.joinable()) t.join();
+    }
+}
+
+std::vector<ChunkPipeline::Entry> ChunkPipeline::EntriesFrom(size_t from, bool& complete, bool& failed) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    complete = m_done && !m_failed;
+    failed = m_failed;
+    if (from >= m_entries.size()) return {};
+    return std::vector<Entry>(m_entries.begin() + from, m_entries.end());
+}
+
+void ChunkPipeline::AddRelayCopy(RelayCopy copy) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_relayCopies.push_back(std::move(copy));
+}
+
+std::vector<ChunkPipeline::RelayCopy> ChunkPipeline::RelayCopiesFrom(size_t from) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (from >= m_relayCopies.size()) return {};
+    return std::vector<RelayCopy>(m_relayCopies.begin() + from, m_relayCopies.end());
+}
+
+void ChunkPipeline::NoteLanTaken(size_t count) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lanTaken = std::max(m_lanTaken, count);
+}
+
+size_t ChunkPipeline::LanTaken() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lanTaken;
+}
+
+// Released, failed, or the scheduler cancelled the job running it
+bool ChunkPipeline::Aborted() const {
+    return m_abort || (m_cancelled && *m_cancelled);
+}
+
+void ChunkPipeline::Fail(const char* what) {
+    LOG_ERROR("Pipeline %s: %s", m_transferId.c_str(), what);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_failed = true;
+    }
+    m_abort = true;
+}
+
+void ChunkPipeline::RunChunk() {
+    const uint8_t* data = m_source.data;
+    size_t size = m_source.size;
+    size_t offset = 0;
+
+    while (offset < size && !Aborted()) {
+        auto t0 = std::chrono::steady_clock::now();
+        Chunker::Span span{ offset, Chunker::NextCut(data + offset, size - offset) };
+        offset += span.length;
+        m_busy[kChunkStage] += std::chrono::steady_clock::now() - t0;
+
+        if (!PushWait(m_spans, span, [this] { return Aborted(); })) break;
+    }
+    m_spans.Close();
+}
+
+void ChunkPipeline::RunSeal() {
+    auto& store = ChunkStore::Instance();
+    Chunker::Span span;
+
+    while (PopWait(m_spans, span, [this] { return Aborted(); })) {
+        auto t0 = std::chrono::steady_clock::now();
+        const uint8_t* p = m_source.data + span.offset;
+
+        Sealed sealed;
+        sealed.id = ChunkStore::MakeId(m_key, p, span.length);
+        sealed.offset = span.offset;
+        sealed.size = span.length;
+        if (sealed.id.empty()) {
+            Fail("chunk ID derivation failed");
+            break;
+        }
+        if (!store.Has(sealed.id)) {
+            auto enc = Crypto::Encrypt(m_key, p, span.length);
+            if (!enc) {
+                Fail("chunk encryption failed");
+                break;
+            }
+            sealed.encrypted = std::move(*enc);
+        }
+        m_busy[kSealStage] += std::chrono::steady_clock::now() - t0;
+
+        if (!PushWait(m_sealed, sealed, [this] { return Aborted(); })) break;
+    }
+    m_sealed.Close();
+}
+
+void ChunkPipeline::RunPublish() {
+    auto& store = ChunkStore::Instance();
+    std::unique_ptr<BlobStore::Writer> blob;
+    if (m_wholeBlob) {
+        blob = BlobStore::Instance().Create(m_key);
+        if (!blob) LOG_WARNING("Pipeline %s: cannot write whole-file blob", m_transferId.c_str());
+    }
+
+    size_t published = 0;
+    Sealed sealed;
+    while (PopWait(m_sealed, sealed, [this] { return Aborted(); })) {
+        auto t0 = std::chrono::steady_clock::now();
+        if (!sealed.encrypted.empty()) {
+            if (!store.Put(sealed.id, sealed.encrypted)) {
+                Fail("chunk store write failed");
+                break;
+            }
+            m_newChunks++;
+        }
+        if (blob && !blob->Write(m_source.data + sealed.offset, sealed.size)) {
+            LOG_WARNING("Pipeline %s: whole-file blob write failed", m_transferId.c_str());
+            blob.reset();
+        }
+        published += sealed.size;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_entries.push_back({ std::move(sealed.id), sealed.size });
+        }
+        m_busy[kPublishStage] += std::chrono::steady_clock::now() - t0;
+    }
+
+    bool ok = !Aborted() && published == m_source.size;
+    std::string blobId;
+    if (ok && blob) {
+        if (auto committed = blob->Commit()) blobId = committed->id;
+    }
+    Finish(ok, blobId);
+}
+
+void ChunkPipeline::Finish(bool ok, const std::string& blobId) {
+    // Chunk and seal stages have closed their queues by now; join them so
+    // their busy counters are safe to read
+    for (auto& t : m_threads) {
+        if (t.joinable()) t.join();
+    }
+
+    auto wall = std::chrono::steady_clock::now() - m_started;
+    auto pct = [&](Stage s) {
+        return wall.count() > 0 ? (int)(100 * m_busy[s].count() / wall.count()) : 0;
+    };
+    size_t chunks;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!ok) m_failed = true;
+        m_done = true;
+        chunks = m_entries.size();
+    }
+
+    LOG_INFO("Pipeline %s %s: %zu chunks (%zu new), %zu KB in %lld ms; busy chunk %d%%, seal %d%%, publish %d%%",
+        m_transferId.c_str(), ok ? "done" : "aborted", chunks, m_newChunks, m_source.size / 1024,
+        (long long)std::chrono::duration_cast<std::chrono::milliseconds>(wall).count(),
+        pct(kChunkStage), pct(kSealStage), pct(kPublishStage));
+
+    if (m_onDone) m_onDone(ok, blobId);
+    else if (!blobId.empty()) BlobStore::Instance().Release(blobId);
+}
+
+}
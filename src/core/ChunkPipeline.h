@@ -0,0 +1,132 @@
+#pragma once
+#include "Chunker.h"
+#include "SpscQueue.h"
+#include "BlobStore.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <cstdint>
+
+namespace ClipboardPush {
+
+// Plaintext of an outgoing transfer. `owner` keeps `data` valid (mapped
+// file, heap buffer) for as long as a pipeline stage or a relay upload
+// still needs it.
+struct TransferSource {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    std::shared_ptr<const void> owner;
+};
+
+// Publishes a transfer as content-defined chunks while it is still being
+// read. Three threads connected by bounded SPSC queues:
+//   chunk   - cuts the source into spans
+//   seal    - derives chunk IDs and encrypts chunks the store lacks
+//   publish - stores chunks, extends the manifest, feeds the whole-file blob
+// Receivers poll the manifest (LocalServer /manifest/<transfer_id>) and pull
+// chunks as they appear, so the announcement can go out immediately.
+// Run() is the publish stage and starts the other two, so the scheduler job
+// that calls it holds its worker slot until every stage has finished; the
+// class limits bound pipelines, not just the jobs that launch them.
+class ChunkPipeline {
+public:
+    struct Entry {
+        std::string id;
+        size_t size;
+    };
+
+    // Bonded transfers: a run of manifest entries also uploaded to the relay
+    // as one segment (each chunk envelope prefixed with its u32 LE length)
+    struct RelayCopy {
+        size_t first;
+        size_t count;
+        std::string url;
+    };
+
+    // `blobId` is the whole-file blob, pinned for the callback's owner, or
+    // empty if none was requested or it could not be written
+    using DoneCallback = std::function<void(bool ok, const std::string& blobId)>;
+
+    // Registers the pipeline under `transferId`; nothing is published until
+    // Run(). With `wholeBlob`, the publish stage also encrypts the source
+    // into a BlobStore blob for peers that pull the whole file and for the
+    // relay. `onDone` runs at the end of Run() once every stage has finished.
+    static std::shared_ptr<ChunkPipeline> Create(const std::string& transferId, const std::vector<uint8_t>& key,
+        TransferSource source, bool wholeBlob, DoneCallback onDone = nullptr);
+    static std::shared_ptr<ChunkPipeline> Find(const std::string& transferId);
+    static void Release(const std::string& transferId);
+
+    ~ChunkPipeline();
+
+    // Runs the chunk and seal stages on their own threads and publishes on
+    // the calling one; returns once all three are done, `cancelled` is set
+    // or the pipeline is released
+    void Run(const std::atomic<bool>& cancelled);
+
+    // Manifest entries published so far, starting at index `from`
+    std::vector<Entry> EntriesFrom(size_t from, bool& complete, bool& failed) const;
+
+    void AddRelayCopy(RelayCopy copy);
+    std::vector<RelayCopy> RelayCopiesFrom(size_t from) const;
+
+    // Receivers report how far their LAN puller has got so relay segments
+    // are only cut from the part of the manifest it hasn't reached
+    void NoteLanTaken(size_t count);
+    size_t LanTaken() const;
+
+private:
+    struct Sealed {
+        std::string id;
+        size_t offset = 0;
+        size_t size = 0;
+        std::vector<uint8_t> encrypted; // empty if the store already has it
+    };
+
+    enum Stage { kChunkStage, kSealStage, kPublishStage, kStageCount };
+
+    ChunkPipeline(const std::string& transferId, const std::vector<uint8_t>& key, TransferSource source, bool wholeBlob);
+
+    void RunChunk();
+    void RunSeal();
+    void RunPublish();
+    bool Aborted() const;
+    void Fail(const char* what);
+    void Finish(bool ok, const std::string& blobId);
+
+    std::string m_transferId;
+    std::vector<uint8_t> m_key;
+    TransferSource m_source;
+    bool m_wholeBlob;
+    DoneCallback m_onDone;
+
+    SpscQueue<Chunker::Span> m_spans{ 64 };
+    SpscQueue<Sealed> m_sealed{ 16 };
+    std::atomic<bool> m_abort{ false };
+    const std::atomic<bool>* m_cancelled = nullptr; // the running job's flag
+
+    mutable std::mutex m_mutex;
+    std::vector<Entry> m_entries;
+    bool m_done = false;
+    bool m_failed = false;
+    std::vector<RelayCopy> m_relayCopies;
+    size_t m_lanTaken = 0;
+
+    // Time each stage spent working (not waiting on a queue), for utilisation stats
+    std::chrono::steady_clock::duration m_busy[kStageCount] = {};
+    std::chrono::steady_clock::time_point m_started;
+    size_t m_newChunks = 0;
+
+    std::thread m_threads[kPublishStage]; // chunk and seal; publish runs in Run()
+
+    static std::mutex s_registryMutex;
+    static std::map<std::string, std::shared_ptr<ChunkPipeline>> s_registry;
+};
+
+}
@@ -0,0 +1,208 @@
+#include "ChunkStore.h"
+#include "Crypto.h"
+#include "Logger.h"
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+
+namespace fs = std::filesystem;
+
+namespace ClipboardPush {
+
+static const size_t kChunkIdBytes = 16;
+
+ChunkStore& ChunkStore::Instance() {
+    static ChunkStore instance;
+    return instance;
+}
+
+void ChunkStore::Init(const fs::path& dir, uint64_t budgetBytes) {
+    std::error_code ec;
+    fs::create_directories(dir, ec);
+
+    struct Found { std::string id; uint64_t size; fs::file_time_type mtime; };
+    std::vector<Found> found;
+    for (const auto& entry : fs::directory_iterator(dir, ec)) {
+        std::string name = entry.path().filename().string();
+        if (!entry.is_regular_file(ec) || !IsValidId(name)) {
+            fs::remove(entry.path(), ec);
+            continue;
+        }
+        found.push_back({ name, (uint64_t)entry.file_size(ec), entry.last_write_time(ec) });
+    }
+
+    // Last write time doubles as last use across runs
+    std::sort(found.begin(), found.end(), [](const Found& a, const Found& b) { return a.mtime > b.mtime; });
+
+    std::vector<std::string> victims;
+    size_t count;
+    uint64_t total;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_dir = dir;
+        m_budget = budgetBytes;
+        m_total = 0;
+        m_entries.clear();
+        m_lru.clear();
+        for (const auto& f : found) {
+            m_lru.push_back(f.id);
+            m_entries[f.id] = { f.size, std::prev(m_lru.end()) };
+            m_total += f.size;
+        }
+        victims = EvictLocked();
+        count = m_entries.size();
+        total = m_total;
+    }
+    RemoveFiles(dir, victims);
+    LOG_INFO("Chunk store: %zu chunks, %llu KB cached", count, (unsigned long long)(total / 1024));
+}
+
+bool ChunkStore::Has(const std::string& id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.count(id) > 0;
+}
+
+bool ChunkStore::Put(const std::string& id, const std::vector<uint8_t>& encrypted) {
+    if (!IsValidId(id)) return false;
+    fs::path dir;
+    bool cached = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_dir.empty()) return false;
+        dir = m_dir;
+        auto it = m_entries.find(id);
+        if (it != m_entries.end()) {
+            TouchLocked(it);
+            cached = true;
+        }
+    }
+    if (cached) {
+        TouchFile(id, dir);
+        return true;
+    }
+
+    // Written outside the lock under a temp name unique to this call, so a
+    // crash never leaves a truncated chunk behind and two threads storing
+    // the same chunk don't interleave
+    static std::atomic<uint64_t> s_tempSeq{ 0 };
+    fs::path tmpPath = dir / (id + "." + std::to_string(++s_tempSeq) + ".part");
+    {
+        std::ofstream ofs(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) return false;
+        ofs.write((const char*)encrypted.data(), encrypted.size());
+        if (!ofs) return false;
+    }
+    std::error_code ec;
+    fs::rename(tmpPath, dir / id, ec);
+    if (ec) {
+        fs::remove(tmpPath, ec);
+        return false;
+    }
+
+    std::vector<std::string> victims;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(id);
+        if (it != m_entries.end()) {
+            TouchLocked(it);
+        }
+        else {
+            m_lru.push_front(id);
+            m_entries[id] = { (uint64_t)encrypted.size(), m_lru.begin() };
+            m_total += encrypted.size();
+            victims = EvictLocked();
+        }
+    }
+    RemoveFiles(dir, victims);
+    return true;
+}
+
+std::optional<std::vector<uint8_t>> ChunkStore::Get(const std::string& id) {
+    fs::path dir;
+    size_t size = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(id);
+        if (it == m_entries.end()) return std::nullopt;
+        TouchLocked(it);
+        dir = m_dir;
+        size = (size_t)it->second.size;
+    }
+
+    std::vector<uint8_t> data(size);
+    bool ok = false;
+    {
+        std::ifstream ifs(dir / id, std::ios::binary);
+        if (ifs.is_open()) {
+            ifs.read((char*)data.data(), data.size());
+            ok = (size_t)ifs.gcount() == data.size();
+        }
+    }
+    if (!ok) {
+        // Evicted (or deleted behind our back) since the lookup: forget it,
+        // so the next Has() sends the peer to fetch it again
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_entries.find(id);
+        if (it != m_entries.end() && it->second.size == size && dir == m_dir) {
+            m_total -= it->second.size;
+            m_lru.erase(it->second.lru);
+            m_entries.erase(it);
+        }
+        return std::nullopt;
+    }
+
+    TouchFile(id, dir);
+    return data;
+}
+
+void ChunkStore::TouchLocked(std::map<std::string, Entry>::iterator it) {
+    m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+}
+
+void ChunkStore::TouchFile(const std::string& id, const fs::path& dir) {
+    std::error_code ec;
+    fs::last_write_time(dir / id, fs::file_time_type::clock::now(), ec);
+}
+
+std::vector<std::string> ChunkStore::EvictLocked() {
+    std::vector<std::string> victims;
+    while (m_total > m_budget && !m_lru.empty()) {
+        auto it = m_entries.find(m_lru.back());
+        if (it != m_entries.end()) {
+            m_total -= it->second.size;
+            m_entries.erase(it);
+        }
+        victims.push_back(std::move(m_lru.back()));
+        m_lru.pop_back();
+    }
+    return victims;
+}
+
+void ChunkStore::RemoveFiles(const fs::path& dir, const std::vector<std::string>& ids) {
+    std::error_code ec;
+    for (const auto& id : ids) {
+        // Re-stored since it was evicted: the new copy is indexed, keep it
+        if (Has(id)) continue;
+        fs::remove(dir / id, ec);
+    }
+}
+
+std::string ChunkStore::MakeId(const std::vector<uint8_t>& key, const uint8_t* data, size_t len) {
+    auto mac = Crypto::HmacSha256(key, data, len);
+    if (mac.size() < kChunkIdBytes) return "";
+    static const char digits[] = "0123456789abcdef";
+    std::string id;
+    id.reserve(kChunkIdBytes * 2);
+    for (size_t i = 0; i < kChunkIdBytes; ++i) {
+        id.push_back(digits[mac[i] >> 4]);
+        id.push_back(digits[mac[i] & 0xF]);
+    }
+    return id;
+}
+
+bool ChunkStore::IsValidId(const std::string& id) {
+    if (id.size() != kChunkIdBytes * 2) return false;
+    return std::all_of(id.begin(), id.end(), [](char c) { return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'); });
+}
+
+}
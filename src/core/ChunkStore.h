@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <filesystem>
+#include <cstdint>
+
+namespace ClipboardPush {
+
+// Bounded on-disk cache of encrypted content-defined chunks, keyed by a
+// room-keyed chunk ID. Shared by the sender (to serve chunks over LAN) and
+// the receiver (to skip chunks it already holds). Least recently used
+// chunks are evicted once the byte budget is exceeded.
+class ChunkStore {
+public:
+    static ChunkStore& Instance();
+
+    // Indexes chunks left over from previous runs, oldest first
+    void Init(const std::filesystem::path& dir, uint64_t budgetBytes);
+
+    bool Has(const std::string& id);
+    bool Put(const std::string& id, const std::vector<uint8_t>& encrypted);
+    std::optional<std::vector<uint8_t>> Get(const std::string& id);
+
+    // 128-bit truncated HMAC-SHA256 of the plaintext chunk, hex encoded
+    static std::string MakeId(const std::vector<uint8_t>& key, const uint8_t* data, size_t len);
+    static bool IsValidId(const std::string& id);
+
+private:
+    ChunkStore() = default;
+
+    struct Entry {
+        uint64_t size;
+        std::list<std::string>::iterator lru;
+    };
+
+    // m_mutex guards the index only; chunk files are read, written, touched
+    // and deleted outside it
+    void TouchLocked(std::map<std::string, Entry>::iterator it);
+    static void TouchFile(const std::string& id, const std::filesystem::path& dir);
+    // Drops least recently used entries over budget; returns their IDs for
+    // RemoveFiles once the lock is released
+    std::vector<std::string> EvictLocked();
+    void RemoveFiles(const std::filesystem::path& dir, const std::vector<std::string>& ids);
+
+    std::mutex m_mutex;
+    std::filesystem::path m_dir;
+    uint64_t m_budget = 0;
+    uint64_t m_total = 0;
+    std::map<std::string, Entry> m_entries;
+    std::list<std::string> m_lru; // front = most recently used
+};
+
+}
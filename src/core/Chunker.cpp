@@ -0,0 +1,82 @@
+#include "Chunker.h"
+#include <array>
+
+namespace ClipboardPush {
+namespace Chunker {
+
+// Gear table: fixed pseudo-random values, identical on every peer
+static const std::array<uint64_t, 256>& GearTable() {
+    static const std::array<uint64_t, 256> table = []() {
+        std::array<uint64_t, 256> t{};
+        uint64_t state = 0x436C697050757368ULL; // "ClipPush"
+        for (auto& v : t) {
+            // splitmix64
+            state += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = state;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            v = z ^ (z >> 31);
+        }
+        return t;
+    }();
+    return table;
+}
+
+static int Log2(size_t v) {
+    int bits = 0;
+    while (v > 1) { v >>= 1; ++bits; }
+    return bits;
+}
+
+// The rolling fingerprint shifts left, so its high bits cover the widest
+// window of input bytes; masks are therefore taken from the top.
+static uint64_t TopMask(int bits) {
+    if (bits <= 0) return 0;
+    if (bits >= 64) return ~0ULL;
+    return ((1ULL << bits) - 1) << (64 - bits);
+}
+
+static size_t Cut(const uint8_t* src, size_t n, const Params& p, uint64_t maskS, uint64_t maskL) {
+    if (n <= p.min_size) return n;
+    if (n > p.max_size) n = p.max_size;
+    size_t normal = p.avg_size < n ? p.avg_size : n;
+
+    const auto& gear = GearTable();
+    uint64_t fp = 0;
+    size_t i = p.min_size;
+    // Stricter mask before the average size, looser after it
+    for (; i < normal; ++i) {
+        fp = (fp << 1) + gear[src[i]];
+        if (!(fp & maskS)) return i + 1;
+    }
+    for (; i < n; ++i) {
+        fp = (fp << 1) + gear[src[i]];
+        if (!(fp & maskL)) return i + 1;
+    }
+    return n;
+}
+
+size_t NextCut(const uint8_t* data, size_t size, const Params& params) {
+    int bits = Log2(params.avg_size);
+    return Cut(data, size, params, TopMask(bits + 2), TopMask(bits - 2));
+}
+
+std::vector<Span> Split(const uint8_t* data, size_t size, const Params& params) {
+    std::vector<Span> spans;
+    if (size == 0) return spans;
+
+    int bits = Log2(params.avg_size);
+    uint64_t maskS = TopMask(bits + 2);
+    uint64_t maskL = TopMask(bits - 2);
+
+    size_t offset = 0;
+    while (offset < size) {
+        size_t len = Cut(data + offset, size - offset, params, maskS, maskL);
+        spans.push_back({ offset, len });
+        offset += len;
+    }
+    return spans;
+}
+
+}
+}
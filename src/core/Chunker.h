@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace ClipboardPush {
+namespace Chunker {
+
+// FastCDC-style content-defined chunking with normalized chunk sizes.
+// Boundaries depend only on nearby content, so an edit in one place only
+// changes the chunks around it.
+struct Params {
+    size_t min_size = 16 * 1024;
+    size_t avg_size = 64 * 1024;   // must be a power of two
+    size_t max_size = 256 * 1024;
+};
+
+struct Span {
+    size_t offset;
+    size_t length;
+};
+
+// Length of the chunk starting at `data`; lets callers cut incrementally
+size_t NextCut(const uint8_t* data, size_t size, const Params& params = Params());
+
+std::vector<Span> Split(const uint8_t* data, size_t size, const Params& params = Params());
+
+}
+}
@@ -4,6 +4,7 @@
 #include "Crypto.h"
 #include <fstream>
 #include <filesystem>
+#include <vector>
 #include <shlobj.h>
 #include <lmcons.h>
 
@@ -24,49 +25,89 @@ std::string Config::GetConfigPath() {
     return m_configPath;
 }
 
+void Config::Update(const std::function<void(ConfigData&)>& edit) {
+    Snapshot before, after;
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        before = Get();
+        auto draft = std::make_shared<ConfigData>(*before);
+        edit(*draft);
+        after = draft;
+        std::atomic_store_explicit(&m_current, after, std::memory_order_release);
+    }
+
+    std::vector<Listener> listeners;
+    {
+        std::lock_guard<std::mutex> lock(m_listenerMutex);
+        for (const auto& kv : m_listeners) listeners.push_back(kv.second);
+    }
+    for (const auto& listener : listeners) listener(*before, *after);
+}
+
+int Config::Subscribe(Listener listener) {
+    std::lock_guard<std::mutex> lock(m_listenerMutex);
+    int id = m_nextListener++;
+    m_listeners[id] = std::move(listener);
+    return id;
+}
+
+void Config::Unsubscribe(int id) {
+    std::lock_guard<std::mutex> lock(m_listenerMutex);
+    m_listeners.erase(id);
+}
+
+static std::string CurrentUserName() {
+    wchar_t buffer[UNLEN + 1];
+    DWORD size = UNLEN + 1;
+    std::wstring username = L"user";
+    if (GetUserNameW(buffer, &size)) {
+        username = buffer;
+    }
+    return Utils::ToUtf8(username);
+}
+
 void Config::InitializeDefaults() {
     // Downloads Path
-    if (m_data.download_path.empty()) {
+    std::string downloadPath;
+    if (Get()->download_path.empty()) {
         PWSTR path = NULL;
         if (SUCCEEDED(SHGetKnownFolderPath(FOLDERID_Downloads, 0, NULL, &path))) {
             std::filesystem::path downloadDir(path);
-            m_data.download_path = (downloadDir / "ClipboardMan").string();
+            downloadPath = (downloadDir / "ClipboardMan").string();
             CoTaskMemFree(path);
         }
     }
-    
-    // Device ID
-    if (m_data.device_id.empty()) {
-        wchar_t buffer[UNLEN + 1];
-        DWORD size = UNLEN + 1;
-        std::wstring username = L"user";
-        if (GetUserNameW(buffer, &size)) {
-            username = buffer;
-        }
-        m_data.device_id = "pc_" + Utils::ToUtf8(username) + "_win32";
-    }
+    std::string user = CurrentUserName();
+
+    Update([&](ConfigData& d) {
+        if (d.download_path.empty()) d.download_path = downloadPath;
+        // Device ID
+        if (d.device_id.empty()) d.device_id = "pc_" + user + "_win32";
+    });
 
     // Generate room credentials if not already present
-    if (m_data.room_id.empty() || m_data.room_key.empty()) {
+    auto data = Get();
+    if (data->room_id.empty() || data->room_key.empty()) {
         GenerateNewCredentials();
     }
 }
 
 void Config::GenerateNewCredentials() {
-    m_data.room_id = "room_" + std::to_string(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
-    m_data.room_key = Crypto::GenerateKeyBase64();
+    std::string roomId = "room_" + std::to_string(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+    std::string roomKey = Crypto::GenerateKeyBase64();
     // Also regenerate device ID to ensure clean slate
-    wchar_t buffer[UNLEN + 1];
-    DWORD size = UNLEN + 1;
-    std::wstring username = L"user";
-    if (GetUserNameW(buffer, &size)) username = buffer;
-    
     auto now = std::chrono::system_clock::now();
     auto seconds = std::chrono::duration_cast<std::chrono::seconds>(now.time_since_epoch()).count();
-    m_data.device_id = "pc_" + Utils::ToUtf8(username) + "_" + std::to_string(seconds % 10000);
+    std::string deviceId = "pc_" + CurrentUserName() + "_" + std::to_string(seconds % 10000);
+
+    Update([&](ConfigData& d) {
+        d.room_id = roomId;
+        d.room_key = roomKey;
+        d.device_id = deviceId;
+    });
     
     Save();
-    LOG_INFO("Credentials reset. New Room: %s", m_data.room_id.c_str());
+    LOG_INFO("Credentials reset. New Room: %s", roomId.c_str());
 }
 
 bool Config::Load() {
@@ -74,37 +115,53 @@ bool Config::Load() {
     std::ifstream file(path);
     if (!file.is_open()) {
         InitializeDefaults();
-        return Save(); // Create new
+        Save(); // Create new
+        return true;
     }
     
     try {
         nlohmann::json j;
         file >> j;
         
-        m_data.relay_server_url = j.value("relay_server_url", m_data.relay_server_url);
-        m_data.download_path = j.value("download_path", m_data.download_path);
-        m_data.device_id = j.value("device_id", m_data.device_id);
-        m_data.room_id = j.value("room_id", m_data.room_id);
-        m_data.room_key = j.value("room_key", m_data.room_key);
-        m_data.push_hotkey = j.value("push_hotkey", m_data.push_hotkey);
-        m_data.auto_copy_image = j.value("auto_copy_image", m_data.auto_copy_image);
-        m_data.auto_copy_file = j.value("auto_copy_file", m_data.auto_copy_file);
-        m_data.auto_push_text = j.value("auto_push_text", false);
-        m_data.auto_push_image = j.value("auto_push_image", false);
-        m_data.auto_push_file = j.value("auto_push_file", false);
-        m_data.auto_start = j.value("auto_start", m_data.auto_start);
-        m_data.start_minimized = j.value("start_minimized", m_data.start_minimized);
-        m_data.show_notifications = j.value("show_notifications", true);
+        ConfigData data = *Get();
+        data.relay_server_url = j.value("relay_server_url", data.relay_server_url);
+        data.download_path = j.value("download_path", data.download_path);
+        data.device_id = j.value("device_id", data.device_id);
+        data.room_id = j.value("room_id", data.room_id);
+        data.room_key = j.value("room_key", data.room_key);
+        data.push_hotkey = j.value("push_hotkey", data.push_hotkey);
+        data.auto_copy_image = j.value("auto_copy_image", data.auto_copy_image);
+        data.auto_copy_file = j.value("auto_copy_file", data.auto_copy_file);
+        data.auto_push_text = j.value("auto_push_text", false);
+        data.auto_push_image = j.value("auto_push_image", false);
+        data.auto_push_file = j.value("auto_push_file", false);
+        data.auto_start = j.value("auto_start", data.auto_start);
+        data.start_minimized = j.value("start_minimized", data.start_minimized);
+        data.show_notifications = j.value("show_notifications", true);
+        data.text_delta_sync = j.value("text_delta_sync", data.text_delta_sync);
+        data.large_text_threshold_kb = j.value("large_text_threshold_kb", data.large_text_threshold_kb);
+        data.chunk_cache_mb = j.value("chunk_cache_mb", data.chunk_cache_mb);
+        data.blob_cache_mb = j.value("blob_cache_mb", data.blob_cache_mb);
+        data.max_upload_mb = j.value("max_upload_mb", data.max_upload_mb);
+        data.auto_push_debounce_ms = j.value("auto_push_debounce_ms", data.auto_push_debounce_ms);
+        data.auto_push_max_delay_ms = j.value("auto_push_max_delay_ms", data.auto_push_max_delay_ms);
+        data.relay_race = j.value("relay_race", data.relay_race);
+        data.bonded_transfer = j.value("bonded_transfer", data.bonded_transfer);
+        data.lan_discovery = j.value("lan_discovery", data.lan_discovery);
+        data.lan_direct_push = j.value("lan_direct_push", data.lan_direct_push);
+        data.udp_transport = j.value("udp_transport", data.udp_transport);
         
         // Generate credentials if missing
-        if (m_data.room_id.empty() || m_data.room_key.empty()) {
+        bool missingCredentials = data.room_id.empty() || data.room_key.empty();
+        if (missingCredentials) {
             LOG_INFO("Credentials missing, generating new room...");
-            if (m_data.room_id.empty()) m_data.room_id = "room_" + std::to_string(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
-            if (m_data.room_key.empty()) m_data.room_key = Crypto::GenerateKeyBase64();
-            Save();
+            if (data.room_id.empty()) data.room_id = "room_" + std::to_string(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now()));
+            if (data.room_key.empty()) data.room_key = Crypto::GenerateKeyBase64();
         }
+        Update([&](ConfigData& d) { d = data; });
+        if (missingCredentials) Save();
 
-        if (m_data.device_id.empty()) InitializeDefaults();
+        if (data.device_id.empty()) InitializeDefaults();
         
         LOG_INFO("Config loaded from %s", path.c_str());
         return true;
@@ -114,31 +171,101 @@ bool Config::Load() {
     }
 }
 
-bool Config::Save() {
-    std::string path = GetConfigPath();
+void Config::Save() {
+    {
+        std::lock_guard<std::mutex> lock(m_persistMutex);
+        if (!m_persistStopped) {
+            if (!m_persistThread.joinable()) m_persistThread = std::thread(&Config::PersistLoop, this);
+            m_saveDebouncer.Signal(Debouncer::Clock::now());
+            m_persistCv.notify_all();
+            return;
+        }
+    }
+    // Past shutdown there is no writer left to hand this to
+    Persist(*Get());
+}
+
+void Config::Flush() {
+    bool pending;
+    {
+        std::lock_guard<std::mutex> lock(m_persistMutex);
+        if (m_persistStopped) return;
+        m_persistStopped = true;
+        pending = m_saveDebouncer.Pending();
+        m_saveDebouncer.Cancel();
+    }
+    m_persistCv.notify_all();
+    if (m_persistThread.joinable()) m_persistThread.join();
+    if (pending) Persist(*Get());
+}
+
+void Config::PersistLoop() {
+    std::unique_lock<std::mutex> lock(m_persistMutex);
+    while (!m_persistStopped) {
+        Debouncer::Duration wait;
+        if (!m_saveDebouncer.Poll(Debouncer::Clock::now(), wait)) {
+            if (m_saveDebouncer.Pending()) m_persistCv.wait_for(lock, wait);
+            else m_persistCv.wait(lock);
+            continue;
+        }
+        // Whatever is current by now, so a burst of edits costs one write
+        lock.unlock();
+        Persist(*Get());
+        lock.lock();
+    }
+}
+
+bool Config::Persist(const ConfigData& data) {
     nlohmann::json j;
-    j["relay_server_url"] = m_data.relay_server_url;
-    j["download_path"] = m_data.download_path;
-    j["device_id"] = m_data.device_id;
-    j["room_id"] = m_data.room_id;
-    j["room_key"] = m_data.room_key;
-    j["push_hotkey"] = m_data.push_hotkey;
-    j["auto_copy_image"] = m_data.auto_copy_image;
-    j["auto_copy_file"] = m_data.auto_copy_file;
-    j["auto_push_text"] = m_data.auto_push_text;
-    j["auto_push_image"] = m_data.auto_push_image;
-    j["auto_push_file"] = m_data.auto_push_file;
-    j["auto_start"] = m_data.auto_start;
-    j["start_minimized"] = m_data.start_minimized;
-    j["show_notifications"] = m_data.show_notifications;
-    j["lan_timeout"] = m_data.lan_timeout;
+    j["relay_server_url"] = data.relay_server_url;
+    j["download_path"] = data.download_path;
+    j["device_id"] = data.device_id;
+    j["room_id"] = data.room_id;
+    j["room_key"] = data.room_key;
+    j["push_hotkey"] = data.push_hotkey;
+    j["auto_copy_image"] = data.auto_copy_image;
+    j["auto_copy_file"] = data.auto_copy_file;
+    j["auto_push_text"] = data.auto_push_text;
+    j["auto_push_image"] = data.auto_push_image;
+    j["auto_push_file"] = data.auto_push_file;
+    j["auto_start"] = data.auto_start;
+    j["start_minimized"] = data.start_minimized;
+    j["show_notifications"] = data.show_notifications;
+    j["lan_timeout"] = data.lan_timeout;
+    j["text_delta_sync"] = data.text_delta_sync;
+    j["large_text_threshold_kb"] = data.large_text_threshold_kb;
+    j["chunk_cache_mb"] = data.chunk_cache_mb;
+    j["blob_cache_mb"] = data.blob_cache_mb;
+    j["max_upload_mb"] = data.max_upload_mb;
+    j["auto_push_debounce_ms"] = data.auto_push_debounce_ms;
+    j["auto_push_max_delay_ms"] = data.auto_push_max_delay_ms;
+    j["relay_race"] = data.relay_race;
+    j["bonded_transfer"] = data.bonded_transfer;
+    j["lan_discovery"] = data.lan_discovery;
+    j["lan_direct_push"] = data.lan_direct_push;
+    j["udp_transport"] = data.udp_transport;
     
-    std::ofstream file(path);
-    if (file.is_open()) {
-        file << j.dump(4);
-        return true;
+    std::string body = j.dump(4);
+    std::filesystem::path target(GetConfigPath());
+    std::filesystem::path temp = target;
+    temp += ".tmp";
+
+    HANDLE file = CreateFileW(temp.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        LOG_ERROR("Failed to save config: cannot create %s", temp.string().c_str());
+        return false;
+    }
+    DWORD written = 0;
+    bool ok = ::WriteFile(file, body.data(), (DWORD)body.size(), &written, NULL) && written == body.size();
+    // On disk before the rename makes it the real file
+    ok = ok && FlushFileBuffers(file);
+    CloseHandle(file);
+    if (ok) ok = MoveFileExW(temp.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+    if (!ok) {
+        LOG_ERROR("Failed to save config (error %lu)", GetLastError());
+        DeleteFileW(temp.c_str());
     }
-    return false;
+    return ok;
 }
 
 }
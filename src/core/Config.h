@@ -1,6 +1,13 @@
 #pragma once
 #include <string>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <functional>
+#include <thread>
+#include <condition_variable>
 #include <nlohmann/json.hpp>
+#include "Debouncer.h"
 
 namespace ClipboardPush {
 
@@ -20,16 +27,47 @@ struct ConfigData {
     bool start_minimized = false;
     bool show_notifications = true;
     int lan_timeout = 10;
+    bool text_delta_sync = false;
+    int large_text_threshold_kb = 256;
+    int chunk_cache_mb = 512;
+    int blob_cache_mb = 1024;
+    int max_upload_mb = 4096;
+    int auto_push_debounce_ms = 250;
+    int auto_push_max_delay_ms = 1000;
+    bool relay_race = false;
+    bool bonded_transfer = true;
+    bool lan_discovery = true;
+    bool lan_direct_push = true;
+    bool udp_transport = false;
 };
 
+// Settings are published as immutable snapshots (read-copy-update). Readers
+// take the current snapshot with one atomic load and never wait for a
+// writer; a writer copies the current settings, edits the copy and swaps it
+// in. A reader keeps whatever snapshot it took, so a transfer sees one
+// consistent set of settings from start to finish.
 class Config {
 public:
+    using Snapshot = std::shared_ptr<const ConfigData>;
+    // Runs on the writer's thread after a new snapshot is published
+    using Listener = std::function<void(const ConfigData& before, const ConfigData& after)>;
+
     static Config& Instance();
     
     bool Load();
-    bool Save();
+    // Schedules a write of the current snapshot. Changes made within a short
+    // window share one write, done on a background thread so the caller
+    // never waits on the disk.
+    void Save();
+    // Writes any pending change now and stops the writer; called at shutdown
+    void Flush();
     
-    ConfigData& Data() { return m_data; }
+    Snapshot Get() const { return std::atomic_load_explicit(&m_current, std::memory_order_acquire); }
+    // Writers are serialized; `edit` must not call back into Update
+    void Update(const std::function<void(ConfigData&)>& edit);
+
+    int Subscribe(Listener listener);
+    void Unsubscribe(int id);
     
     // Set default download path and device ID if empty
     void InitializeDefaults();
@@ -38,11 +76,27 @@ public:
     void GenerateNewCredentials();
 
 private:
-    Config() = default;
-    ConfigData m_data;
+    Config() : m_current(std::make_shared<const ConfigData>()) {}
+    ~Config() { Flush(); }
+
+    Snapshot m_current; // only through std::atomic_load/atomic_store
+    std::mutex m_writeMutex;
+    std::mutex m_listenerMutex;
+    std::map<int, Listener> m_listeners;
+    int m_nextListener = 1;
     std::string m_configPath;
     
     std::string GetConfigPath();
+
+    void PersistLoop();
+    // Replaces config.json in one step: a crash leaves the old file or the new one
+    bool Persist(const ConfigData& data);
+
+    std::mutex m_persistMutex;
+    std::condition_variable m_persistCv;
+    std::thread m_persistThread;
+    Debouncer m_saveDebouncer{ std::chrono::milliseconds(500), std::chrono::milliseconds(2000) };
+    bool m_persistStopped = false;
 };
 
 }
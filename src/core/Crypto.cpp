@@ -1,10 +1,13 @@
 #include "Crypto.h"
 #include "Logger.h"
+#include "Metrics.h"
 #include <windows.h>
 #include <bcrypt.h>
 #include <wincrypt.h>
 #include <random>
 #include <algorithm>
+#include <climits>
+#include <cstring>
 
 #ifndef NT_SUCCESS
 #define NT_SUCCESS(Status) (((NTSTATUS)(Status)) >= 0)
@@ -60,16 +63,323 @@ public:
     bool isValid() const { return valid; }
 };
 
+class HmacProvider {
+    BCRYPT_ALG_HANDLE hAlg = NULL;
+public:
+    HmacProvider() {
+        if (!NT_SUCCESS(BCryptOpenAlgorithmProvider(&hAlg, BCRYPT_SHA256_ALGORITHM, NULL, BCRYPT_ALG_HANDLE_HMAC_FLAG))) hAlg = NULL;
+    }
+    ~HmacProvider() { if (hAlg) BCryptCloseAlgorithmProvider(hAlg, 0); }
+    operator BCRYPT_ALG_HANDLE() const { return hAlg; }
+    bool isValid() const { return hAlg != NULL; }
+};
+
+std::vector<uint8_t> HmacSha256(const std::vector<uint8_t>& key, const uint8_t* data, size_t len) {
+    static HmacProvider prov;
+    if (!prov.isValid()) {
+        LOG_ERROR("BCrypt HMAC provider init failed");
+        return {};
+    }
+
+    BCRYPT_HASH_HANDLE hHash = NULL;
+    if (!NT_SUCCESS(BCryptCreateHash(prov, &hHash, NULL, 0, (PUCHAR)key.data(), (ULONG)key.size(), 0))) {
+        return {};
+    }
+
+    std::vector<uint8_t> mac(32);
+    bool ok = NT_SUCCESS(BCryptHashData(hHash, (PUCHAR)data, (ULONG)len, 0)) &&
+              NT_SUCCESS(BCryptFinishHash(hHash, mac.data(), (ULONG)mac.size(), 0));
+    BCryptDestroyHash(hHash);
+    if (!ok) return {};
+    return mac;
+}
+
+struct HmacSha256Stream::Impl {
+    BCRYPT_HASH_HANDLE hHash = NULL;
+};
+
+HmacSha256Stream::HmacSha256Stream(const std::vector<uint8_t>& key) : m_impl(new Impl) {
+    static HmacProvider prov;
+    if (!prov.isValid()) {
+        LOG_ERROR("BCrypt HMAC provider init failed");
+        return;
+    }
+    if (!NT_SUCCESS(BCryptCreateHash(prov, &m_impl->hHash, NULL, 0, (PUCHAR)key.data(), (ULONG)key.size(), 0))) {
+        m_impl->hHash = NULL;
+    }
+}
+
+HmacSha256Stream::~HmacSha256Stream() {
+    if (m_impl->hHash) BCryptDestroyHash(m_impl->hHash);
+}
+
+bool HmacSha256Stream::IsValid() const {
+    return m_impl->hHash != NULL;
+}
+
+bool HmacSha256Stream::Update(const uint8_t* data, size_t len) {
+    if (!m_impl->hHash) return false;
+    while (len > 0) {
+        ULONG n = (ULONG)std::min<size_t>(len, ULONG_MAX);
+        if (!NT_SUCCESS(BCryptHashData(m_impl->hHash, (PUCHAR)data, n, 0))) return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+std::vector<uint8_t> HmacSha256Stream::Finish() {
+    if (!m_impl->hHash) return {};
+    std::vector<uint8_t> mac(32);
+    bool ok = NT_SUCCESS(BCryptFinishHash(m_impl->hHash, mac.data(), (ULONG)mac.size(), 0));
+    BCryptDestroyHash(m_impl->hHash);
+    m_impl->hHash = NULL;
+    if (!ok) return {};
+    return mac;
+}
+
+// GCM with BCRYPT_AUTH_MODE_CHAIN_CALLS_FLAG: every call but the last must
+// be a whole number of blocks, and CNG keeps the running MAC in macContext
+struct GcmEncryptor::Impl {
+    BCRYPT_KEY_HANDLE hKey = NULL;
+    std::vector<uint8_t> keyObj;
+    uint8_t nonce[12] = {};
+    uint8_t tag[16] = {};
+    uint8_t macContext[16] = {};
+    uint8_t iv[16] = {};
+    uint8_t pending[16] = {};
+    size_t pendingLen = 0;
+    BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO authInfo;
+    bool finished = false;
+};
+
+GcmEncryptor::GcmEncryptor(const std::vector<uint8_t>& key) : m_impl(new Impl) {
+    static BCryptProvider prov;
+    if (!prov.isValid()) {
+        LOG_ERROR("BCrypt provider init failed");
+        return;
+    }
+    if (!NT_SUCCESS(BCryptGenRandom(NULL, m_impl->nonce, 12, BCRYPT_USE_SYSTEM_PREFERRED_RNG))) {
+        LOG_ERROR("Failed to generate random nonce");
+        return;
+    }
+
+    DWORD keyObjLen = 0;
+    DWORD res = 0;
+    BCryptGetProperty(prov, BCRYPT_OBJECT_LENGTH, (PUCHAR)&keyObjLen, sizeof(DWORD), &res, 0);
+    m_impl->keyObj.resize(keyObjLen);
+    if (!NT_SUCCESS(BCryptGenerateSymmetricKey(prov, &m_impl->hKey, m_impl->keyObj.data(), keyObjLen, (PUCHAR)key.data(), (ULONG)key.size(), 0))) {
+        LOG_ERROR("Failed to generate key");
+        m_impl->hKey = NULL;
+        return;
+    }
+
+    // The tag buffer stays set for every chained call, as CNG requires; the
+    // last call (chain flag cleared) writes the tag into it
+    BCRYPT_INIT_AUTH_MODE_INFO(m_impl->authInfo);
+    m_impl->authInfo.pbNonce = m_impl->nonce;
+    m_impl->authInfo.cbNonce = 12;
+    m_impl->authInfo.pbTag = m_impl->tag;
+    m_impl->authInfo.cbTag = 16;
+    m_impl->authInfo.pbMacContext = m_impl->macContext;
+    m_impl->authInfo.cbMacContext = 16;
+    m_impl->authInfo.dwFlags = BCRYPT_AUTH_MODE_CHAIN_CALLS_FLAG;
+}
+
+GcmEncryptor::~GcmEncryptor() {
+    if (m_impl->hKey) BCryptDestroyKey(m_impl->hKey);
+}
+
+bool GcmEncryptor::IsValid() const {
+    return m_impl->hKey != NULL;
+}
+
+const uint8_t* GcmEncryptor::Nonce() const {
+    return m_impl->nonce;
+}
+
+bool GcmEncryptor::Update(const uint8_t* data, size_t len, std::vector<uint8_t>& out) {
+    Impl& s = *m_impl;
+    if (!s.hKey || s.finished) return false;
+    Metrics::CryptoTimer timer(Metrics::EncryptBytes, Metrics::EncryptSeconds, len);
+
+    // Top up a held partial block first
+    if (s.pendingLen > 0) {
+        size_t take = std::min(len, 16 - s.pendingLen);
+        memcpy(s.pending + s.pendingLen, data, take);
+        s.pendingLen += take;
+        data += take;
+        len -= take;
+        if (s.pendingLen < 16) return true;
+
+        size_t at = out.size();
+        out.resize(at + 16);
+        ULONG done = 0;
+        if (!NT_SUCCESS(BCryptEncrypt(s.hKey, s.pending, 16, &s.authInfo, s.iv, 16, out.data() + at, 16, &done, 0))) return false;
+        s.pendingLen = 0;
+    }
+
+    // Whole blocks straight through, at most ULONG_MAX rounded down per call
+    size_t whole = len & ~(size_t)15;
+    while (whole > 0) {
+        ULONG n = (ULONG)std::min<size_t>(whole, (size_t)ULONG_MAX & ~(size_t)15);
+        size_t at = out.size();
+        out.resize(at + n);
+        ULONG done = 0;
+        if (!NT_SUCCESS(BCryptEncrypt(s.hKey, (PUCHAR)data, n, &s.authInfo, s.iv, 16, out.data() + at, n, &done, 0))) return false;
+        data += n;
+        len -= n;
+        whole -= n;
+    }
+
+    memcpy(s.pending, data, len);
+    s.pendingLen = len;
+    return true;
+}
+
+bool GcmEncryptor::Finish(std::vector<uint8_t>& out) {
+    Impl& s = *m_impl;
+    if (!s.hKey || s.finished) return false;
+    s.finished = true;
+
+    // The last call may be any length and produces the tag
+    s.authInfo.dwFlags &= ~BCRYPT_AUTH_MODE_CHAIN_CALLS_FLAG;
+    size_t at = out.size();
+    out.resize(at + s.pendingLen);
+    ULONG done = 0;
+    if (!NT_SUCCESS(BCryptEncrypt(s.hKey, s.pendingLen ? s.pending : NULL, (ULONG)s.pendingLen, &s.authInfo, s.iv, 16,
+        s.pendingLen ? out.data() + at : NULL, (ULONG)s.pendingLen, &done, 0))) {
+        LOG_ERROR("Encryption failed");
+        return false;
+    }
+    out.insert(out.end(), s.tag, s.tag + 16);
+    return true;
+}
+
+struct GcmDecryptor::Impl {
+    BCRYPT_KEY_HANDLE hKey = NULL;
+    std::vector<uint8_t> keyObj;
+    uint8_t nonce[12] = {};
+    size_t nonceLen = 0;
+    uint8_t tag[16] = {};          // filled from the envelope's tail by Finish
+    uint8_t macContext[16] = {};
+    uint8_t iv[16] = {};
+    std::vector<uint8_t> held;     // undecrypted bytes; always keeps the last 16 back as the tag
+    BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO authInfo;
+    bool finished = false;
+};
+
+GcmDecryptor::GcmDecryptor(const std::vector<uint8_t>& key) : m_impl(new Impl) {
+    static BCryptProvider prov;
+    if (!prov.isValid()) {
+        LOG_ERROR("BCrypt provider init failed");
+        return;
+    }
+
+    DWORD keyObjLen = 0;
+    DWORD res = 0;
+    BCryptGetProperty(prov, BCRYPT_OBJECT_LENGTH, (PUCHAR)&keyObjLen, sizeof(DWORD), &res, 0);
+    m_impl->keyObj.resize(keyObjLen);
+    if (!NT_SUCCESS(BCryptGenerateSymmetricKey(prov, &m_impl->hKey, m_impl->keyObj.data(), keyObjLen, (PUCHAR)key.data(), (ULONG)key.size(), 0))) {
+        m_impl->hKey = NULL;
+        return;
+    }
+
+    // CNG wants the tag buffer on every chained call, not just the last; it
+    // only reads it once the chain flag is cleared
+    BCRYPT_INIT_AUTH_MODE_INFO(m_impl->authInfo);
+    m_impl->authInfo.pbNonce = m_impl->nonce;
+    m_impl->authInfo.cbNonce = 12;
+    m_impl->authInfo.pbTag = m_impl->tag;
+    m_impl->authInfo.cbTag = 16;
+    m_impl->authInfo.pbMacContext = m_impl->macContext;
+    m_impl->authInfo.cbMacContext = 16;
+    m_impl->authInfo.dwFlags = BCRYPT_AUTH_MODE_CHAIN_CALLS_FLAG;
+}
+
+GcmDecryptor::~GcmDecryptor() {
+    if (m_impl->hKey) BCryptDestroyKey(m_impl->hKey);
+}
+
+bool GcmDecryptor::IsValid() const {
+    return m_impl->hKey != NULL;
+}
+
+bool GcmDecryptor::Update(const uint8_t* data, size_t len, std::vector<uint8_t>& out) {
+    Impl& s = *m_impl;
+    if (!s.hKey || s.finished) return false;
+    Metrics::CryptoTimer timer(Metrics::DecryptBytes, Metrics::DecryptSeconds, len);
+
+    if (s.nonceLen < 12) {
+        size_t take = std::min(len, 12 - s.nonceLen);
+        memcpy(s.nonce + s.nonceLen, data, take);
+        s.nonceLen += take;
+        data += take;
+        len -= take;
+    }
+    s.held.insert(s.held.end(), data, data + len);
+    if (s.held.size() <= 16) return true;
+
+    // Everything but the tag, in whole blocks
+    size_t ready = (s.held.size() - 16) & ~(size_t)15;
+    size_t pos = 0;
+    while (pos < ready) {
+        ULONG n = (ULONG)std::min<size_t>(ready - pos, (size_t)ULONG_MAX & ~(size_t)15);
+        size_t at = out.size();
+        out.resize(at + n);
+        ULONG done = 0;
+        if (!NT_SUCCESS(BCryptDecrypt(s.hKey, s.held.data() + pos, n, &s.authInfo, s.iv, 16, out.data() + at, n, &done, 0))) return false;
+        pos += n;
+    }
+    s.held.erase(s.held.begin(), s.held.begin() + ready);
+    return true;
+}
+
+bool GcmDecryptor::Finish(std::vector<uint8_t>& out) {
+    Impl& s = *m_impl;
+    if (!s.hKey || s.finished) return false;
+    s.finished = true;
+    if (s.nonceLen < 12 || s.held.size() < 16) return false;
+
+    size_t last = s.held.size() - 16;
+    memcpy(s.tag, s.held.data() + last, 16);
+    s.authInfo.dwFlags &= ~BCRYPT_AUTH_MODE_CHAIN_CALLS_FLAG;
+    size_t at = out.size();
+    out.resize(at + last);
+    ULONG done = 0;
+    if (!NT_SUCCESS(BCryptDecrypt(s.hKey, last ? s.held.data() : NULL, (ULONG)last, &s.authInfo, s.iv, 16,
+        last ? out.data() + at : NULL, (ULONG)last, &done, 0))) {
+        LOG_ERROR("Decryption failed");
+        out.resize(at);
+        return false;
+    }
+    return true;
+}
+
 std::optional<std::vector<uint8_t>> Encrypt(const std::vector<uint8_t>& key, const std::vector<uint8_t>& plaintext) {
+    return Encrypt(key, plaintext.data(), plaintext.size());
+}
+
+std::optional<std::vector<uint8_t>> Encrypt(const std::vector<uint8_t>& key, const uint8_t* plaintext, size_t len) {
+    Metrics::CryptoTimer timer(Metrics::EncryptBytes, Metrics::EncryptSeconds, len);
     static BCryptProvider prov;
     if (!prov.isValid()) {
         LOG_ERROR("BCrypt provider init failed");
         return std::nullopt;
     }
+    if (len > ULONG_MAX) {
+        LOG_ERROR("Payload too large to encrypt in one envelope");
+        return std::nullopt;
+    }
+
+    // Output layout: Nonce + Ciphertext + Tag, written in place (no intermediate copies)
+    std::vector<uint8_t> result(12 + len + 16);
+    uint8_t* nonce = result.data();
+    uint8_t* ciphertext = result.data() + 12;
+    uint8_t* tag = result.data() + 12 + len;
 
     // Generate Nonce using cryptographically secure RNG
-    std::vector<uint8_t> nonce(12);
-    if (!NT_SUCCESS(BCryptGenRandom(NULL, nonce.data(), (ULONG)nonce.size(), BCRYPT_USE_SYSTEM_PREFERRED_RNG))) {
+    if (!NT_SUCCESS(BCryptGenRandom(NULL, nonce, 12, BCRYPT_USE_SYSTEM_PREFERRED_RNG))) {
         LOG_ERROR("Failed to generate random nonce");
         return std::nullopt;
     }
@@ -89,36 +399,28 @@ std::optional<std::vector<uint8_t>> Encrypt(const std::vector<uint8_t>& key, con
     // Auth Info (GCM)
     BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO authInfo;
     BCRYPT_INIT_AUTH_MODE_INFO(authInfo);
-    authInfo.pbNonce = nonce.data();
-    authInfo.cbNonce = (ULONG)nonce.size();
+    authInfo.pbNonce = nonce;
+    authInfo.cbNonce = 12;
     authInfo.cbTag = 16;
-    std::vector<uint8_t> tag(16);
-    authInfo.pbTag = tag.data();
+    authInfo.pbTag = tag;
 
     // Encrypt
-    std::vector<uint8_t> ciphertext(plaintext.size());
     ULONG bytesDone = 0;
     // Note: For GCM, block size doesn't imply padding in the same way, but buffer must be sufficient
     
-    if (!NT_SUCCESS(BCryptEncrypt(hKey, (PUCHAR)plaintext.data(), (ULONG)plaintext.size(), &authInfo, NULL, 0, ciphertext.data(), (ULONG)ciphertext.size(), &bytesDone, 0))) {
+    if (!NT_SUCCESS(BCryptEncrypt(hKey, (PUCHAR)plaintext, (ULONG)len, &authInfo, NULL, 0, len > 0 ? ciphertext : NULL, (ULONG)len, &bytesDone, 0))) {
         LOG_ERROR("Encryption failed");
         BCryptDestroyKey(hKey);
         return std::nullopt;
     }
     
     BCryptDestroyKey(hKey);
-
-    // Combine: Nonce + Ciphertext + Tag
-    std::vector<uint8_t> result;
-    result.reserve(nonce.size() + ciphertext.size() + tag.size());
-    result.insert(result.end(), nonce.begin(), nonce.end());
-    result.insert(result.end(), ciphertext.begin(), ciphertext.end());
-    result.insert(result.end(), tag.begin(), tag.end());
     return result;
 }
 
 std::optional<std::vector<uint8_t>> Decrypt(const std::vector<uint8_t>& key, const std::vector<uint8_t>& encryptedData) {
     if (encryptedData.size() < 12 + 16) return std::nullopt;
+    Metrics::CryptoTimer timer(Metrics::DecryptBytes, Metrics::DecryptSeconds, encryptedData.size() - 12 - 16);
 
     static BCryptProvider prov;
     if (!prov.isValid()) return std::nullopt;
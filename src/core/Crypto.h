@@ -2,6 +2,7 @@
 #include <vector>
 #include <string>
 #include <optional>
+#include <memory>
 #include <cstdint>
 
 namespace ClipboardPush {
@@ -10,11 +11,72 @@ namespace Crypto {
 // Input: Key (32 bytes), Plaintext
 // Output: [Nonce(12)] + [Ciphertext] + [Tag(16)]
 std::optional<std::vector<uint8_t>> Encrypt(const std::vector<uint8_t>& key, const std::vector<uint8_t>& plaintext);
+// Same, reading the plaintext from any contiguous range (e.g. a mapped file view)
+std::optional<std::vector<uint8_t>> Encrypt(const std::vector<uint8_t>& key, const uint8_t* plaintext, size_t len);
 
 // Input: Key (32 bytes), EncryptedData ([Nonce] + [Ciphertext] + [Tag])
 // Output: Plaintext
 std::optional<std::vector<uint8_t>> Decrypt(const std::vector<uint8_t>& key, const std::vector<uint8_t>& encryptedData);
 
+// HMAC-SHA256 over a byte range. Used to derive content IDs that reveal
+// nothing to parties without the room key.
+std::vector<uint8_t> HmacSha256(const std::vector<uint8_t>& key, const uint8_t* data, size_t len);
+
+// HMAC-SHA256 over data that arrives in pieces
+class HmacSha256Stream {
+public:
+    explicit HmacSha256Stream(const std::vector<uint8_t>& key);
+    ~HmacSha256Stream();
+    bool IsValid() const;
+    bool Update(const uint8_t* data, size_t len);
+    // Empty on failure; the stream can't be updated afterwards
+    std::vector<uint8_t> Finish();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// AES-GCM over a payload that arrives in pieces, producing the same envelope
+// as Encrypt(): Nonce(12) + Ciphertext + Tag(16). Ciphertext comes out in
+// whole 16-byte blocks; a partial block is held until the next Update or Finish.
+class GcmEncryptor {
+public:
+    explicit GcmEncryptor(const std::vector<uint8_t>& key);
+    ~GcmEncryptor();
+    bool IsValid() const;
+
+    // The 12 bytes that start the envelope
+    const uint8_t* Nonce() const;
+    // Appends ciphertext to `out`
+    bool Update(const uint8_t* data, size_t len, std::vector<uint8_t>& out);
+    // Appends the remaining ciphertext and the tag to `out`
+    bool Finish(std::vector<uint8_t>& out);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
+// Inverse of GcmEncryptor for an envelope that arrives in pieces. The tag
+// comes last, so plaintext handed out by Update is unauthenticated until
+// Finish() returns true; callers must not act on it before that.
+class GcmDecryptor {
+public:
+    explicit GcmDecryptor(const std::vector<uint8_t>& key);
+    ~GcmDecryptor();
+    bool IsValid() const;
+
+    // Appends plaintext to `out`
+    bool Update(const uint8_t* data, size_t len, std::vector<uint8_t>& out);
+    // Appends the remaining plaintext; false if the envelope is truncated or forged
+    bool Finish(std::vector<uint8_t>& out);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> m_impl;
+};
+
 // Base64 helpers
 std::string ToBase64(const std::vector<uint8_t>& data);
 std::vector<uint8_t> FromBase64(const std::string& data);
@@ -0,0 +1,43 @@
+#include "Debouncer.h"
+#include <algorithm>
+
+namespace ClipboardPush {
+
+Debouncer::Debouncer(Duration quietWindow, Duration maxLatency) {
+    Configure(quietWindow, maxLatency);
+}
+
+void Debouncer::Configure(Duration quietWindow, Duration maxLatency) {
+    m_quiet = std::max(quietWindow, Duration(0));
+    // The cap can never be shorter than a single quiet window
+    m_maxLatency = std::max(maxLatency, m_quiet);
+}
+
+Debouncer::Duration Debouncer::Signal(Clock::time_point now) {
+    if (!m_pending) {
+        m_pending = true;
+        m_first = now;
+    }
+    m_last = now;
+    return Remaining(now);
+}
+
+bool Debouncer::Poll(Clock::time_point now, Duration& wait) {
+    if (!m_pending) {
+        wait = Duration(0);
+        return false;
+    }
+    wait = Remaining(now);
+    if (wait.count() > 0) return false;
+    m_pending = false;
+    return true;
+}
+
+Debouncer::Duration Debouncer::Remaining(Clock::time_point now) const {
+    auto deadline = std::min(m_last + m_quiet, m_first + m_maxLatency);
+    if (deadline <= now) return Duration(0);
+    // Round up so a timer never fires a hair before the deadline
+    return std::chrono::ceil<Duration>(deadline - now);
+}
+
+}
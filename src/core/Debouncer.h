@@ -0,0 +1,39 @@
+#pragma once
+#include <chrono>
+
+namespace ClipboardPush {
+
+// Collapses bursts of change notifications into a single action.
+// Fires once no change has been seen for the quiet window, or once the
+// first change of the burst is older than the max latency cap.
+// Time is passed in by the caller so the logic has no timers of its own.
+class Debouncer {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Duration = std::chrono::milliseconds;
+
+    Debouncer(Duration quietWindow, Duration maxLatency);
+
+    void Configure(Duration quietWindow, Duration maxLatency);
+
+    // Records a change. Returns how long to wait before calling Poll().
+    Duration Signal(Clock::time_point now);
+
+    // Returns true (and resets) when the pending burst is due.
+    // Otherwise `wait` receives the time left until it is.
+    bool Poll(Clock::time_point now, Duration& wait);
+
+    bool Pending() const { return m_pending; }
+    void Cancel() { m_pending = false; }
+
+private:
+    Duration Remaining(Clock::time_point now) const;
+
+    Duration m_quiet;
+    Duration m_maxLatency;
+    bool m_pending = false;
+    Clock::time_point m_first;
+    Clock::time_point m_last;
+};
+
+}
@@ -0,0 +1,86 @@
+#include "EchoCache.h"
+#include "Hash.h"
+#include <algorithm>
+
+namespace ClipboardPush {
+
+// Distinct seeds keep the key spaces of the different content kinds apart
+static const uint64_t kTextSeed = 0x54455854;
+static const uint64_t kFilesSeed = 0x46494C45;
+static const uint64_t kSequenceSeed = 0x53455143;
+static const uint64_t kTransferSeed = 0x5452414E;
+
+EchoCache::EchoCache(size_t capacity, std::chrono::milliseconds ttl)
+    : m_capacity(capacity), m_ttl(ttl) {}
+
+void EchoCache::Remember(uint64_t key, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Prune(now);
+    m_entries.push_back({ key, now + m_ttl });
+    while (m_entries.size() > m_capacity) m_entries.pop_front();
+}
+
+bool EchoCache::Contains(uint64_t key, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Prune(now);
+    return std::any_of(m_entries.begin(), m_entries.end(), [key](const Entry& e) { return e.key == key; });
+}
+
+bool EchoCache::Take(uint64_t key, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Prune(now);
+    auto it = std::find_if(m_entries.begin(), m_entries.end(), [key](const Entry& e) { return e.key == key; });
+    if (it == m_entries.end()) return false;
+    m_entries.erase(it);
+    return true;
+}
+
+bool EchoCache::Claim(uint64_t key, Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Prune(now);
+    if (std::any_of(m_entries.begin(), m_entries.end(), [key](const Entry& e) { return e.key == key; })) return false;
+    m_entries.push_back({ key, now + m_ttl });
+    while (m_entries.size() > m_capacity) m_entries.pop_front();
+    return true;
+}
+
+void EchoCache::Prune(Clock::time_point now) {
+    // Entries share one TTL, so the oldest always expire first
+    while (!m_entries.empty() && m_entries.front().expires <= now) m_entries.pop_front();
+}
+
+uint64_t EchoCache::TextKey(const std::string& text) {
+    // The clipboard hands text back with CRLF line endings and may append NULs
+    std::string norm;
+    norm.reserve(text.size());
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '\r' && i + 1 < text.size() && text[i + 1] == '\n') continue;
+        norm.push_back(text[i]);
+    }
+    while (!norm.empty() && norm.back() == '\0') norm.pop_back();
+    return Hash::XXH64(norm, kTextSeed);
+}
+
+uint64_t EchoCache::FilesKey(const std::vector<std::string>& files) {
+    // Windows paths are case-insensitive and accept either separator
+    std::string joined;
+    for (const auto& f : files) {
+        for (char c : f) {
+            if (c == '/') c = '\\';
+            else if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+            joined.push_back(c);
+        }
+        joined.push_back('\n');
+    }
+    return Hash::XXH64(joined, kFilesSeed);
+}
+
+uint64_t EchoCache::SequenceKey(uint32_t sequence) {
+    return Hash::XXH64(&sequence, sizeof(sequence), kSequenceSeed);
+}
+
+uint64_t EchoCache::TransferKey(const std::string& transferId) {
+    return Hash::XXH64(transferId, kTransferSeed);
+}
+
+}
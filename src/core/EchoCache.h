@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+namespace ClipboardPush {
+
+// Remembers fingerprints of content we just applied from a peer so the
+// resulting local clipboard change is not pushed straight back.
+// Bounded in size and age; lookups never block on I/O or timers.
+class EchoCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    EchoCache(size_t capacity, std::chrono::milliseconds ttl);
+
+    void Remember(uint64_t key, Clock::time_point now = Clock::now());
+    bool Contains(uint64_t key, Clock::time_point now = Clock::now());
+    // Contains, and forgets the entry on a match: one remembered write
+    // suppresses one echo, so copying the same content again still pushes
+    bool Take(uint64_t key, Clock::time_point now = Clock::now());
+    // Remember unless already present; false means someone got there first
+    bool Claim(uint64_t key, Clock::time_point now = Clock::now());
+
+    // Fingerprints over normalized payloads
+    static uint64_t TextKey(const std::string& text);
+    static uint64_t FilesKey(const std::vector<std::string>& files);
+    // For content that does not round-trip byte-exact (images), key on the
+    // clipboard sequence number observed right after our own write.
+    static uint64_t SequenceKey(uint32_t sequence);
+    // A transfer delivered over LAN and relay at once must only land once
+    static uint64_t TransferKey(const std::string& transferId);
+
+private:
+    struct Entry {
+        uint64_t key;
+        Clock::time_point expires;
+    };
+
+    void Prune(Clock::time_point now);
+
+    std::mutex m_mutex;
+    std::deque<Entry> m_entries;
+    size_t m_capacity;
+    std::chrono::milliseconds m_ttl;
+};
+
+}
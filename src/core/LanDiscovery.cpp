@@ -0,0 +1,287 @@
+#ifdef _WIN32
+// MUST include winsock2 before windows.h
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+#include "LanDiscovery.h"
+#include "Logger.h"
+#include "NetworkInfo.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+
+namespace ClipboardPush {
+
+#ifndef _WIN32
+using SOCKET = int;
+static const SOCKET INVALID_SOCKET = -1;
+static const int SOCKET_ERROR = -1;
+static const int WSAEADDRINUSE = EADDRINUSE;
+static int closesocket(SOCKET s) { return close(s); }
+static int WSAGetLastError() { return errno; }
+#endif
+
+static const char* kGroup = "239.255.77.77";
+static const unsigned short kDiscoveryPort = 50077;
+static const auto kBeaconInterval = std::chrono::seconds(5);
+static const auto kPeerExpiry = std::chrono::seconds(16);      // three missed beacons
+static const auto kMinReplyGap = std::chrono::milliseconds(1000);
+static const size_t kMaxBeaconBytes = 1400;
+static const char* kCaps[] = { "blobs", "chunks", "upload", "upload_enc" };
+
+bool LanDiscovery::Peer::Has(const std::string& cap) const {
+    return std::find(caps.begin(), caps.end(), cap) != caps.end();
+}
+
+LanDiscovery& LanDiscovery::Instance() {
+    static LanDiscovery instance;
+    return instance;
+}
+
+void LanDiscovery::Start(int port, IdentitySource identity) {
+    if (m_running) return;
+    m_port = port;
+    m_identity = std::move(identity);
+    m_running = true;
+    m_thread = std::thread(&LanDiscovery::Run, this);
+}
+
+void LanDiscovery::Stop() {
+    m_running = false;
+    // The receive loop wakes at least once a second
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void LanDiscovery::Refresh() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_peers.clear();
+    }
+    m_rejoin = true;
+    m_announceNow = true;
+}
+
+std::optional<LanDiscovery::Peer> LanDiscovery::Find(const std::string& deviceId) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_peers.find(deviceId);
+    if (it == m_peers.end() || std::chrono::steady_clock::now() - it->second.lastSeen > kPeerExpiry) return std::nullopt;
+    return it->second;
+}
+
+std::vector<LanDiscovery::Peer> LanDiscovery::Peers() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto now = std::chrono::steady_clock::now();
+    std::vector<Peer> out;
+    for (const auto& kv : m_peers) {
+        if (now - kv.second.lastSeen <= kPeerExpiry) out.push_back(kv.second);
+    }
+    return out;
+}
+
+std::string LanDiscovery::BuildBeacon(bool bye) const {
+    Identity me = m_identity();
+    if (me.roomHash.empty()) return "";
+
+    nlohmann::json j;
+    j["app"] = "clipboard-push";
+    j["v"] = 1;
+    j["room"] = me.roomHash;
+    j["id"] = me.deviceId;
+    j["port"] = m_port;
+    j["caps"] = std::vector<std::string>(std::begin(kCaps), std::end(kCaps));
+    if (bye) j["bye"] = true;
+    return j.dump();
+}
+
+void LanDiscovery::HandleBeacon(const char* data, size_t len, const std::string& fromIp) {
+    nlohmann::json j = nlohmann::json::parse(data, data + len, nullptr, false);
+    if (!j.is_object() || j.value("app", "") != "clipboard-push") return;
+
+    Identity me = m_identity();
+    std::string id = j.value("id", "");
+    if (id.empty() || id == me.deviceId) return;
+    if (me.roomHash.empty() || j.value("room", "") != me.roomHash) return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (j.value("bye", false)) {
+        if (m_peers.erase(id)) LOG_INFO("LAN discovery: %s left", id.c_str());
+        return;
+    }
+    int port = j.value("port", 0);
+    if (port <= 0 || port > 65535) return;
+
+    Peer& p = m_peers[id];
+    // A peer on several of our subnets is heard from several addresses;
+    // only a new device or a restart (new port) is worth answering early
+    bool fresh = p.deviceId.empty() || p.port != port;
+    if (!fresh && p.ip != fromIp) LOG_DEBUG("LAN discovery: %s now via %s", id.c_str(), fromIp.c_str());
+    p.deviceId = id;
+    p.ip = fromIp;
+    p.port = port;
+    p.caps.clear();
+    for (const auto& c : j.value("caps", nlohmann::json::array())) {
+        if (c.is_string()) p.caps.push_back(c.get<std::string>());
+    }
+    p.lastSeen = std::chrono::steady_clock::now();
+    if (fresh) {
+        LOG_INFO("LAN discovery: %s at %s:%d", id.c_str(), fromIp.c_str(), port);
+        // Answer a newcomer now instead of letting it wait for our next beacon
+        m_announceNow = true;
+    }
+}
+
+void LanDiscovery::ExpireLocked(std::chrono::steady_clock::time_point now) {
+    for (auto it = m_peers.begin(); it != m_peers.end();) {
+        if (now - it->second.lastSeen > kPeerExpiry) {
+            LOG_INFO("LAN discovery: %s timed out", it->first.c_str());
+            it = m_peers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void LanDiscovery::Run() {
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        m_running = false;
+        return;
+    }
+#endif
+
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_SOCKET) {
+        LOG_ERROR("LAN discovery: socket failed (%d)", WSAGetLastError());
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        m_running = false;
+        return;
+    }
+
+    // Several instances (or other apps) may listen on the group port
+#ifdef _WIN32
+    BOOL reuse = TRUE;
+#else
+    int reuse = 1;
+#endif
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons(kDiscoveryPort);
+
+#ifdef _WIN32
+    DWORD ttl = 1;   // never leave the subnet
+    DWORD loop = 1;  // a second instance on this machine should see us
+#else
+    int ttl = 1;
+    int loop = 1;
+#endif
+    if (bind(s, (sockaddr*)&local, sizeof(local)) == SOCKET_ERROR) {
+        LOG_ERROR("LAN discovery: cannot bind port %d (%d)", kDiscoveryPort, WSAGetLastError());
+        closesocket(s);
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        m_running = false;
+        return;
+    }
+    setsockopt(s, IPPROTO_IP, IP_MULTICAST_TTL, (const char*)&ttl, sizeof(ttl));
+    setsockopt(s, IPPROTO_IP, IP_MULTICAST_LOOP, (const char*)&loop, sizeof(loop));
+
+    sockaddr_in group = {};
+    group.sin_family = AF_INET;
+    group.sin_port = htons(kDiscoveryPort);
+    inet_pton(AF_INET, kGroup, &group.sin_addr);
+
+    // A join on INADDR_ANY only covers the interface the routing table picks,
+    // so a laptop on Wi-Fi and Ethernet (or with a VPN up) would only hear one
+    // of them. Join on every usable IPv4 interface instead, and redo it after
+    // each Refresh() since interfaces come and go. INADDR_ANY is the fallback
+    // when there is nothing else (e.g. no network yet, loopback only).
+    std::vector<in_addr> joined;
+    auto membership = [&](int option, in_addr iface) {
+        ip_mreq mreq = {};
+        mreq.imr_multiaddr = group.sin_addr;
+        mreq.imr_interface = iface;
+        return setsockopt(s, IPPROTO_IP, option, (const char*)&mreq, sizeof(mreq)) != SOCKET_ERROR;
+    };
+    auto rejoin = [&]() {
+        for (const auto& iface : joined) membership(IP_DROP_MEMBERSHIP, iface);
+        joined.clear();
+        for (const auto& addr : NetworkInfo::Instance().Snapshot().addresses) {
+            in_addr iface = {};
+            if (inet_pton(AF_INET, addr.c_str(), &iface) != 1) continue;
+            if (membership(IP_ADD_MEMBERSHIP, iface)) joined.push_back(iface);
+            // WSAEADDRINUSE: a second address on an interface already joined
+            else if (WSAGetLastError() != WSAEADDRINUSE) LOG_WARNING("LAN discovery: cannot join %s on %s (%d)", kGroup, addr.c_str(), WSAGetLastError());
+        }
+        if (joined.empty()) {
+            in_addr any = {};
+            any.s_addr = htonl(INADDR_ANY);
+            if (membership(IP_ADD_MEMBERSHIP, any)) joined.push_back(any);
+            else LOG_ERROR("LAN discovery: cannot join %s (%d)", kGroup, WSAGetLastError());
+        }
+        LOG_DEBUG("LAN discovery: joined %s on %zu interface(s)", kGroup, joined.size());
+    };
+    rejoin();
+
+    // One copy per joined interface, so every subnet hears us
+    auto send = [&](bool bye) {
+        std::string beacon = BuildBeacon(bye);
+        if (beacon.empty()) return;
+        for (const auto& iface : joined) {
+            setsockopt(s, IPPROTO_IP, IP_MULTICAST_IF, (const char*)&iface, sizeof(iface));
+            sendto(s, beacon.data(), (int)beacon.size(), 0, (sockaddr*)&group, sizeof(group));
+        }
+    };
+
+    LOG_INFO("LAN discovery listening on %s:%d", kGroup, kDiscoveryPort);
+    auto lastBeacon = std::chrono::steady_clock::time_point();
+    char buf[kMaxBeaconBytes];
+
+    while (m_running) {
+        if (m_rejoin.exchange(false)) rejoin();
+        auto now = std::chrono::steady_clock::now();
+        if (now - lastBeacon >= kBeaconInterval || (m_announceNow && now - lastBeacon >= kMinReplyGap)) {
+            m_announceNow = false;
+            send(false);
+            lastBeacon = now;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ExpireLocked(now);
+        }
+
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(s, &readable);
+        timeval tv = { 1, 0 };
+        if (select((int)s + 1, &readable, NULL, NULL, &tv) <= 0) continue;
+
+        sockaddr_in from = {};
+        socklen_t fromLen = sizeof(from);
+        int n = recvfrom(s, buf, sizeof(buf), 0, (sockaddr*)&from, &fromLen);
+        if (n <= 0) continue;
+
+        char ip[INET_ADDRSTRLEN] = {};
+        inet_ntop(AF_INET, &from.sin_addr, ip, sizeof(ip));
+        HandleBeacon(buf, (size_t)n, ip);
+    }
+
+    // Let peers drop us now rather than after the expiry
+    send(true);
+    closesocket(s);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <functional>
+
+namespace ClipboardPush {
+
+// Finds room members on the local subnet without the relay. Every device
+// multicasts a small beacon (room hash, device ID, LocalServer port,
+// capabilities) and keeps a table of the beacons it hears. The room hash is
+// an HMAC under the room key, so the beacon reveals neither the key nor the
+// room ID, and devices in other rooms simply don't match.
+class LanDiscovery {
+public:
+    // Who this device is on the wire. An empty room hash keeps us quiet and
+    // matches nobody (no room key yet).
+    struct Identity {
+        std::string deviceId;
+        std::string roomHash;
+    };
+    // Asked before each beacon sent and for each one heard, so room changes
+    // apply without a restart
+    using IdentitySource = std::function<Identity()>;
+
+    struct Peer {
+        std::string deviceId;
+        std::string ip;
+        int port = 0;
+        std::vector<std::string> caps;
+        std::chrono::steady_clock::time_point lastSeen;
+
+        std::string BaseUrl() const { return "http://" + ip + ":" + std::to_string(port); }
+        bool Has(const std::string& cap) const;
+    };
+
+    static LanDiscovery& Instance();
+
+    void Start(int port, IdentitySource identity);
+    void Stop();
+    // Room settings or the network changed: forget everyone, rejoin the
+    // group on the current interfaces and announce right away
+    void Refresh();
+
+    std::optional<Peer> Find(const std::string& deviceId) const;
+    std::vector<Peer> Peers() const;
+
+private:
+    LanDiscovery() = default;
+
+    void Run();
+    std::string BuildBeacon(bool bye) const;
+    void HandleBeacon(const char* data, size_t len, const std::string& fromIp);
+    void ExpireLocked(std::chrono::steady_clock::time_point now);
+
+    int m_port = 0;
+    IdentitySource m_identity;
+    std::thread m_thread;
+    std::atomic<bool> m_running{ false };
+    std::atomic<bool> m_announceNow{ false };
+    std::atomic<bool> m_rejoin{ false };
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, Peer> m_peers;
+};
+
+}
@@ -4,22 +4,61 @@
 #include "Config.h"
 #include "Crypto.h"
 #include "SyncLogic.h"
+#include "ChunkStore.h"
+#include "ChunkPipeline.h"
+#include "BlobStore.h"
+#include "PeerStats.h"
+#include "LanDiscovery.h"
+#include "NetworkInfo.h"
+#include "Metrics.h"
+#include "TransferScheduler.h"
 #include "httplib.h"
+#include "platform/MappedFile.h"
 #include <filesystem>
 #include <fstream>
 #include <random>
+#include <algorithm>
+#include <memory>
 
 namespace fs = std::filesystem;
 
 namespace ClipboardPush {
 
+static const size_t kServePieceBytes = 1024 * 1024;
+static const uint64_t kUploadSlackBytes = 64 * 1024;
+
+// Streams a file straight from a read-only mapping; httplib answers Range
+// requests by asking the provider for just those bytes. `onDone` runs once
+// the response is finished or abandoned.
+static bool ServeFile(httplib::Response& res, const fs::path& path, std::function<void()> onDone = nullptr) {
+    auto file = std::make_shared<Platform::MappedFile>();
+    if (!file->Open(path.wstring())) return false;
+
+    res.set_header("Accept-Ranges", "bytes");
+    if (file->Size() == 0) {
+        res.set_content("", "application/octet-stream");
+        if (onDone) onDone();
+        return true;
+    }
+    res.set_content_provider(file->Size(), "application/octet-stream",
+        [file](size_t offset, size_t length, httplib::DataSink& sink) {
+            return sink.write((const char*)file->Data() + offset, std::min(length, kServePieceBytes));
+        },
+        [file, onDone](bool) {
+            if (onDone) onDone();
+        });
+    return true;
+}
+
 LocalServer& LocalServer::Instance() {
     static LocalServer instance;
     return instance;
 }
 
 LocalServer::LocalServer() {
-    m_ip = Utils::GetLocalIPAddress();
+    auto meta = NetworkInfo::Instance().Snapshot();
+    m_ip = meta.private_ip;
+    m_addresses = meta.addresses;
     
     // Pick a random port between 50000 and 60000
     std::random_device rd;
@@ -32,6 +71,26 @@ LocalServer::~LocalServer() {
     Stop();
 }
 
+std::string LocalServer::GetIP() const {
+    std::lock_guard<std::mutex> lock(m_addressMutex);
+    return m_ip;
+}
+
+std::vector<std::string> LocalServer::GetAddresses() const {
+    std::lock_guard<std::mutex> lock(m_addressMutex);
+    return m_addresses;
+}
+
+bool LocalServer::RefreshAddresses() {
+    auto meta = NetworkInfo::Instance().Snapshot();
+    std::lock_guard<std::mutex> lock(m_addressMutex);
+    if (meta.private_ip == m_ip && meta.addresses == m_addresses) return false;
+    LOG_INFO("LAN Sync: Local Server now reachable at http://%s:%d (%zu addresses)", meta.private_ip.c_str(), m_port, meta.addresses.size());
+    m_ip = meta.private_ip;
+    m_addresses = meta.addresses;
+    return true;
+}
+
 void LocalServer::Start() {
     if (m_running) return;
     LOG_INFO("LAN Sync: Local Server starting at http://%s:%d", m_ip.c_str(), m_port);
@@ -53,59 +112,175 @@ void LocalServer::Run() {
         LOG_INFO("LAN Req: %s %s -> %d", req.method.c_str(), req.path.c_str(), res.status);
     });
 
-    svr.Post("/upload", [this](const httplib::Request& req, httplib::Response& res) {
-        auto& config = Config::Instance().Data();
-        if (req.get_header_value("X-Room-ID") != config.room_id) {
+    uint64_t maxUpload = (uint64_t)std::max(1, Config::Instance().Get()->max_upload_mb) * 1024 * 1024;
+    // Room for the multipart framing around the file itself
+    svr.set_payload_max_length((size_t)(maxUpload + kUploadSlackBytes));
+
+    // The body is streamed into a .part file next to its final name and only
+    // renamed once complete, so a dropped or oversized upload never leaves a
+    // truncated file behind and memory use doesn't grow with the file.
+    // With "X-Encryption: aes-256-gcm" the part is a room-key envelope that is
+    // decrypted on the fly; nothing is published unless its tag verifies.
+    svr.Post("/upload", [this, maxUpload](const httplib::Request& req, httplib::Response& res, const httplib::ContentReader& content_reader) {
+        auto config = Config::Instance().Get();
+        if (req.get_header_value("X-Room-ID") != config->room_id) {
             res.status = 401;
             return;
         }
+        if (req.get_header_value_u64("Content-Length") > maxUpload + kUploadSlackBytes) {
+            res.status = 413;
+            return;
+        }
+        if (!req.is_multipart_form_data()) {
+            res.status = 400;
+            return;
+        }
 
-        if (req.form.has_file("file")) {
-            auto file = req.form.get_file("file");
-            std::string filename = file.filename;
-            // Reject filenames with path traversal sequences or directory separators
-            if (filename.empty() || filename.find("..") != std::string::npos ||
-                filename.find('/') != std::string::npos || filename.find('\\') != std::string::npos) {
+        std::unique_ptr<Crypto::GcmDecryptor> decryptor;
+        std::string encryption = req.get_header_value("X-Encryption");
+        if (!encryption.empty()) {
+            if (encryption != "aes-256-gcm" || config->room_key.empty()) {
                 res.status = 400;
                 return;
             }
-            fs::path downloadDir(Utils::ToWide(config.download_path));
-            if (!fs::exists(downloadDir)) fs::create_directories(downloadDir);
-
-            fs::path filePath = downloadDir / Utils::ToWide(filename);
-            int count = 1;
-            std::wstring stem = filePath.stem().wstring();
-            std::wstring ext = filePath.extension().wstring();
-            while (fs::exists(filePath)) {
-                filePath = downloadDir / (stem + L"_" + std::to_wstring(count++) + ext);
+            decryptor = std::make_unique<Crypto::GcmDecryptor>(Crypto::DecodeKey(config->room_key));
+            if (!decryptor->IsValid()) {
+                res.status = 500;
+                return;
+            }
+        }
+        // Direct pushes are always sealed with the room key
+        std::string transferId = req.get_header_value("X-Transfer-ID");
+        if (!transferId.empty() && !decryptor) {
+            res.status = 400;
+            return;
+        }
+
+        fs::path downloadDir(Utils::ToWide(config->download_path));
+        std::string filename;
+        fs::path partPath;
+        std::ofstream ofs;
+        bool inFile = false;
+        uint64_t received = 0;
+        int status = 400;
+        std::vector<uint8_t> plain;
+
+        bool ok = content_reader(
+            [&](const httplib::FormData& part) {
+                inFile = part.name == "file";
+                if (!inFile) return true;
+                // One file per upload
+                if (!filename.empty()) return false;
+
+                filename = part.filename;
+                // Reject filenames with path traversal sequences or directory separators
+                if (filename.empty() || filename.find("..") != std::string::npos ||
+                    filename.find('/') != std::string::npos || filename.find('\\') != std::string::npos) {
+                    return false;
+                }
+                std::error_code ec;
+                if (!fs::exists(downloadDir)) fs::create_directories(downloadDir, ec);
+                partPath = downloadDir / (L"." + Utils::ToWide(filename) + L"." + std::to_wstring(++m_uploadSeq) + L".part");
+                ofs.open(partPath, std::ios::binary | std::ios::trunc);
+                if (!ofs.is_open()) {
+                    LOG_ERROR("LAN Upload: cannot create %s", partPath.string().c_str());
+                    status = 500;
+                    return false;
+                }
+                return true;
+            },
+            [&](const char* data, size_t len) {
+                if (!inFile) return true;
+                received += len;
+                if (received > maxUpload + (decryptor ? 28 : 0)) {
+                    status = 413;
+                    return false;
+                }
+                if (decryptor) {
+                    plain.clear();
+                    if (!decryptor->Update((const uint8_t*)data, len, plain)) return false;
+                    ofs.write((const char*)plain.data(), plain.size());
+                } else {
+                    ofs.write(data, len);
+                }
+                if (!ofs) status = 500;
+                return (bool)ofs;
+            });
+
+        if (ok && partPath.empty()) ok = false;
+        if (ok && decryptor) {
+            plain.clear();
+            ok = decryptor->Finish(plain);
+            if (ok) {
+                ofs.write((const char*)plain.data(), plain.size());
+            } else {
+                LOG_WARNING("LAN Upload: %s failed authentication", filename.c_str());
             }
+        }
+        if (ofs.is_open()) ofs.close();
+        if (ok && !ofs) {
+            ok = false;
+            status = 500;
+        }
+
+        std::error_code ec;
+        if (!ok) {
+            if (!partPath.empty()) fs::remove(partPath, ec);
+            res.status = status;
+            return;
+        }
+
+        // The pull or relay copy got here first; the sender has its ack already
+        if (!transferId.empty() && m_pushHooks.claim && !m_pushHooks.claim(transferId)) {
+            LOG_INFO("LAN Upload: %s already delivered, dropping pushed copy", transferId.c_str());
+            fs::remove(partPath, ec);
+            res.status = 200;
+            res.set_content("DUPLICATE", "text/plain");
+            return;
+        }
+
+        // Pick the final name only now; another upload may have taken it meanwhile
+        fs::path filePath = downloadDir / Utils::ToWide(filename);
+        int count = 1;
+        std::wstring stem = filePath.stem().wstring();
+        std::wstring ext = filePath.extension().wstring();
+        while (fs::exists(filePath)) {
+            filePath = downloadDir / (stem + L"_" + std::to_wstring(count++) + ext);
+        }
+        fs::rename(partPath, filePath, ec);
+        if (ec) {
+            LOG_ERROR("LAN Upload: cannot publish %s (%s)", filename.c_str(), ec.message().c_str());
+            fs::remove(partPath, ec);
+            res.status = 500;
+            return;
+        }
 
-            std::ofstream ofs(filePath, std::ios::binary);
-            ofs.write(file.content.data(), file.content.size());
-            ofs.close();
+        LOG_INFO("LAN Upload: Saved %s (%llu bytes)", filename.c_str(), (unsigned long long)fs::file_size(filePath, ec));
 
-            LOG_INFO("LAN Upload: Saved %s", filename.c_str());
-            
-            // Basic type detection
-            std::string type = "file";
+        // Basic type detection, unless the sender said
+        std::string type = req.get_header_value("X-Transfer-Type");
+        if (type != "image" && type != "file") {
+            type = "file";
             std::string extStr = filePath.extension().string();
             std::transform(extStr.begin(), extStr.end(), extStr.begin(), ::tolower);
             if (extStr == ".png" || extStr == ".jpg" || extStr == ".jpeg" || extStr == ".bmp") {
                 type = "image";
             }
+        }
 
-            ProcessReceivedFile(filePath.string(), filename, type);
-
-            res.status = 200;
-            res.set_content("OK", "text/plain");
+        if (!transferId.empty() && m_pushHooks.delivered) {
+            m_pushHooks.delivered(transferId, req.get_header_value("X-File-ID"), filePath.string(), filename, type);
         } else {
-            res.status = 400;
+            ProcessReceivedFile(filePath.string(), filename, type);
         }
+
+        res.status = 200;
+        res.set_content("OK", "text/plain");
     });
 
     svr.Get("/files/(.*)", [this](const httplib::Request& req, httplib::Response& res) {
-        auto& config = Config::Instance().Data();
-        if (req.get_header_value("X-Room-ID") != config.room_id) {
+        auto config = Config::Instance().Get();
+        if (req.get_header_value("X-Room-ID") != config->room_id) {
             res.status = 401;
             return;
         }
@@ -117,7 +292,7 @@ void LocalServer::Run() {
             res.status = 400;
             return;
         }
-        fs::path downloadDir(Utils::ToWide(config.download_path));
+        fs::path downloadDir(Utils::ToWide(config->download_path));
         fs::path tempDir = fs::path(Utils::GetAppDir()) / L"temp";
         
         fs::path filePath = downloadDir / Utils::ToWide(filename);
@@ -126,15 +301,132 @@ void LocalServer::Run() {
         }
 
         std::error_code ec;
-        if (fs::exists(filePath, ec) && fs::is_regular_file(filePath, ec)) {
-            std::ifstream ifs(filePath, std::ios::binary);
-            std::string content((std::istreambuf_iterator<char>(ifs)), (std::istreambuf_iterator<char>()));
-            res.set_content(content, "application/octet-stream");
+        if (!fs::is_regular_file(filePath, ec) || !ServeFile(res, filePath)) {
+            res.status = 404;
+        }
+    });
+
+    // Sealed whole-file envelope of an outgoing transfer, by blob ID or
+    // transfer ID; the blob stays pinned until the response is done
+    svr.Get("/blobs/([A-Za-z0-9_]+)", [](const httplib::Request& req, httplib::Response& res) {
+        auto config = Config::Instance().Get();
+        if (req.get_header_value("X-Room-ID") != config->room_id) {
+            res.status = 401;
+            return;
+        }
+
+        std::string name = req.matches[1];
+        auto blob = BlobStore::IsValidName(name) ? BlobStore::Instance().Acquire(name) : std::nullopt;
+        if (!blob) {
+            res.status = 404;
+            return;
+        }
+
+        std::string id = blob->id;
+        if (!ServeFile(res, blob->path, [id]() { BlobStore::Instance().Release(id); })) {
+            BlobStore::Instance().Release(id);
+            res.status = 404;
+        }
+    });
+
+    svr.Get("/chunks/([0-9a-f]+)", [](const httplib::Request& req, httplib::Response& res) {
+        auto config = Config::Instance().Get();
+        if (req.get_header_value("X-Room-ID") != config->room_id) {
+            res.status = 401;
+            return;
+        }
+
+        std::string id = req.matches[1];
+        if (!ChunkStore::IsValidId(id)) {
+            res.status = 400;
+            return;
+        }
+
+        // Chunks are stored encrypted; serve them as-is
+        auto chunk = ChunkStore::Instance().Get(id);
+        if (chunk) {
+            res.set_content(std::string(chunk->begin(), chunk->end()), "application/octet-stream");
         } else {
             res.status = 404;
         }
     });
 
+    // Chunk list of an in-flight transfer; receivers poll with ?from=<count seen>.
+    // Bonded receivers also pass relay_from=<relay copies seen> and
+    // lan=<chunks their LAN puller has taken>.
+    svr.Get("/manifest/([A-Za-z0-9_]+)", [](const httplib::Request& req, httplib::Response& res) {
+        auto config = Config::Instance().Get();
+        if (req.get_header_value("X-Room-ID") != config->room_id) {
+            res.status = 401;
+            return;
+        }
+
+        auto pipeline = ChunkPipeline::Find(req.matches[1]);
+        if (!pipeline) {
+            res.status = 404;
+            return;
+        }
+
+        size_t from = 0, relayFrom = 0;
+        try {
+            if (req.has_param("from")) from = std::stoul(req.get_param_value("from"));
+            if (req.has_param("relay_from")) relayFrom = std::stoul(req.get_param_value("relay_from"));
+            if (req.has_param("lan")) pipeline->NoteLanTaken(std::stoul(req.get_param_value("lan")));
+        } catch (...) {
+            res.status = 400;
+            return;
+        }
+
+        bool complete = false, failed = false;
+        nlohmann::json chunks = nlohmann::json::array();
+        for (const auto& e : pipeline->EntriesFrom(from, complete, failed)) {
+            chunks.push_back({ {"id", e.id}, {"size", e.size} });
+        }
+
+        nlohmann::json relay = nlohmann::json::array();
+        for (const auto& r : pipeline->RelayCopiesFrom(relayFrom)) {
+            relay.push_back({ {"first", r.first}, {"count", r.count}, {"url", r.url} });
+        }
+
+        nlohmann::json body;
+        body["from"] = from;
+        body["chunks"] = chunks;
+        body["relay"] = relay;
+        body["complete"] = complete;
+        body["failed"] = failed;
+        res.set_content(body.dump(), "application/json");
+    });
+
+    // Learned per-peer path model and current transfer load, for troubleshooting
+    svr.Get("/diagnostics", [](const httplib::Request& req, httplib::Response& res) {
+        auto config = Config::Instance().Get();
+        if (req.get_header_value("X-Room-ID") != config->room_id) {
+            res.status = 401;
+            return;
+        }
+
+        auto snapshot = TransferScheduler::Instance().GetSnapshot();
+        nlohmann::json body;
+        body["device_id"] = config->device_id;
+        body["lan_timeout_s"] = config->lan_timeout;
+        body["peers"] = PeerStats::Instance().Snapshot();
+        body["lan_peers"] = nlohmann::json::array();
+        for (const auto& p : LanDiscovery::Instance().Peers()) {
+            body["lan_peers"].push_back({ {"device_id", p.deviceId}, {"url", p.BaseUrl()}, {"caps", p.caps} });
+        }
+        body["transfers"] = { {"running", snapshot.running}, {"queued", snapshot.queued} };
+        res.set_content(body.dump(), "application/json");
+    });
+
+    svr.Get("/metrics", [](const httplib::Request& req, httplib::Response& res) {
+        auto config = Config::Instance().Get();
+        if (req.get_header_value("X-Room-ID") != config->room_id) {
+            res.status = 401;
+            return;
+        }
+        res.set_content(Metrics::Render(), "text/plain; version=0.0.4");
+    });
+
     svr.Get("/ping", [](const httplib::Request&, httplib::Response& res) {
         res.set_content("pong", "text/plain");
     });
@@ -143,7 +435,9 @@ void LocalServer::Run() {
         res.set_content("ok", "text/plain");
     });
 
-    if (!svr.listen("0.0.0.0", m_port)) {
+    // Dual-stack so the IPv6 addresses we announce answer too; IPv4 only
+    // where the stack has IPv6 disabled
+    if (!svr.listen("::", m_port) && !svr.listen("0.0.0.0", m_port)) {
         LOG_ERROR("Local Server failed to start on port %d", m_port);
         m_running = false;
     }
@@ -1,7 +1,11 @@
 #pragma once
 #include <string>
+#include <vector>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <functional>
 
 namespace ClipboardPush {
 
@@ -12,19 +16,38 @@ public:
     void Start();
     void Stop();
 
-    std::string GetIP() const { return m_ip; }
+    std::string GetIP() const;
+    // Every candidate address, GetIP() among them, best guess first
+    std::vector<std::string> GetAddresses() const;
+    // Re-reads the local addresses after a network change; true if they differ
+    bool RefreshAddresses();
     int GetPort() const { return m_port; }
 
+    // Uploads that carry an X-Transfer-ID are direct pushes of an announced
+    // transfer; the app deduplicates them against the pull and relay paths
+    // and acknowledges them. Set before Start().
+    struct PushHooks {
+        // False if the transfer was already delivered another way
+        std::function<bool(const std::string& transferId)> claim;
+        std::function<void(const std::string& transferId, const std::string& fileId, const std::string& path,
+            const std::string& filename, const std::string& type)> delivered;
+    };
+    void SetPushHooks(PushHooks hooks) { m_pushHooks = std::move(hooks); }
+
 private:
     LocalServer();
     ~LocalServer();
 
     void Run();
 
+    mutable std::mutex m_addressMutex;
     std::string m_ip;
+    std::vector<std::string> m_addresses;
     int m_port = 0;
     std::thread m_thread;
     std::atomic<bool> m_running{false};
+    std::atomic<uint64_t> m_uploadSeq{0};
+    PushHooks m_pushHooks;
 };
 
 }
@@ -0,0 +1,275 @@
+#include "Logger.h"
+#include <atomic>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <ctime>
+
+namespace ClipboardPush {
+namespace Logger {
+
+// ~1 KB per slot; lines beyond this backlog are dropped, not waited for
+static const size_t kSlotCount = 1024;
+
+namespace {
+
+struct Slot {
+    std::atomic<size_t> seq;
+    Record record;
+};
+
+// Bounded MPMC ring (per-slot sequence numbers) used with a single consumer
+class Sink {
+public:
+    Sink() : m_slots(kSlotCount) {
+        for (size_t i = 0; i < kSlotCount; ++i) m_slots[i].seq.store(i, std::memory_order_relaxed);
+        m_thread = std::thread(&Sink::Run, this);
+    }
+
+    Record* Claim() {
+        size_t pos = m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = m_slots[pos & (kSlotCount - 1)];
+            size_t seq = slot.seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.record.ticket = pos;
+                    return &slot.record;
+                }
+            } else if (diff < 0) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            } else {
+                pos = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void Commit(Record* r) {
+        size_t ticket = r->ticket;
+        // Sequentially consistent, paired with Run(): either the sink sees
+        // this slot before sleeping, or we see it asleep
+        m_slots[ticket & (kSlotCount - 1)].seq.store(ticket + 1);
+
+        if (m_stopped.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(m_drainMutex);
+            Drain();
+        } else if (m_sleeping.load() && m_sleeping.exchange(false)) {
+            // Only the first line after the sink went idle pays for a wakeup
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            m_cv.notify_one();
+        }
+    }
+
+    void Shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(m_wakeMutex);
+            if (m_stopped) return;
+            m_stopped = true;
+        }
+        m_cv.notify_one();
+        if (m_thread.joinable()) m_thread.join();
+        std::lock_guard<std::mutex> lock(m_drainMutex);
+        Drain();
+    }
+
+private:
+    // Drains until the ring is empty, then sleeps until a producer wakes it;
+    // an idle process has no timer waking the sink
+    void Run() {
+        for (;;) {
+            {
+                std::lock_guard<std::mutex> lock(m_drainMutex);
+                Drain();
+            }
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            if (m_stopped) break;
+            m_sleeping.store(true);
+            // Last look after raising the flag, so a line committed just
+            // before it isn't left waiting for the next one
+            if (m_slots[m_head & (kSlotCount - 1)].seq.load() == m_head + 1) {
+                m_sleeping.store(false);
+                continue;
+            }
+            m_cv.wait(lock, [this] { return !m_sleeping.load() || m_stopped.load(); });
+        }
+    }
+
+    // Caller holds m_drainMutex
+    void Drain() {
+        for (;;) {
+            Slot& slot = m_slots[m_head & (kSlotCount - 1)];
+            if (slot.seq.load(std::memory_order_acquire) != m_head + 1) break;
+            Write(slot.record);
+            slot.seq.store(m_head + kSlotCount, std::memory_order_release);
+            ++m_head;
+        }
+        size_t dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped) {
+            std::string line = "[log] " + std::to_string(dropped) + " lines dropped, logging fell behind";
+            Emit(line);
+        }
+    }
+
+    void Write(const Record& r) {
+        std::time_t t = std::chrono::system_clock::to_time_t(r.time);
+        std::tm tm_struct;
+#ifdef _WIN32
+        localtime_s(&tm_struct, &t);
+#else
+        localtime_r(&t, &tm_struct);
+#endif
+        static const char* const kLevelNames[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+        char prefix[32];
+        snprintf(prefix, sizeof(prefix), "[%02d:%02d:%02d] %-5s ",
+            tm_struct.tm_hour, tm_struct.tm_min, tm_struct.tm_sec, kLevelNames[(int)r.level]);
+
+        m_line.assign(prefix);
+        Format(r, m_line);
+        Emit(m_line);
+    }
+
+    static void Emit(const std::string& line) {
+#ifdef _WIN32
+        OutputDebugStringA(line.c_str());
+        OutputDebugStringA("\n");
+#endif
+        printf("%s\n", line.c_str());
+    }
+
+    // printf semantics, one conversion at a time. Length modifiers in the
+    // format are ignored: every integer was widened to 64 bits when it was
+    // queued, so each conversion is re-issued with "ll".
+    static void Format(const Record& r, std::string& out) {
+        size_t next = 0;
+        auto take = [&](Record::Arg& type) -> const Record::Value* {
+            if (next >= r.argc) return nullptr;
+            type = r.types[next];
+            return &r.values[next++];
+        };
+        auto asInt = [&](Record::Arg type, const Record::Value& v) -> long long {
+            if (type == Record::Arg::Double) return (long long)v.d;
+            if (type == Record::Arg::String || type == Record::Arg::Pointer) return 0;
+            return (long long)v.i;
+        };
+
+        char spec[32];
+        char buf[128];
+        for (const char* p = r.format; *p; ++p) {
+            if (*p != '%') {
+                out += *p;
+                continue;
+            }
+            if (p[1] == '%') {
+                out += '%';
+                ++p;
+                continue;
+            }
+
+            // %[flags][width][.precision][length]conversion
+            std::string s = "%";
+            const char* q = p + 1;
+            while (*q && strchr("-+ #0", *q)) s += *q++;
+            for (int part = 0; part < 2; ++part) {
+                if (part == 1) {
+                    if (*q != '.') break;
+                    s += *q++;
+                }
+                if (*q == '*') {
+                    Record::Arg type;
+                    const Record::Value* v = take(type);
+                    s += std::to_string(v ? asInt(type, *v) : 0);
+                    ++q;
+                } else {
+                    while (*q >= '0' && *q <= '9') s += *q++;
+                }
+            }
+            while (*q && strchr("hljztLI0123456789", *q)) ++q;
+            char conv = *q;
+            if (!conv) break;
+            p = q;
+
+            Record::Arg type = Record::Arg::Int;
+            const Record::Value* v = take(type);
+            if (!v) {
+                out += "(missing)";
+                continue;
+            }
+            switch (conv) {
+            case 'd': case 'i':
+                snprintf(spec, sizeof(spec), "%sll%c", s.c_str(), conv);
+                snprintf(buf, sizeof(buf), spec, asInt(type, *v));
+                break;
+            case 'u': case 'o': case 'x': case 'X':
+                snprintf(spec, sizeof(spec), "%sll%c", s.c_str(), conv);
+                snprintf(buf, sizeof(buf), spec, (unsigned long long)asInt(type, *v));
+                break;
+            case 'c':
+                snprintf(spec, sizeof(spec), "%sc", s.c_str());
+                snprintf(buf, sizeof(buf), spec, (int)asInt(type, *v));
+                break;
+            case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+                snprintf(spec, sizeof(spec), "%s%c", s.c_str(), conv);
+                snprintf(buf, sizeof(buf), spec,
+                    type == Record::Arg::Double ? v->d : type == Record::Arg::UInt ? (double)v->u : (double)asInt(type, *v));
+                break;
+            case 'p':
+                snprintf(buf, sizeof(buf), "%p", type == Record::Arg::Pointer ? v->p : nullptr);
+                break;
+            case 's':
+                // Strings skip the scratch buffer, they may be long
+                if (type == Record::Arg::String && s == "%") {
+                    out += r.text + v->text;
+                    continue;
+                }
+                snprintf(spec, sizeof(spec), "%ss", s.c_str());
+                snprintf(buf, sizeof(buf), spec, type == Record::Arg::String ? r.text + v->text : "(?)");
+                break;
+            default:
+                buf[0] = '\0';
+                break;
+            }
+            out += buf;
+        }
+    }
+
+    std::vector<Slot> m_slots;
+    alignas(64) std::atomic<size_t> m_tail{ 0 };
+    alignas(64) size_t m_head = 0; // sink only
+    std::atomic<size_t> m_dropped{ 0 };
+    std::string m_line;
+
+    std::mutex m_drainMutex;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_cv;
+    std::atomic<bool> m_stopped{ false };
+    std::atomic<bool> m_sleeping{ false }; // sink is waiting on m_cv for a producer
+    std::thread m_thread;
+};
+
+// Never destroyed, so lines logged from static destructors still have
+// somewhere to go
+Sink& GetSink() {
+    static Sink* sink = new Sink();
+    return *sink;
+}
+
+}
+
+Record* Claim() {
+    return GetSink().Claim();
+}
+
+void Commit(Record* r) {
+    GetSink().Commit(r);
+}
+
+void Shutdown() {
+    GetSink().Shutdown();
+}
+
+}
+}
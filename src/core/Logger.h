@@ -1,40 +1,122 @@
 #pragma once
+#ifdef _WIN32
 #include <windows.h>
+#endif
 #include <cstdio>
-#include <cstdarg>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
 #include <chrono>
-#include <iomanip>
-#include <sstream>
+#include <type_traits>
 
 namespace ClipboardPush {
 namespace Logger {
 
-inline void Log(const char* format, ...) {
-    char msg[4096];
-    va_list args;
-    va_start(args, format);
-    vsnprintf(msg, sizeof(msg), format, args);
-    va_end(args);
-
-    // Get time
-    auto now = std::chrono::system_clock::now();
-    auto in_time_t = std::chrono::system_clock::to_time_t(now);
-    std::tm tm_struct;
-    localtime_s(&tm_struct, &in_time_t);
-
-    char buffer[5000];
-    snprintf(buffer, sizeof(buffer), "[%02d:%02d:%02d] %s", 
-        tm_struct.tm_hour, tm_struct.tm_min, tm_struct.tm_sec, msg);
-
-    OutputDebugStringA(buffer);
-    OutputDebugStringA("\n");
-    printf("%s\n", buffer);
+enum class Level : uint8_t { Debug, Info, Warning, Error };
+
+// One log call as it sits in the ring: the format string (always a
+// literal, so only the pointer is kept) and the raw arguments. Text is
+// produced later on the sink thread. Strings are copied into `text`
+// because the caller's buffer is usually gone by then.
+struct Record {
+    static const size_t kMaxArgs = 12;
+    static const size_t kTextBytes = 896;
+
+    enum class Arg : uint8_t { Int, UInt, Double, Pointer, String };
+    union Value {
+        int64_t i;
+        uint64_t u;
+        double d;
+        const void* p;
+        uint16_t text; // offset into `text`
+    };
+
+    size_t ticket;
+    std::chrono::system_clock::time_point time;
+    const char* format;
+    Level level;
+    uint8_t argc;
+    uint16_t textUsed;
+    Arg types[kMaxArgs];
+    Value values[kMaxArgs];
+    char text[kTextBytes];
+};
+
+// Lock-free multi-producer ring drained by a single sink thread.
+// Claim() returns nullptr when the ring is full; the line is then dropped
+// and counted rather than making the caller wait.
+Record* Claim();
+void Commit(Record* r);
+
+// Drains what is queued and stops the sink thread; later lines are
+// written synchronously by the caller
+void Shutdown();
+
+inline void PutString(Record& r, const char* s) {
+    if (!s) s = "(null)";
+    size_t room = Record::kTextBytes - r.textUsed;
+    size_t n = room ? (std::min)(strlen(s), room - 1) : 0;
+    if (room) {
+        memcpy(r.text + r.textUsed, s, n);
+        r.text[r.textUsed + n] = '\0';
+    }
+    r.types[r.argc] = Record::Arg::String;
+    // Out of room: point at the terminator of the last string
+    r.values[r.argc].text = room ? r.textUsed : (uint16_t)(Record::kTextBytes - 1);
+    r.textUsed = (uint16_t)(r.textUsed + (room ? n + 1 : 0));
+}
+
+template <typename T>
+inline void Put(Record& r, T v) {
+    if constexpr (std::is_same_v<T, const char*> || std::is_same_v<T, char*>) {
+        PutString(r, v);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        r.types[r.argc] = Record::Arg::Double;
+        r.values[r.argc].d = (double)v;
+    } else if constexpr (std::is_enum_v<T>) {
+        r.types[r.argc] = Record::Arg::Int;
+        r.values[r.argc].i = (int64_t)v;
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        r.types[r.argc] = Record::Arg::Int;
+        r.values[r.argc].i = (int64_t)v;
+    } else if constexpr (std::is_integral_v<T>) {
+        r.types[r.argc] = Record::Arg::UInt;
+        r.values[r.argc].u = (uint64_t)v;
+    } else if constexpr (std::is_pointer_v<T>) {
+        r.types[r.argc] = Record::Arg::Pointer;
+        r.values[r.argc].p = (const void*)v;
+    } else {
+        static_assert(std::is_pointer_v<T>, "Log arguments must be numbers, pointers or C strings (use .c_str())");
+    }
+    r.argc++;
+}
+
+// Costs the caller a slot claim and a few stores; formatting, the clock
+// conversion and the actual I/O happen on the sink thread
+template <typename... Args>
+inline void Log(Level level, const char* format, Args... args) {
+    static_assert(sizeof...(Args) <= Record::kMaxArgs, "Too many log arguments");
+    Record* r = Claim();
+    if (!r) return;
+    r->time = std::chrono::system_clock::now();
+    r->format = format;
+    r->level = level;
+    r->argc = 0;
+    r->textUsed = 0;
+    (Put(*r, args), ...);
+    Commit(r);
 }
 
 }
 }
 
-#define LOG_DEBUG(...)   ClipboardPush::Logger::Log(__VA_ARGS__)
-#define LOG_INFO(...)    ClipboardPush::Logger::Log(__VA_ARGS__)
-#define LOG_WARNING(...) ClipboardPush::Logger::Log(__VA_ARGS__)
-#define LOG_ERROR(...)   ClipboardPush::Logger::Log(__VA_ARGS__)
+// Debug lines sit on per-message paths; release builds drop them entirely,
+// arguments included
+#ifdef NDEBUG
+#define LOG_DEBUG(...)   ((void)0)
+#else
+#define LOG_DEBUG(...)   ClipboardPush::Logger::Log(ClipboardPush::Logger::Level::Debug, __VA_ARGS__)
+#endif
+#define LOG_INFO(...)    ClipboardPush::Logger::Log(ClipboardPush::Logger::Level::Info, __VA_ARGS__)
+#define LOG_WARNING(...) ClipboardPush::Logger::Log(ClipboardPush::Logger::Level::Warning, __VA_ARGS__)
+#define LOG_ERROR(...)   ClipboardPush::Logger::Log(ClipboardPush::Logger::Level::Error, __VA_ARGS__)
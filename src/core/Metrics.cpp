@@ -0,0 +1,128 @@
+#include "Metrics.h"
+#include <cstdio>
+#include <cstdarg>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+namespace ClipboardPush {
+namespace Metrics {
+
+// Metrics register themselves during static initialization of this file only,
+// so the list is complete and immutable before any other thread can read it.
+static Metric* s_head = nullptr;
+static Metric* s_tail = nullptr;
+
+Metric::Metric(Kind kind, const char* name, const char* help, const char* labels, double scale)
+    : m_kind(kind), m_name(name), m_help(help), m_labels(labels), m_scale(scale) {
+    if (s_tail) s_tail->m_next = this;
+    else s_head = this;
+    s_tail = this;
+}
+
+#define METRIC(x) "clipboard_push_" x
+
+Histogram PushBytes(METRIC("transfer_bytes"), "Size of transfers", "direction=\"out\"", 1, 10, 34);
+Histogram ReceiveBytes(METRIC("transfer_bytes"), "Size of transfers", "direction=\"in\"", 1, 10, 34);
+Counter LanDeliveries(METRIC("deliveries_total"), "Outgoing transfers acknowledged by a peer, by the path that delivered them", "path=\"lan\"");
+Counter RelayDeliveries(METRIC("deliveries_total"), "Outgoing transfers acknowledged by a peer, by the path that delivered them", "path=\"relay\"");
+Counter LanFallbacks(METRIC("relay_starts_total"), "Outgoing transfers that had to be uploaded to the relay");
+Counter DirectPushes(METRIC("direct_pushes_total"), "Uploads straight to a discovered peer's /upload, by outcome", "result=\"ok\"");
+Counter DirectPushFailures(METRIC("direct_pushes_total"), "Uploads straight to a discovered peer's /upload, by outcome", "result=\"failed\"");
+Counter DuplicateDrops(METRIC("duplicate_receives_total"), "Incoming copies dropped because the other path delivered first");
+
+Histogram QueueWaitSeconds(METRIC("stage_seconds"), "Duration of transfer stages", "stage=\"queue_wait\"", 1e-6, 7, 27);
+Histogram LanPullSeconds(METRIC("stage_seconds"), "Duration of transfer stages", "stage=\"lan_pull\"", 1e-6, 7, 27);
+Histogram RelayUploadSeconds(METRIC("stage_seconds"), "Duration of transfer stages", "stage=\"relay_upload\"", 1e-6, 7, 27);
+Histogram RelayDownloadSeconds(METRIC("stage_seconds"), "Duration of transfer stages", "stage=\"relay_download\"", 1e-6, 7, 27);
+
+Gauge SchedulerQueued[5] = {
+    { METRIC("scheduler_jobs"), "Transfer jobs by class and state", "class=\"text\",state=\"queued\"" },
+    { METRIC("scheduler_jobs"), "Transfer jobs by class and state", "class=\"image\",state=\"queued\"" },
+    { METRIC("scheduler_jobs"), "Transfer jobs by class and state", "class=\"file\",state=\"queued\"" },
+    { METRIC("scheduler_jobs"), "Transfer jobs by class and state", "class=\"bulk\",state=\"queued\"" },
+    { METRIC("scheduler_jobs"), "Transfer jobs by class and state", "class=\"segment\",state=\"queued\"" },
+};
+Gauge SchedulerRunning[5] = {
+    { METRIC("scheduler_jobs"), "Transfer jobs by class and state", "class=\"text\",state=\"running\"" },
+    { METRIC("scheduler_jobs"), "Transfer jobs by class and state", "class=\"image\",state=\"running\"" },
+    { METRIC("scheduler_jobs"), "Transfer jobs by class and state", "class=\"file\",state=\"running\"" },
+    { METRIC("scheduler_jobs"), "Transfer jobs by class and state", "class=\"bulk\",state=\"running\"" },
+    { METRIC("scheduler_jobs"), "Transfer jobs by class and state", "class=\"segment\",state=\"running\"" },
+};
+
+Counter WsReconnects(METRIC("ws_reconnects_total"), "Reconnects of the relay WebSocket");
+
+Counter EncryptBytes(METRIC("crypto_bytes_total"), "Bytes through AES-GCM", "op=\"encrypt\"");
+Counter DecryptBytes(METRIC("crypto_bytes_total"), "Bytes through AES-GCM", "op=\"decrypt\"");
+Counter EncryptSeconds(METRIC("crypto_seconds_total"), "Time spent in AES-GCM", "op=\"encrypt\"", 1e-9);
+Counter DecryptSeconds(METRIC("crypto_seconds_total"), "Time spent in AES-GCM", "op=\"decrypt\"", 1e-9);
+
+#undef METRIC
+
+static void Append(std::string& out, const char* fmt, ...) {
+    char buf[512];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (n > 0) out.append(buf, std::min((size_t)n, sizeof(buf) - 1));
+}
+
+// Name plus the metric's own labels and an optional extra one
+static void Series(std::string& out, const char* name, const char* suffix, const char* labels, const char* extra) {
+    out += name;
+    out += suffix;
+    bool any = *labels || *extra;
+    if (any) out += '{';
+    out += labels;
+    if (*labels && *extra) out += ',';
+    out += extra;
+    if (any) out += '}';
+    out += ' ';
+}
+
+std::string Render() {
+    static const char* kTypes[] = { "counter", "gauge", "histogram" };
+    std::string out;
+    const char* lastName = "";
+    for (Metric* m = s_head; m; m = m->m_next) {
+        if (strcmp(m->m_name, lastName) != 0) {
+            Append(out, "# HELP %s %s\n# TYPE %s %s\n", m->m_name, m->m_help, m->m_name, kTypes[(int)m->m_kind]);
+            lastName = m->m_name;
+        }
+
+        if (m->m_kind == Metric::Kind::Counter) {
+            uint64_t v = static_cast<Counter*>(m)->Value();
+            Series(out, m->m_name, "", m->m_labels, "");
+            if (m->m_scale == 1) Append(out, "%llu\n", (unsigned long long)v);
+            else Append(out, "%.9g\n", v * m->m_scale);
+        } else if (m->m_kind == Metric::Kind::Gauge) {
+            Series(out, m->m_name, "", m->m_labels, "");
+            Append(out, "%lld\n", (long long)static_cast<Gauge*>(m)->Value());
+        } else {
+            auto* h = static_cast<Histogram*>(m);
+            uint64_t cumulative = 0;
+            int next = 0;
+            // Bucket b holds (2^(b-1), 2^b], so le=2^b counts buckets 0..b
+            for (int e = h->m_minExp; e <= h->m_maxExp; ++e) {
+                for (; next <= e; ++next) cumulative += h->m_buckets[next].load(std::memory_order_relaxed);
+                char le[48];
+                snprintf(le, sizeof(le), "le=\"%.10g\"", std::ldexp(1.0, e) * h->m_scale);
+                Series(out, m->m_name, "_bucket", m->m_labels, le);
+                Append(out, "%llu\n", (unsigned long long)cumulative);
+            }
+            for (; next < 65; ++next) cumulative += h->m_buckets[next].load(std::memory_order_relaxed);
+            Series(out, m->m_name, "_bucket", m->m_labels, "le=\"+Inf\"");
+            Append(out, "%llu\n", (unsigned long long)cumulative);
+            Series(out, m->m_name, "_sum", m->m_labels, "");
+            Append(out, "%.9g\n", h->m_sum.load(std::memory_order_relaxed) * h->m_scale);
+            Series(out, m->m_name, "_count", m->m_labels, "");
+            Append(out, "%llu\n", (unsigned long long)cumulative);
+        }
+    }
+    return out;
+}
+
+}
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace ClipboardPush {
+namespace Metrics {
+
+// Process-wide counters, gauges and histograms, rendered in the Prometheus
+// text format by LocalServer's /metrics route. Every metric is a static
+// object defined in Metrics.cpp; recording is a relaxed atomic add, so it is
+// safe from any thread and cheap enough for hot paths.
+class Metric {
+public:
+    enum class Kind { Counter, Gauge, Histogram };
+
+    Metric(Kind kind, const char* name, const char* help, const char* labels, double scale);
+    Metric(const Metric&) = delete;
+    Metric& operator=(const Metric&) = delete;
+
+protected:
+    friend std::string Render();
+
+    Kind m_kind;
+    const char* m_name;
+    const char* m_help;
+    const char* m_labels; // e.g. path="lan", or ""
+    double m_scale;       // raw value * scale = exported value
+    Metric* m_next = nullptr;
+};
+
+class Counter : public Metric {
+public:
+    Counter(const char* name, const char* help, const char* labels = "", double scale = 1)
+        : Metric(Kind::Counter, name, help, labels, scale) {}
+
+    void Inc(uint64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t Value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_value{ 0 };
+};
+
+class Gauge : public Metric {
+public:
+    Gauge(const char* name, const char* help, const char* labels = "")
+        : Metric(Kind::Gauge, name, help, labels, 1) {}
+
+    void Set(int64_t v) { m_value.store(v, std::memory_order_relaxed); }
+    void Add(int64_t n) { m_value.fetch_add(n, std::memory_order_relaxed); }
+    int64_t Value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> m_value{ 0 };
+};
+
+// Power-of-two buckets: bucket e holds (2^(e-1), 2^e], so its upper bound is
+// exactly the exported le="2^e" and relative error is bounded at 2x whatever
+// the magnitude. Only the bucket bounds in [2^minExp, 2^maxExp] are
+// exported; the rest fold into the neighbours.
+class Histogram : public Metric {
+public:
+    Histogram(const char* name, const char* help, const char* labels, double scale, int minExp, int maxExp)
+        : Metric(Kind::Histogram, name, help, labels, scale), m_minExp(minExp), m_maxExp(maxExp) {}
+
+    void Record(uint64_t v) {
+        m_buckets[v ? BitWidth(v - 1) : 0].fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(v, std::memory_order_relaxed);
+    }
+    // Microseconds elapsed since `start`; for histograms with a 1e-6 scale
+    void Since(std::chrono::steady_clock::time_point start) {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        Record(us > 0 ? (uint64_t)us : 0);
+    }
+
+private:
+    friend std::string Render();
+
+    static int BitWidth(uint64_t v) {
+        int n = 0;
+        while (v) {
+            v >>= 1;
+            n++;
+        }
+        return n;
+    }
+
+    int m_minExp;
+    int m_maxExp;
+    std::atomic<uint64_t> m_buckets[65] = {};
+    std::atomic<uint64_t> m_sum{ 0 };
+};
+
+std::string Render();
+
+// Transfers
+extern Histogram PushBytes;
+extern Histogram ReceiveBytes;
+extern Counter LanDeliveries;
+extern Counter RelayDeliveries;
+extern Counter LanFallbacks;
+extern Counter DuplicateDrops;
+extern Counter DirectPushes;
+extern Counter DirectPushFailures;
+
+// Per-stage durations
+extern Histogram QueueWaitSeconds;
+extern Histogram LanPullSeconds;
+extern Histogram RelayUploadSeconds;
+extern Histogram RelayDownloadSeconds;
+
+// Transfer scheduler, indexed by TransferClass
+extern Gauge SchedulerQueued[5];
+extern Gauge SchedulerRunning[5];
+
+// Relay connection
+extern Counter WsReconnects;
+
+// AES-GCM throughput: rate(bytes) / rate(seconds)
+extern Counter EncryptBytes;
+extern Counter EncryptSeconds;
+extern Counter DecryptBytes;
+extern Counter DecryptSeconds;
+
+// Adds a crypto call's bytes and duration to a pair of the counters above
+class CryptoTimer {
+public:
+    CryptoTimer(Counter& bytes, Counter& seconds, uint64_t n)
+        : m_bytes(bytes), m_seconds(seconds), m_n(n), m_start(std::chrono::steady_clock::now()) {}
+    ~CryptoTimer() {
+        m_bytes.Inc(m_n);
+        m_seconds.Inc((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count());
+    }
+
+private:
+    Counter& m_bytes;
+    Counter& m_seconds;
+    uint64_t m_n;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+}
+}
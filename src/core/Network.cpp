@@ -6,6 +6,8 @@
 #include <winhttp.h>
 #include <thread>
 #include <atomic>
+#include <fstream>
+#include <algorithm>
 
 namespace ClipboardPush {
 namespace Network {
@@ -360,5 +362,86 @@ HttpResponse HttpClient::Put(const std::string& url, const std::vector<uint8_t>&
     return {(int)statusCode, ""};
 }
 
+// Streams `size` bytes of `file` as the request body, framed by `head` and
+// `tail`; shared by the relay PUT and the LAN multipart POST
+static HttpResponse SendFile(const wchar_t* verb, const std::string& url, const std::wstring& headers,
+    const std::string& head, const std::filesystem::path& file, uint64_t size, const std::string& tail, int connectTimeoutMs) {
+    auto comp = ParseUrl(url);
+    if (comp.host.empty()) return {0, ""};
+    uint64_t total = head.size() + size + tail.size();
+    if (total > MAXDWORD) {
+        LOG_ERROR("SendFile: %llu bytes exceeds a single request", (unsigned long long)total);
+        return {0, ""};
+    }
+
+    std::ifstream in(file, std::ios::binary);
+    if (!in.is_open()) return {0, ""};
+
+    WinHttpHandle hSession = WinHttpOpen(L"ClipboardPush/3.0", WINHTTP_ACCESS_TYPE_DEFAULT_PROXY, WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0);
+    if (!hSession.isValid()) return {0, ""};
+
+    DWORD protocols = WINHTTP_FLAG_SECURE_PROTOCOL_TLS1_2 | WINHTTP_FLAG_SECURE_PROTOCOL_TLS1_3;
+    WinHttpSetOption(hSession, WINHTTP_OPTION_SECURE_PROTOCOLS, &protocols, sizeof(protocols));
+    if (connectTimeoutMs > 0) WinHttpSetTimeouts(hSession, connectTimeoutMs, connectTimeoutMs, 30000, 30000);
+
+    WinHttpHandle hConnect = WinHttpConnect(hSession, comp.host.c_str(), comp.port, 0);
+    if (!hConnect.isValid()) return {0, ""};
+
+    DWORD flags = comp.secure ? WINHTTP_FLAG_SECURE : 0;
+    WinHttpHandle hRequest = WinHttpOpenRequest(hConnect, verb, comp.path.c_str(), NULL, WINHTTP_NO_REFERER, NULL, flags);
+    if (!hRequest.isValid()) return {0, ""};
+
+    if (!WinHttpSendRequest(hRequest, headers.c_str(), (DWORD)headers.length(), WINHTTP_NO_REQUEST_DATA, 0, (DWORD)total, 0)) {
+        return {0, ""};
+    }
+
+    DWORD written = 0;
+    if (!head.empty() && (!WinHttpWriteData(hRequest, head.data(), (DWORD)head.size(), &written) || written != head.size())) return {0, ""};
+
+    // Body goes out in 1 MB pieces
+    std::vector<char> buf(1024 * 1024);
+    uint64_t sent = 0;
+    while (sent < size) {
+        size_t want = (size_t)std::min<uint64_t>(buf.size(), size - sent);
+        in.read(buf.data(), want);
+        if ((size_t)in.gcount() != want) return {0, ""};
+        if (!WinHttpWriteData(hRequest, buf.data(), (DWORD)want, &written) || written != want) return {0, ""};
+        sent += want;
+    }
+
+    if (!tail.empty() && (!WinHttpWriteData(hRequest, tail.data(), (DWORD)tail.size(), &written) || written != tail.size())) return {0, ""};
+
+    if (!WinHttpReceiveResponse(hRequest, NULL)) return {0, ""};
+
+    DWORD statusCode = 0;
+    DWORD len = sizeof(statusCode);
+    WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER, WINHTTP_HEADER_NAME_BY_INDEX, &statusCode, &len, WINHTTP_NO_HEADER_INDEX);
+
+    return {(int)statusCode, ""};
+}
+
+HttpResponse HttpClient::PutFile(const std::string& url, const std::filesystem::path& file, uint64_t size) {
+    return SendFile(L"PUT", url, L"Content-Type: application/octet-stream", "", file, size, "", 0);
+}
+
+HttpResponse HttpClient::PostFile(const std::string& url, const std::map<std::string, std::string>& headers,
+    const std::string& filename, const std::filesystem::path& file, uint64_t size, int connectTimeoutMs) {
+    std::string boundary = "----ClipboardPush" + std::to_string(GetTickCount64());
+    std::wstring wheaders = L"Content-Type: multipart/form-data; boundary=" + Utils::ToWide(boundary);
+    for (const auto& h : headers) {
+        wheaders += L"\r\n" + Utils::ToWide(h.first) + L": " + Utils::ToWide(h.second);
+    }
+
+    // Quotes and line breaks would end the header early
+    std::string safeName = filename;
+    std::replace_if(safeName.begin(), safeName.end(), [](char c) { return c == '"' || c == '\r' || c == '\n'; }, '_');
+
+    std::string head = "--" + boundary + "\r\n"
+        "Content-Disposition: form-data; name=\"file\"; filename=\"" + safeName + "\"\r\n"
+        "Content-Type: application/octet-stream\r\n\r\n";
+    std::string tail = "\r\n--" + boundary + "--\r\n";
+    return SendFile(L"POST", url, wheaders, head, file, size, tail, connectTimeoutMs);
+}
+
 }
 }
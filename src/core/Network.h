@@ -5,6 +5,9 @@
 #include <functional>
 #include <optional>
 #include <memory>
+#include <filesystem>
+#include <chrono>
+#include <cstdint>
 
 namespace ClipboardPush {
 namespace Network {
@@ -18,10 +21,21 @@ class HttpClient {
 public:
     static HttpResponse Post(const std::string& url, const std::string& body, const std::string& contentType = "application/json");
     static HttpResponse Put(const std::string& url, const std::vector<uint8_t>& data);
+    // Streams `size` bytes of a file as the body instead of loading it into memory
+    static HttpResponse PutFile(const std::string& url, const std::filesystem::path& file, uint64_t size);
+    // Same, as the single "file" part of a multipart/form-data POST
+    static HttpResponse PostFile(const std::string& url, const std::map<std::string, std::string>& headers,
+        const std::string& filename, const std::filesystem::path& file, uint64_t size, int connectTimeoutMs = 0);
     static std::optional<std::vector<uint8_t>> Get(const std::string& url);
     static std::optional<std::vector<uint8_t>> GetWithHeaders(const std::string& url, const std::map<std::string, std::string>& headers);
 };
 
+// Happy-eyeballs connect (RFC 8305): starts a TCP connect to hosts[0], then
+// to the next host every `stagger` or as soon as one fails, and keeps
+// whichever completes first. Returns its index, or -1 when none answered
+// within `timeout`. Hosts are numeric IPv4 or IPv6 addresses.
+int RaceConnect(const std::vector<std::string>& hosts, int port, std::chrono::milliseconds stagger, std::chrono::milliseconds timeout);
+
 class WebSocketClient {
 public:
     using OnMessageCallback = std::function<void(const std::string&)>;
@@ -0,0 +1,299 @@
+#ifdef _WIN32
+// MUST include winsock2 before windows.h
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <iphlpapi.h>
+#include <netioapi.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <fstream>
+#include <sstream>
+#endif
+#include "NetworkInfo.h"
+#include "Hash.h"
+#include <algorithm>
+#include <map>
+#include <cstdint>
+#include <cstring>
+
+namespace ClipboardPush {
+
+// Only matters if change notifications are unavailable or one was missed
+static const auto kMaxAge = std::chrono::minutes(5);
+static const size_t kMaxAddresses = 8;
+
+namespace {
+
+struct Candidate {
+    std::string ip;
+    bool v6 = false;
+    int prefix = 0;
+    std::string adapter;
+    int score = 0;
+};
+
+}
+
+// Hard-coded guess at which address is the LAN: home routers, then corporate
+// 10/8, then the rest. CGNAT and VPN ranges come last.
+static int ScoreAddress(const std::string& ip, bool v6) {
+    if (v6) {
+        // Unique local (fc00::/7) stays on site; global addresses may be firewalled
+        return (ip[0] == 'f' || ip[0] == 'F') ? 60 : 40;
+    }
+    if (ip.substr(0, 8) == "192.168.") return 100;
+    if (ip.substr(0, 3) == "10." && ip.substr(0, 7) != "10.100.") return 90;
+    if (ip.substr(0, 4) == "172.") return 80;
+    if (ip.substr(0, 7) == "100.64.") return 10;
+    return 50;
+}
+
+static int PrefixLength(const uint8_t* mask, size_t len) {
+    int bits = 0;
+    for (size_t i = 0; i < len; ++i) {
+        for (uint8_t b = mask[i]; b; b <<= 1) bits++;
+    }
+    return bits;
+}
+
+// "192.168.1.37", 24 -> "192.168.1.0/24"
+static std::string SubnetOf(const std::string& ip, int prefix) {
+    in_addr addr;
+    if (inet_pton(AF_INET, ip.c_str(), &addr) != 1) return ip;
+    uint32_t mask = prefix <= 0 ? 0 : prefix >= 32 ? 0xFFFFFFFFu : ~(0xFFFFFFFFu >> prefix);
+    addr.s_addr = htonl(ntohl(addr.s_addr) & mask);
+    char buf[INET_ADDRSTRLEN] = {};
+    inet_ntop(AF_INET, &addr, buf, sizeof(buf));
+    return std::string(buf) + "/" + std::to_string(prefix);
+}
+
+#ifdef _WIN32
+
+static void Enumerate(std::vector<Candidate>& out, std::map<std::string, std::string>& gateways) {
+    const ULONG flags = GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST | GAA_FLAG_SKIP_DNS_SERVER | GAA_FLAG_INCLUDE_GATEWAYS;
+    ULONG size = 16 * 1024;
+    std::vector<uint8_t> buffer;
+    ULONG rc = ERROR_BUFFER_OVERFLOW;
+    // On overflow the call reports the size it needs; adapters can appear
+    // between that call and the next, so allow a few rounds
+    for (int attempt = 0; attempt < 4 && rc == ERROR_BUFFER_OVERFLOW; ++attempt) {
+        buffer.resize(size);
+        rc = GetAdaptersAddresses(AF_UNSPEC, flags, NULL, reinterpret_cast<PIP_ADAPTER_ADDRESSES>(buffer.data()), &size);
+    }
+    if (rc != ERROR_SUCCESS) return;
+
+    for (auto a = reinterpret_cast<PIP_ADAPTER_ADDRESSES>(buffer.data()); a; a = a->Next) {
+        if (a->OperStatus != IfOperStatusUp) continue;
+        if (a->IfType == IF_TYPE_SOFTWARE_LOOPBACK) continue;
+        std::wstring desc = a->Description;
+        if (desc.find(L"VMware") != std::wstring::npos || desc.find(L"VirtualBox") != std::wstring::npos) continue;
+
+        for (auto u = a->FirstUnicastAddress; u; u = u->Next) {
+            Candidate c;
+            c.adapter = a->AdapterName;
+            c.prefix = u->OnLinkPrefixLength;
+            char buf[INET6_ADDRSTRLEN] = {};
+            if (u->Address.lpSockaddr->sa_family == AF_INET6) {
+                // Link-local needs a scope ID the peer can't know; temporary
+                // privacy addresses rotate and duplicate the stable one
+                auto sa = reinterpret_cast<sockaddr_in6*>(u->Address.lpSockaddr);
+                if (IN6_IS_ADDR_LINKLOCAL(&sa->sin6_addr) || IN6_IS_ADDR_LOOPBACK(&sa->sin6_addr)) continue;
+                if (u->SuffixOrigin == IpSuffixOriginRandom || u->DadState != IpDadStatePreferred) continue;
+                inet_ntop(AF_INET6, &sa->sin6_addr, buf, sizeof(buf));
+                c.v6 = true;
+            } else if (u->Address.lpSockaddr->sa_family == AF_INET) {
+                auto sa = reinterpret_cast<sockaddr_in*>(u->Address.lpSockaddr);
+                inet_ntop(AF_INET, &sa->sin_addr, buf, sizeof(buf));
+            } else {
+                continue;
+            }
+            c.ip = buf;
+            out.push_back(c);
+        }
+
+        // The gateway's MAC identifies the network; its IP (often 192.168.1.1) doesn't
+        for (auto g = a->FirstGatewayAddress; g; g = g->Next) {
+            if (g->Address.lpSockaddr->sa_family != AF_INET) continue;
+            MIB_IPNET_ROW2 row = {};
+            row.Address.Ipv4 = *reinterpret_cast<sockaddr_in*>(g->Address.lpSockaddr);
+            row.InterfaceIndex = a->IfIndex;
+            std::string id;
+            if (GetIpNetEntry2(&row) == NO_ERROR && row.PhysicalAddressLength > 0) {
+                // Same text as /proc/net/arp so every platform hashes alike
+                static const char digits[] = "0123456789abcdef";
+                for (ULONG i = 0; i < row.PhysicalAddressLength; ++i) {
+                    if (i) id.push_back(':');
+                    id.push_back(digits[row.PhysicalAddress[i] >> 4]);
+                    id.push_back(digits[row.PhysicalAddress[i] & 0xF]);
+                }
+            } else {
+                char ip[INET_ADDRSTRLEN] = {};
+                inet_ntop(AF_INET, &row.Address.Ipv4.sin_addr, ip, sizeof(ip));
+                id = ip;
+            }
+            gateways[a->AdapterName] = id;
+            break;
+        }
+    }
+}
+
+#else
+
+// /proc/net/if_inet6 flags (IFA_F_*) per address, hex as in the file
+static std::map<std::string, unsigned> Inet6Flags() {
+    std::map<std::string, unsigned> flags;
+    std::ifstream in("/proc/net/if_inet6");
+    std::string hex, index, prefix, scope, flag, name;
+    while (in >> hex >> index >> prefix >> scope >> flag >> name) {
+        flags[hex] = (unsigned)std::stoul(flag, nullptr, 16);
+    }
+    return flags;
+}
+
+// Interface -> default gateway IPv4, from /proc/net/route
+static std::map<std::string, std::string> DefaultGateways() {
+    std::map<std::string, std::string> out;
+    std::ifstream in("/proc/net/route");
+    std::string line;
+    std::getline(in, line); // header
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string iface, dest, gateway;
+        if (!(fields >> iface >> dest >> gateway) || dest != "00000000" || out.count(iface)) continue;
+        in_addr addr;
+        addr.s_addr = (uint32_t)std::stoul(gateway, nullptr, 16); // already network order
+        char buf[INET_ADDRSTRLEN] = {};
+        inet_ntop(AF_INET, &addr, buf, sizeof(buf));
+        out[iface] = buf;
+    }
+    return out;
+}
+
+// "ip@iface" -> MAC, from /proc/net/arp
+static std::map<std::string, std::string> NeighbourMacs() {
+    std::map<std::string, std::string> out;
+    std::ifstream in("/proc/net/arp");
+    std::string line;
+    std::getline(in, line); // header
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string ip, hwType, flags, mac, mask, iface;
+        if (fields >> ip >> hwType >> flags >> mac >> mask >> iface && mac != "00:00:00:00:00:00") out[ip + "@" + iface] = mac;
+    }
+    return out;
+}
+
+static void Enumerate(std::vector<Candidate>& out, std::map<std::string, std::string>& gateways) {
+    ifaddrs* list = nullptr;
+    if (getifaddrs(&list) != 0) return;
+    auto inet6Flags = Inet6Flags();
+
+    for (ifaddrs* a = list; a; a = a->ifa_next) {
+        if (!a->ifa_addr || !a->ifa_netmask) continue;
+        if (!(a->ifa_flags & IFF_UP) || !(a->ifa_flags & IFF_RUNNING) || (a->ifa_flags & IFF_LOOPBACK)) continue;
+        // Host-only bridges, the counterparts of the VMware/VirtualBox adapters skipped on Windows
+        std::string name = a->ifa_name;
+        if (name.rfind("docker", 0) == 0 || name.rfind("virbr", 0) == 0) continue;
+
+        Candidate c;
+        c.adapter = name;
+        char buf[INET6_ADDRSTRLEN] = {};
+        if (a->ifa_addr->sa_family == AF_INET6) {
+            auto sa = reinterpret_cast<sockaddr_in6*>(a->ifa_addr);
+            if (IN6_IS_ADDR_LINKLOCAL(&sa->sin6_addr) || IN6_IS_ADDR_LOOPBACK(&sa->sin6_addr)) continue;
+            static const char digits[] = "0123456789abcdef";
+            std::string hex;
+            for (int i = 0; i < 16; ++i) {
+                hex.push_back(digits[sa->sin6_addr.s6_addr[i] >> 4]);
+                hex.push_back(digits[sa->sin6_addr.s6_addr[i] & 0xF]);
+            }
+            // IFA_F_TEMPORARY | IFA_F_DADFAILED | IFA_F_DEPRECATED | IFA_F_TENTATIVE
+            auto f = inet6Flags.find(hex);
+            if (f != inet6Flags.end() && (f->second & (0x01 | 0x08 | 0x20 | 0x40))) continue;
+            inet_ntop(AF_INET6, &sa->sin6_addr, buf, sizeof(buf));
+            c.v6 = true;
+            c.prefix = PrefixLength(reinterpret_cast<sockaddr_in6*>(a->ifa_netmask)->sin6_addr.s6_addr, 16);
+        } else if (a->ifa_addr->sa_family == AF_INET) {
+            auto sa = reinterpret_cast<sockaddr_in*>(a->ifa_addr);
+            inet_ntop(AF_INET, &sa->sin_addr, buf, sizeof(buf));
+            c.prefix = PrefixLength(reinterpret_cast<const uint8_t*>(&reinterpret_cast<sockaddr_in*>(a->ifa_netmask)->sin_addr), 4);
+        } else {
+            continue;
+        }
+        c.ip = buf;
+        out.push_back(c);
+    }
+    freeifaddrs(list);
+
+    // The gateway's MAC identifies the network; its IP (often 192.168.1.1) doesn't
+    auto macs = NeighbourMacs();
+    for (const auto& kv : DefaultGateways()) {
+        auto mac = macs.find(kv.second + "@" + kv.first);
+        gateways[kv.first] = mac != macs.end() ? mac->second : kv.second;
+    }
+}
+
+#endif
+
+NetworkMetadata NetworkInfo::Query() {
+    std::vector<Candidate> candidates;
+    std::map<std::string, std::string> gateways;
+    Enumerate(candidates, gateways);
+
+    NetworkMetadata meta;
+    int bestScore = -1;
+    const Candidate* best = nullptr;
+    for (auto& c : candidates) {
+        c.score = ScoreAddress(c.ip, c.v6);
+        if (!c.v6 && c.ip != "127.0.0.1" && c.ip.substr(0, 8) != "169.254." && c.score > bestScore) {
+            bestScore = c.score;
+            best = &c;
+        }
+    }
+    if (best) {
+        meta.private_ip = best->ip;
+        meta.cidr = best->ip + "/" + std::to_string(best->prefix);
+        auto gw = gateways.find(best->adapter);
+        std::string subnet = SubnetOf(best->ip, best->prefix);
+        meta.network_id_hash = Hash::ToHex(Hash::XXH64((gw != gateways.end() ? gw->second : "") + "|" + subnet));
+    }
+
+    std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+    for (const auto& c : candidates) {
+        if (meta.addresses.size() >= kMaxAddresses) break;
+        if (c.ip == "127.0.0.1" || c.ip.substr(0, 8) == "169.254.") continue;
+        if (std::find(meta.addresses.begin(), meta.addresses.end(), c.ip) == meta.addresses.end()) meta.addresses.push_back(c.ip);
+    }
+    return meta;
+}
+
+NetworkInfo& NetworkInfo::Instance() {
+    static NetworkInfo instance;
+    return instance;
+}
+
+NetworkMetadata NetworkInfo::Snapshot() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto now = std::chrono::steady_clock::now();
+    if (m_valid && now - m_takenAt < kMaxAge) return m_snapshot;
+
+    // Enumerate under the lock: callers racing a change share one query
+    NetworkMetadata fresh = Query();
+    bool first = m_takenAt == std::chrono::steady_clock::time_point();
+    fresh.network_epoch = m_snapshot.network_epoch + (!first && fresh.network_id_hash != m_snapshot.network_id_hash ? 1 : 0);
+    m_snapshot = std::move(fresh);
+    m_takenAt = now;
+    m_valid = true;
+    return m_snapshot;
+}
+
+void NetworkInfo::Invalidate() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_valid = false;
+}
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+namespace ClipboardPush {
+
+struct NetworkMetadata {
+    std::string private_ip = "127.0.0.1";
+    std::string cidr = "127.0.0.1/32";
+    // Same value every time we join this network, whatever adapter or lease:
+    // hash of the default gateway's MAC and the subnet
+    std::string network_id_hash = "";
+    // Bumped each time network_id_hash changes during this run
+    int network_epoch = 0;
+    // Every address a peer might reach us on, most likely first; private_ip
+    // is the first IPv4 one. Peers race them rather than trust the ranking.
+    std::vector<std::string> addresses;
+};
+
+// Cached snapshot of the machine's interfaces. Enumerating adapters costs a
+// few milliseconds of system calls, and the answer only changes when the
+// network does, so callers share one snapshot until Invalidate() (from the
+// network monitor) or a safety max age forces a new one.
+//
+// Backends: GetAdaptersAddresses + the neighbour table on Windows,
+// getifaddrs + /proc/net elsewhere.
+class NetworkInfo {
+public:
+    static NetworkInfo& Instance();
+
+    NetworkMetadata Snapshot();
+    void Invalidate();
+
+    // Enumerates now, bypassing the cache
+    static NetworkMetadata Query();
+
+private:
+    NetworkInfo() = default;
+
+    std::mutex m_mutex;
+    bool m_valid = false;
+    std::chrono::steady_clock::time_point m_takenAt;
+    NetworkMetadata m_snapshot;
+};
+
+}
@@ -0,0 +1,294 @@
+#include "PeerStats.h"
+#include "Logger.h"
+#include <windows.h>
+#include <fstream>
+#include <algorithm>
+#include <vector>
+
+namespace ClipboardPush {
+
+static const size_t kLatencySamples = 64;
+static const size_t kMinLanSamples = 3;
+static const uint32_t kMinRelaySamples = 3;
+static const uint32_t kUnreachableAttempts = 5;
+static const int64_t kReprobeSeconds = 3600;    // retry LAN for an "unreachable" peer after this
+static const double kDefaultLanMsPerMB = 80;
+static const double kMinTimeoutMs = 250;
+static const uint64_t kSizeSampleBytes = 1024 * 1024;
+static const auto kSaveInterval = std::chrono::seconds(60);
+
+static int64_t UnixNow() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+static double Megabytes(uint64_t bytes) {
+    return (double)bytes / (1024 * 1024);
+}
+
+PeerStats& PeerStats::Instance() {
+    static PeerStats instance;
+    return instance;
+}
+
+void PeerStats::Load(const std::filesystem::path& file) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_file = file;
+    m_lastSave = std::chrono::steady_clock::now();
+
+    std::ifstream in(file);
+    if (!in.is_open()) return;
+    try {
+        nlohmann::json j;
+        in >> j;
+        for (auto& kv : j.value("peers", nlohmann::json::object()).items()) {
+            const auto& v = kv.value();
+            Peer p;
+            p.lanAttempts = v.value("lan_attempts", 0u);
+            p.lanSuccesses = v.value("lan_successes", 0u);
+            // Files from before the streak was kept: only a peer that never
+            // delivered over LAN can be on one
+            p.lanMissStreak = v.value("lan_miss_streak", p.lanSuccesses == 0 ? p.lanAttempts : 0u);
+            for (auto& ms : v.value("lan_ms", nlohmann::json::array())) {
+                if (ms.is_number_unsigned() && p.lanMs.size() < kLatencySamples) p.lanMs.push_back(ms.get<uint32_t>());
+            }
+            p.lanMsPerMB = v.value("lan_ms_per_mb", 0.0);
+            p.relaySamples = v.value("relay_samples", 0u);
+            p.relayMs = v.value("relay_ms", 0.0);
+            p.relayMsPerMB = v.value("relay_ms_per_mb", 0.0);
+            p.lastLanTry = v.value("last_lan_try", (int64_t)0);
+            p.lanHost = v.value("lan_host", "");
+            m_peers[kv.key()] = p;
+        }
+        LOG_INFO("Peer stats loaded: %zu peers", m_peers.size());
+    } catch (const std::exception& e) {
+        LOG_WARNING("Ignoring unreadable peer stats: %s", e.what());
+        m_peers.clear();
+    }
+}
+
+void PeerStats::Save() {
+    std::lock_guard<std::mutex> saveLock(m_saveMutex);
+    std::string body;
+    std::filesystem::path target;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_dirty || m_file.empty()) return;
+
+        nlohmann::json peers = nlohmann::json::object();
+        for (const auto& kv : m_peers) {
+            const Peer& p = kv.second;
+            peers[kv.first] = {
+                {"lan_attempts", p.lanAttempts},
+                {"lan_successes", p.lanSuccesses},
+                {"lan_miss_streak", p.lanMissStreak},
+                {"lan_ms", std::vector<uint32_t>(p.lanMs.begin(), p.lanMs.end())},
+                {"lan_ms_per_mb", p.lanMsPerMB},
+                {"relay_samples", p.relaySamples},
+                {"relay_ms", p.relayMs},
+                {"relay_ms_per_mb", p.relayMsPerMB},
+                {"last_lan_try", p.lastLanTry},
+                {"lan_host", p.lanHost}
+            };
+        }
+        nlohmann::json j;
+        j["peers"] = peers;
+        body = j.dump(2);
+        target = m_file;
+        // Cleared up front: a change made while writing marks it dirty again
+        m_dirty = false;
+        m_lastSave = std::chrono::steady_clock::now();
+    }
+
+    // Same temp + flush + rename as Config::Persist, so a crash mid-write
+    // leaves the previous file intact
+    std::filesystem::path temp = target;
+    temp += ".tmp";
+    HANDLE file = CreateFileW(temp.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    bool ok = file != INVALID_HANDLE_VALUE;
+    if (ok) {
+        DWORD written = 0;
+        ok = ::WriteFile(file, body.data(), (DWORD)body.size(), &written, NULL) && written == body.size();
+        ok = ok && FlushFileBuffers(file);
+        CloseHandle(file);
+        if (ok) ok = MoveFileExW(temp.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+        if (!ok) DeleteFileW(temp.c_str());
+    }
+    if (!ok) {
+        LOG_WARNING("Failed to save peer stats (error %lu)", GetLastError());
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_dirty = true;
+    }
+}
+
+bool PeerStats::MarkDirtyLocked() {
+    m_dirty = true;
+    return std::chrono::steady_clock::now() - m_lastSave >= kSaveInterval;
+}
+
+void PeerStats::OnLanDelivered(const std::string& peer, std::chrono::milliseconds elapsed, uint64_t bytes) {
+    if (peer.empty()) return;
+    bool save;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Peer& p = m_peers[peer];
+        p.lanAttempts++;
+        p.lanSuccesses++;
+        p.lanMissStreak = 0;
+        p.lastLanTry = UnixNow();
+
+        double ms = (double)elapsed.count();
+        if (bytes >= kSizeSampleBytes) {
+            double fixed = p.lanMs.empty() ? 0 : LanP99(p) / 2;
+            double perMB = std::max(0.0, ms - fixed) / Megabytes(bytes);
+            p.lanMsPerMB = p.lanMsPerMB > 0 ? 0.75 * p.lanMsPerMB + 0.25 * perMB : perMB;
+        } else {
+            p.lanMs.push_back((uint32_t)std::max(0.0, ms));
+            if (p.lanMs.size() > kLatencySamples) p.lanMs.pop_front();
+        }
+        save = MarkDirtyLocked();
+    }
+    if (save) Save();
+}
+
+void PeerStats::OnLanMissed(const std::string& peer) {
+    if (peer.empty()) return;
+    bool save;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Peer& p = m_peers[peer];
+        p.lanAttempts++;
+        p.lanMissStreak++;
+        p.lastLanTry = UnixNow();
+        save = MarkDirtyLocked();
+    }
+    if (save) Save();
+}
+
+void PeerStats::OnRelayDelivered(const std::string& peer, std::chrono::milliseconds elapsed, uint64_t bytes) {
+    if (peer.empty()) return;
+    bool save;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Peer& p = m_peers[peer];
+        p.relaySamples++;
+
+        double ms = (double)elapsed.count();
+        if (bytes >= kSizeSampleBytes) {
+            double perMB = std::max(0.0, ms - p.relayMs) / Megabytes(bytes);
+            p.relayMsPerMB = p.relayMsPerMB > 0 ? 0.75 * p.relayMsPerMB + 0.25 * perMB : perMB;
+        } else {
+            p.relayMs = p.relayMs > 0 ? 0.875 * p.relayMs + 0.125 * ms : ms;
+        }
+        save = MarkDirtyLocked();
+    }
+    if (save) Save();
+}
+
+std::string PeerStats::LanHost(const std::string& peer) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_peers.find(peer);
+    return it == m_peers.end() ? "" : it->second.lanHost;
+}
+
+void PeerStats::SetLanHost(const std::string& peer, const std::string& host) {
+    if (peer.empty()) return;
+    bool save;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Peer& p = m_peers[peer];
+        if (p.lanHost == host) return;
+        p.lanHost = host;
+        save = MarkDirtyLocked();
+    }
+    if (save) Save();
+}
+
+// Judged on recent outcomes: a peer that used to take LAN pulls but has
+// missed every one since (moved behind a firewall, new network) counts too
+bool PeerStats::Unreachable(const Peer& p, int64_t now) {
+    return p.lanMissStreak >= kUnreachableAttempts && now - p.lastLanTry < kReprobeSeconds;
+}
+
+double PeerStats::LanP99(const Peer& p) {
+    if (p.lanMs.empty()) return 0;
+    std::vector<uint32_t> sorted(p.lanMs.begin(), p.lanMs.end());
+    std::sort(sorted.begin(), sorted.end());
+    size_t idx = (sorted.size() * 99 + 99) / 100 - 1;
+    return sorted[std::min(idx, sorted.size() - 1)];
+}
+
+PeerStats::PathPlan PeerStats::Plan(const std::set<std::string>& peers, uint64_t bytes, std::chrono::milliseconds cap) const {
+    PathPlan plan;
+    if (peers.empty()) return plan;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int64_t now = UnixNow();
+    bool allRelay = true;
+    bool anyUnreachable = false;
+    bool lanKnown = true;
+    double timeout = 0;
+
+    for (const auto& id : peers) {
+        auto it = m_peers.find(id);
+        if (it == m_peers.end()) {
+            allRelay = false;
+            lanKnown = false;
+            continue;
+        }
+        const Peer& p = it->second;
+        if (Unreachable(p, now)) {
+            anyUnreachable = true;
+            continue;
+        }
+
+        bool hasLan = p.lanMs.size() >= kMinLanSamples;
+        double lan = hasLan ? LanP99(p) + (p.lanMsPerMB > 0 ? p.lanMsPerMB : kDefaultLanMsPerMB) * Megabytes(bytes) : 0;
+        bool hasRelay = p.relaySamples >= kMinRelaySamples && p.relayMs > 0 && (bytes < kSizeSampleBytes || p.relayMsPerMB > 0);
+        double relay = hasRelay ? p.relayMs + p.relayMsPerMB * Megabytes(bytes) : 0;
+
+        // Only a clear win justifies skipping LAN for this peer
+        if (hasLan && hasRelay && relay * 2 < lan) continue;
+
+        allRelay = false;
+        if (!hasLan) lanKnown = false;
+        timeout = std::max(timeout, lan);
+    }
+
+    if (allRelay) {
+        plan.known = true;
+        plan.skipLan = true;
+        plan.reason = anyUnreachable ? "lan_unreachable" : "relay_faster";
+        return plan;
+    }
+    if (!lanKnown) return plan;
+
+    plan.known = true;
+    plan.lanTimeout = std::chrono::milliseconds((long long)std::min(std::max(timeout, kMinTimeoutMs), (double)cap.count()));
+    plan.reason = "peer_p99";
+    return plan;
+}
+
+nlohmann::json PeerStats::Snapshot() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int64_t now = UnixNow();
+    nlohmann::json out = nlohmann::json::object();
+    for (const auto& kv : m_peers) {
+        const Peer& p = kv.second;
+        out[kv.first] = {
+            {"lan_attempts", p.lanAttempts},
+            {"lan_successes", p.lanSuccesses},
+            {"lan_miss_streak", p.lanMissStreak},
+            {"lan_samples", p.lanMs.size()},
+            {"lan_p99_ms", LanP99(p)},
+            {"lan_ms_per_mb", p.lanMsPerMB},
+            {"relay_samples", p.relaySamples},
+            {"relay_ms", p.relayMs},
+            {"relay_ms_per_mb", p.relayMsPerMB},
+            {"lan_unreachable", Unreachable(p, now)},
+            {"lan_host", p.lanHost}
+        };
+    }
+    return out;
+}
+
+}
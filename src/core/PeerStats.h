@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <set>
+#include <map>
+#include <deque>
+#include <mutex>
+#include <chrono>
+#include <filesystem>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+namespace ClipboardPush {
+
+// Per-peer history of how deliveries went: LAN pull success rate and latency,
+// LAN and relay throughput. Persisted next to the executable so a restart
+// doesn't have to relearn which peers sit behind a firewall.
+class PeerStats {
+public:
+    // How an outgoing transfer should reach its peers
+    struct PathPlan {
+        bool known = false;   // false: not enough history, use the global defaults
+        bool skipLan = false; // every peer is unreachable over LAN or the relay is clearly faster
+        std::chrono::milliseconds lanTimeout{ 0 };
+        const char* reason = "";
+    };
+
+    static PeerStats& Instance();
+
+    void Load(const std::filesystem::path& file);
+    // Writes the file if anything changed since the last save
+    void Save();
+
+    void OnLanDelivered(const std::string& peer, std::chrono::milliseconds elapsed, uint64_t bytes);
+    // The peer was offered the LAN copy but only got the transfer via relay
+    void OnLanMissed(const std::string& peer);
+    // Relay upload start to the peer's relay acknowledgement
+    void OnRelayDelivered(const std::string& peer, std::chrono::milliseconds elapsed, uint64_t bytes);
+
+    // The peer's announced address that last won a connect race, tried first next time
+    std::string LanHost(const std::string& peer) const;
+    void SetLanHost(const std::string& peer, const std::string& host);
+
+    PathPlan Plan(const std::set<std::string>& peers, uint64_t bytes, std::chrono::milliseconds cap) const;
+
+    nlohmann::json Snapshot() const;
+
+private:
+    PeerStats() = default;
+
+    struct Peer {
+        uint32_t lanAttempts = 0;
+        uint32_t lanSuccesses = 0;
+        uint32_t lanMissStreak = 0;   // LAN misses since the last LAN delivery
+        std::deque<uint32_t> lanMs;   // fixed latency of recent small deliveries
+        double lanMsPerMB = 0;        // 0 = unknown
+        uint32_t relaySamples = 0;
+        double relayMs = 0;           // smoothed fixed cost, 0 = unknown
+        double relayMsPerMB = 0;      // 0 = unknown
+        int64_t lastLanTry = 0;       // unix seconds
+        std::string lanHost;
+    };
+
+    static bool Unreachable(const Peer& p, int64_t now);
+    static double LanP99(const Peer& p);
+    // True once the last save is old enough to write again
+    bool MarkDirtyLocked();
+
+    mutable std::mutex m_mutex;
+    std::mutex m_saveMutex; // orders writers; held without m_mutex while writing
+    std::filesystem::path m_file;
+    std::map<std::string, Peer> m_peers;
+    bool m_dirty = false;
+    std::chrono::steady_clock::time_point m_lastSave;
+};
+
+}
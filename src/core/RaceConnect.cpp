@@ -0,0 +1,142 @@
+#ifdef _WIN32
+// MUST include winsock2 before windows.h
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+#include "Network.h"
+#include "Logger.h"
+#include <algorithm>
+
+namespace ClipboardPush {
+namespace Network {
+
+#ifndef _WIN32
+using SOCKET = int;
+static const SOCKET INVALID_SOCKET = -1;
+static int closesocket(SOCKET s) { return close(s); }
+#endif
+
+// Non-blocking connect; true if it completed or is still in progress
+static bool StartConnect(SOCKET s, const addrinfo* ai) {
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(s, FIONBIO, &nonBlocking);
+    return connect(s, ai->ai_addr, (int)ai->ai_addrlen) == 0 || WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+    return connect(s, ai->ai_addr, ai->ai_addrlen) == 0 || errno == EINPROGRESS;
+#endif
+}
+
+int RaceConnect(const std::vector<std::string>& hosts, int port, std::chrono::milliseconds stagger, std::chrono::milliseconds timeout) {
+    if (hosts.empty()) return -1;
+    if (hosts.size() == 1) return 0; // nothing to choose; let the real request time out
+
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return -1;
+#endif
+
+    struct Attempt {
+        SOCKET s = INVALID_SOCKET;
+        size_t host = 0;
+    };
+    std::vector<Attempt> live;
+    size_t next = 0;
+    int winner = -1;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + timeout;
+    auto nextStart = start;
+
+    auto launch = [&]() {
+        while (next < hosts.size()) {
+            size_t i = next++;
+            addrinfo hints = {};
+            hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo* ai = nullptr;
+            if (getaddrinfo(hosts[i].c_str(), std::to_string(port).c_str(), &hints, &ai) != 0 || !ai) continue;
+
+            SOCKET s = socket(ai->ai_family, SOCK_STREAM, IPPROTO_TCP);
+            if (s != INVALID_SOCKET) {
+                if (StartConnect(s, ai)) {
+                    live.push_back({ s, i });
+                    freeaddrinfo(ai);
+                    return;
+                }
+                closesocket(s);
+            }
+            freeaddrinfo(ai);
+        }
+    };
+
+    while (winner < 0) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) break;
+        // Next attempt is due, or nothing is in flight to wait for
+        if (next < hosts.size() && (now >= nextStart || live.empty())) {
+            launch();
+            nextStart = now + stagger;
+        }
+        if (live.empty()) {
+            if (next >= hosts.size()) break;
+            continue;
+        }
+
+        fd_set writable, failed;
+        FD_ZERO(&writable);
+        FD_ZERO(&failed);
+        int maxFd = 0;
+        for (const auto& a : live) {
+            FD_SET(a.s, &writable);
+            FD_SET(a.s, &failed);
+            maxFd = std::max(maxFd, (int)a.s);
+        }
+        auto wait = std::min(deadline, next < hosts.size() ? nextStart : deadline) - now;
+        auto us = std::max<long long>(0, std::chrono::duration_cast<std::chrono::microseconds>(wait).count());
+        timeval tv = { (long)(us / 1000000), (long)(us % 1000000) };
+        // The first argument is ignored by Winsock
+        if (select(maxFd + 1, NULL, &writable, &failed, &tv) <= 0) continue;
+
+        for (auto it = live.begin(); it != live.end();) {
+            int err = 0;
+            socklen_t errLen = sizeof(err);
+            bool ready = FD_ISSET(it->s, &writable);
+            // A failed connect shows up as writable on POSIX, in `failed` on Winsock
+            if (ready || FD_ISSET(it->s, &failed)) getsockopt(it->s, SOL_SOCKET, SO_ERROR, (char*)&err, &errLen);
+            if (ready && err == 0) {
+                winner = (int)it->host;
+                break;
+            }
+            if (ready || FD_ISSET(it->s, &failed)) {
+                // Refused or unreachable: move on without waiting out the stagger
+                closesocket(it->s);
+                it = live.erase(it);
+                nextStart = std::chrono::steady_clock::now();
+                continue;
+            }
+            ++it;
+        }
+    }
+
+    for (const auto& a : live) closesocket(a.s);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    if (winner >= 0) {
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+        LOG_INFO("Connect race: %s won in %lld ms (%zu candidates)", hosts[winner].c_str(), (long long)ms, hosts.size());
+    }
+    return winner;
+}
+
+}
+}
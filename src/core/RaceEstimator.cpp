@@ -0,0 +1,58 @@
+#include "RaceEstimator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ClipboardPush {
+
+static const double kDefaultFixedMs = 1500;    // before any LAN delivery was seen
+static const double kDefaultMsPerMB = 80;      // ~12 MB/s, a conservative Wi-Fi guess
+static const double kMinHeadStartMs = 250;
+static const uint64_t kSizeSampleBytes = 1024 * 1024;
+
+RaceEstimator& RaceEstimator::Instance() {
+    static RaceEstimator instance;
+    return instance;
+}
+
+void RaceEstimator::OnLanDelivered(std::chrono::milliseconds elapsed, uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    double ms = (double)elapsed.count();
+    m_missStreak = 0;
+
+    if (bytes >= kSizeSampleBytes) {
+        // Large transfers teach throughput; the fixed part is already known or guessed
+        double fixed = m_hasSample ? m_srtt : 0;
+        double perMB = std::max(0.0, ms - fixed) / ((double)bytes / (1024 * 1024));
+        m_msPerMB = m_msPerMB > 0 ? 0.75 * m_msPerMB + 0.25 * perMB : perMB;
+        return;
+    }
+
+    if (!m_hasSample) {
+        m_srtt = ms;
+        m_rttvar = ms / 2;
+        m_hasSample = true;
+    } else {
+        m_rttvar = 0.75 * m_rttvar + 0.25 * std::abs(m_srtt - ms);
+        m_srtt = 0.875 * m_srtt + 0.125 * ms;
+    }
+}
+
+void RaceEstimator::OnLanMissed() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_missStreak < 4) m_missStreak++;
+}
+
+std::chrono::milliseconds RaceEstimator::HeadStart(uint64_t bytes, std::chrono::milliseconds cap) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    double fixed = m_hasSample ? m_srtt + 4 * m_rttvar : kDefaultFixedMs;
+    double perMB = m_msPerMB > 0 ? m_msPerMB : kDefaultMsPerMB;
+    double ms = fixed + perMB * ((double)bytes / (1024 * 1024));
+
+    // LAN keeps losing (different network, firewall): stop waiting for it
+    ms /= (double)(1 << m_missStreak);
+
+    ms = std::min(std::max(ms, kMinHeadStartMs), (double)cap.count());
+    return std::chrono::milliseconds((long long)ms);
+}
+
+}
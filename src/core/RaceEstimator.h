@@ -0,0 +1,34 @@
+#pragma once
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+namespace ClipboardPush {
+
+// Learns how long LAN deliveries take so a racing relay upload gives the
+// LAN path just enough of a head start. The fixed part is tracked like a
+// TCP retransmission timer (smoothed latency plus four deviations); the
+// per-megabyte cost is learned separately from larger transfers.
+class RaceEstimator {
+public:
+    static RaceEstimator& Instance();
+
+    // Time from announcement to a LAN acknowledgement
+    void OnLanDelivered(std::chrono::milliseconds elapsed, uint64_t bytes);
+    // The relay had to deliver; repeated misses shrink the head start
+    void OnLanMissed();
+
+    std::chrono::milliseconds HeadStart(uint64_t bytes, std::chrono::milliseconds cap) const;
+
+private:
+    RaceEstimator() = default;
+
+    mutable std::mutex m_mutex;
+    bool m_hasSample = false;
+    double m_srtt = 0;       // ms
+    double m_rttvar = 0;     // ms
+    double m_msPerMB = 0;    // 0 = unknown
+    int m_missStreak = 0;
+};
+
+}
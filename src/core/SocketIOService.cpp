@@ -2,6 +2,8 @@
 #include "Logger.h"
 #include "Utils.h"
 #include "LocalServer.h"
+#include "NetworkInfo.h"
+#include "Metrics.h"
 #include <thread>
 #include <chrono>
 
@@ -105,6 +107,7 @@ void SocketIOService::ScheduleReconnect() {
         bool isConnected = (m_status == ConnectionStatus::ConnectedLonely || m_status == ConnectionStatus::ConnectedSynced);
         if (!m_manuallyStopped && !isConnected) {
             LOG_INFO("Reconnection timer expired, trying to connect...");
+            Metrics::WsReconnects.Inc();
             Connect(m_serverUrl, m_roomId, m_clientId);
         }
     }).detach();
@@ -176,9 +179,7 @@ void SocketIOService::HandlePacket(const std::string& packet) {
                 if (eventName == "clipboard_sync") {
                     // If we receive a sync, we are definitely connected to someone
                     SetStatus(ConnectionStatus::ConnectedSynced);
-                    if (m_onClipboard) {
-                        m_onClipboard(eventData.value("content", ""), eventData.value("encrypted", false));
-                    }
+                    if (m_onClipboard) m_onClipboard(eventData);
                 } else if (eventName == "file_sync") {
                     SetStatus(ConnectionStatus::ConnectedSynced);
                     if (m_onFile) m_onFile(eventData);
@@ -186,7 +187,7 @@ void SocketIOService::HandlePacket(const std::string& packet) {
                     int count = eventData.value("count", 1);
                     if (count > 1) SetStatus(ConnectionStatus::ConnectedSynced);
                     else SetStatus(ConnectionStatus::ConnectedLonely);
-                } else if (eventName == "file_sync_completed" || eventName == "file_need_relay") {
+                } else if (eventName == "file_sync_completed" || eventName == "file_need_relay" || eventName == "clipboard_resync") {
                     if (m_onSignaling) m_onSignaling(eventName, eventData);
                 } else if (eventName == "file_available" || eventName == "transfer_command" || eventName == "peer_evicted" || eventName == "room_state_changed" || eventName == "client_list_update") {
                     if (m_onSignaling) m_onSignaling(eventName, eventData);
@@ -201,7 +202,7 @@ void SocketIOService::HandlePacket(const std::string& packet) {
 void SocketIOService::JoinRoom() {
     if (m_roomId.empty()) return;
     
-    auto meta = Utils::GetNetworkMetadata();
+    auto meta = NetworkInfo::Instance().Snapshot();
     uint64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
 
     nlohmann::json data;
@@ -215,7 +216,8 @@ void SocketIOService::JoinRoom() {
     network["private_ip"] = meta.private_ip;
     network["cidr"] = meta.cidr;
     network["network_id_hash"] = meta.network_id_hash;
-    network["network_epoch"] = 0; // Simple epoch
+    network["addresses"] = meta.addresses;
+    network["network_epoch"] = meta.network_epoch;
     data["network"] = network;
 
     nlohmann::json probe;
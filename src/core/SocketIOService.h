@@ -16,7 +16,7 @@ enum class ConnectionStatus {
 
 class SocketIOService {
 public:
-    using ClipboardCallback = std::function<void(const std::string& content, bool encrypted)>;
+    using ClipboardCallback = std::function<void(const nlohmann::json& data)>;
     using FileCallback = std::function<void(const nlohmann::json& data)>;
     using StatusCallback = std::function<void(ConnectionStatus status)>;
     using CountdownCallback = std::function<void(int secondsLeft)>;
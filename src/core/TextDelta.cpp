@@ -0,0 +1,171 @@
+#include "TextDelta.h"
+#include "Hash.h"
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+
+namespace ClipboardPush {
+namespace TextDelta {
+
+static const char kMagic[4] = { 'C', 'P', 'D', '1' };
+static const size_t kBlockSize = 24;
+static const uint32_t kRollMul = 0x01000193;
+
+static void PutU64(std::vector<uint8_t>& out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back((uint8_t)(v >> (i * 8)));
+}
+
+static void PutVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+static bool GetU64(const std::vector<uint8_t>& in, size_t& pos, uint64_t& v) {
+    if (pos + 8 > in.size()) return false;
+    v = 0;
+    for (int i = 0; i < 8; ++i) v |= (uint64_t)in[pos + i] << (i * 8);
+    pos += 8;
+    return true;
+}
+
+static bool GetVarint(const std::vector<uint8_t>& in, size_t& pos, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= in.size()) return false;
+        uint8_t b = in[pos++];
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+static void EmitInsert(std::vector<uint8_t>& out, const std::string& target, size_t from, size_t to) {
+    if (to <= from) return;
+    out.push_back('I');
+    PutVarint(out, to - from);
+    out.insert(out.end(), target.begin() + from, target.begin() + to);
+}
+
+static void EmitCopy(std::vector<uint8_t>& out, size_t offset, size_t len) {
+    out.push_back('C');
+    PutVarint(out, offset);
+    PutVarint(out, len);
+}
+
+static uint32_t BlockHash(const char* p, size_t len) {
+    uint32_t h = 0;
+    for (size_t i = 0; i < len; ++i) h = h * kRollMul + (uint8_t)p[i];
+    return h;
+}
+
+std::vector<uint8_t> Encode(const std::string& base, const std::string& target) {
+    std::vector<uint8_t> out(kMagic, kMagic + 4);
+    PutU64(out, Hash::XXH64(base));
+    PutU64(out, Hash::XXH64(target));
+    PutVarint(out, target.size());
+
+    const size_t n = target.size();
+    if (base.size() < kBlockSize || n < kBlockSize) {
+        EmitInsert(out, target, 0, n);
+        return out;
+    }
+
+    // Index non-overlapping base blocks; first occurrence wins.
+    std::unordered_map<uint32_t, size_t> index;
+    index.reserve(base.size() / kBlockSize + 1);
+    for (size_t off = 0; off + kBlockSize <= base.size(); off += kBlockSize) {
+        index.emplace(BlockHash(base.data() + off, kBlockSize), off);
+    }
+
+    uint32_t pow = 1;
+    for (size_t i = 1; i < kBlockSize; ++i) pow *= kRollMul;
+
+    size_t literalStart = 0;
+    size_t i = 0;
+    uint32_t h = BlockHash(target.data(), kBlockSize);
+
+    while (i + kBlockSize <= n) {
+        auto it = index.find(h);
+        if (it != index.end() && memcmp(base.data() + it->second, target.data() + i, kBlockSize) == 0) {
+            size_t o = it->second;
+            size_t start = i;
+            // Grow the match backwards into the pending literal run
+            while (start > literalStart && o > 0 && base[o - 1] == target[start - 1]) {
+                --start;
+                --o;
+            }
+            size_t len = (i - start) + kBlockSize;
+            while (o + len < base.size() && start + len < n && base[o + len] == target[start + len]) {
+                ++len;
+            }
+
+            EmitInsert(out, target, literalStart, start);
+            EmitCopy(out, o, len);
+            i = start + len;
+            literalStart = i;
+            if (i + kBlockSize <= n) h = BlockHash(target.data() + i, kBlockSize);
+            continue;
+        }
+
+        if (i + kBlockSize < n) {
+            h = (h - (uint8_t)target[i] * pow) * kRollMul + (uint8_t)target[i + kBlockSize];
+        }
+        ++i;
+    }
+
+    EmitInsert(out, target, literalStart, n);
+    return out;
+}
+
+std::optional<Header> ReadHeader(const std::vector<uint8_t>& delta) {
+    if (delta.size() < 4 || memcmp(delta.data(), kMagic, 4) != 0) return std::nullopt;
+    size_t pos = 4;
+    Header hdr;
+    if (!GetU64(delta, pos, hdr.base_hash)) return std::nullopt;
+    if (!GetU64(delta, pos, hdr.target_hash)) return std::nullopt;
+    if (!GetVarint(delta, pos, hdr.target_len)) return std::nullopt;
+    return hdr;
+}
+
+std::optional<std::string> Apply(const std::string& base, const std::vector<uint8_t>& delta) {
+    auto hdr = ReadHeader(delta);
+    if (!hdr || hdr->base_hash != Hash::XXH64(base)) return std::nullopt;
+    if (hdr->target_len > kMaxTargetBytes) return std::nullopt;
+
+    // Header is magic + two hashes + varint; re-derive the op stream offset.
+    size_t pos = 4 + 16;
+    uint64_t ignored = 0;
+    GetVarint(delta, pos, ignored);
+
+    // target_len comes from the peer. Repeated copies can legitimately make
+    // the text longer than base + delta, but don't reserve more up front.
+    std::string out;
+    out.reserve((size_t)std::min<uint64_t>(hdr->target_len, base.size() + delta.size()));
+
+    while (pos < delta.size()) {
+        uint8_t op = delta[pos++];
+        if (op == 'C') {
+            uint64_t offset = 0, len = 0;
+            if (!GetVarint(delta, pos, offset) || !GetVarint(delta, pos, len)) return std::nullopt;
+            if (offset > base.size() || len > base.size() - offset) return std::nullopt;
+            out.append(base, (size_t)offset, (size_t)len);
+        } else if (op == 'I') {
+            uint64_t len = 0;
+            if (!GetVarint(delta, pos, len) || len > delta.size() - pos) return std::nullopt;
+            out.append(reinterpret_cast<const char*>(delta.data() + pos), (size_t)len);
+            pos += (size_t)len;
+        } else {
+            return std::nullopt;
+        }
+        if (out.size() > hdr->target_len) return std::nullopt;
+    }
+
+    if (out.size() != hdr->target_len || Hash::XXH64(out) != hdr->target_hash) return std::nullopt;
+    return out;
+}
+
+}
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+namespace ClipboardPush {
+namespace TextDelta {
+
+// Binary delta of a text clip against a previously synced base.
+// Layout: "CPD1" + base_hash(8) + target_hash(8) + varint target_len + ops
+// Ops: 'C' varint offset varint len (copy from base) | 'I' varint len bytes (insert)
+struct Header {
+    uint64_t base_hash = 0;
+    uint64_t target_hash = 0;
+    uint64_t target_len = 0;
+};
+
+// Deltas are only sent for clips below the large-text threshold; a header
+// claiming more than this is treated as malformed
+static const uint64_t kMaxTargetBytes = 16 * 1024 * 1024;
+
+// Rolling-hash block matching against the base. Always succeeds; the caller
+// decides whether the result is small enough to be worth sending.
+std::vector<uint8_t> Encode(const std::string& base, const std::string& target);
+
+// Returns nullopt if the delta is malformed or was built against another base.
+std::optional<std::string> Apply(const std::string& base, const std::vector<uint8_t>& delta);
+
+std::optional<Header> ReadHeader(const std::vector<uint8_t>& delta);
+
+}
+}
@@ -0,0 +1,126 @@
+#include "TimerWheel.h"
+#include "Logger.h"
+#include <algorithm>
+
+namespace ClipboardPush {
+
+// 256 slots x 50 ms covers 12.8 s per revolution; longer timers simply
+// stay in their slot for extra laps
+static const size_t kSlotCount = 256;
+
+TimerWheel& TimerWheel::Instance() {
+    static TimerWheel instance;
+    return instance;
+}
+
+TimerWheel::TimerWheel() : m_slots(kSlotCount) {
+}
+
+void TimerWheel::Start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) return;
+    m_running = true;
+    m_epoch = std::chrono::steady_clock::now();
+    m_now = 0;
+    m_thread = std::thread(&TimerWheel::Run, this);
+}
+
+void TimerWheel::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) return;
+        m_running = false;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+std::chrono::milliseconds TimerWheel::Elapsed() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_epoch);
+}
+
+TimerWheel::TimerId TimerWheel::Schedule(std::chrono::milliseconds delay, Callback cb) {
+    bool earliest;
+    TimerId id;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Round up so a timer never fires early. The wheel thread may be
+        // asleep, so measure from the clock rather than from m_now.
+        auto due = Elapsed() + std::max(delay, std::chrono::milliseconds(0));
+        uint64_t deadline = (uint64_t)((due.count() + m_tick.count() - 1) / m_tick.count());
+        deadline = std::max(deadline, m_now + 1);
+
+        earliest = m_deadlines.empty() || deadline < *m_deadlines.begin();
+        m_deadlines.insert(deadline);
+
+        Timer t{ m_nextId++, deadline, std::move(cb) };
+        size_t slot = (size_t)(t.deadline % kSlotCount);
+        m_slots[slot].push_back(std::move(t));
+        id = m_slots[slot].back().id;
+        m_index[id] = { slot, std::prev(m_slots[slot].end()) };
+        if (earliest) m_rearm = true;
+    }
+    if (earliest) m_cv.notify_one();
+    return id;
+}
+
+bool TimerWheel::Cancel(TimerId id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_index.find(id);
+    if (it == m_index.end()) return false;
+    // Leaving Run's sleep alone is fine: it wakes, finds nothing due, and
+    // goes back to sleep until the next deadline
+    m_deadlines.erase(m_deadlines.find(it->second.second->deadline));
+    m_slots[it->second.first].erase(it->second.second);
+    m_index.erase(it);
+    return true;
+}
+
+void TimerWheel::Run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (m_running) {
+        m_rearm = false;
+        auto wake = [this] { return !m_running || m_rearm; };
+        if (m_deadlines.empty()) {
+            m_cv.wait(lock, wake);
+        } else {
+            auto next = m_epoch + m_tick * (int64_t)*m_deadlines.begin();
+            if (m_cv.wait_until(lock, next, wake)) continue;
+        }
+
+        // Fire every slot passed since the last wake; after a full lap all
+        // of them have been visited
+        uint64_t now = (uint64_t)(Elapsed() / m_tick);
+        if (now <= m_now) continue;
+        uint64_t last = std::min(now, m_now + kSlotCount);
+        std::vector<Callback> due;
+        for (uint64_t tick = m_now + 1; tick <= last; tick++) {
+            auto& slot = m_slots[(size_t)(tick % kSlotCount)];
+            for (auto it = slot.begin(); it != slot.end();) {
+                if (it->deadline <= now) {
+                    due.push_back(std::move(it->cb));
+                    m_deadlines.erase(m_deadlines.find(it->deadline));
+                    m_index.erase(it->id);
+                    it = slot.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        m_now = now;
+
+        if (due.empty()) continue;
+        lock.unlock();
+        for (auto& cb : due) {
+            try {
+                cb();
+            } catch (...) {
+                LOG_ERROR("Timer callback threw");
+            }
+        }
+        lock.lock();
+    }
+}
+
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <vector>
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+
+namespace ClipboardPush {
+
+// Hashed timer wheel driven by one thread. Resolution is one tick (50 ms);
+// the thread sleeps until the earliest deadline rather than waking every
+// tick. Callbacks run on the wheel thread and must stay short - hand
+// anything slow to the TransferScheduler.
+class TimerWheel {
+public:
+    using TimerId = uint64_t;
+    using Callback = std::function<void()>;
+
+    static TimerWheel& Instance();
+
+    void Start();
+    void Stop();
+
+    TimerId Schedule(std::chrono::milliseconds delay, Callback cb);
+    // False if the timer already fired or was cancelled
+    bool Cancel(TimerId id);
+
+private:
+    TimerWheel();
+
+    struct Timer {
+        TimerId id;
+        uint64_t deadline; // absolute tick
+        Callback cb;
+    };
+
+    void Run();
+    std::chrono::milliseconds Elapsed() const;
+
+    const std::chrono::milliseconds m_tick{ 50 };
+    std::vector<std::list<Timer>> m_slots;
+    std::unordered_map<TimerId, std::pair<size_t, std::list<Timer>::iterator>> m_index;
+    std::multiset<uint64_t> m_deadlines; // earliest first, for the sleep
+    std::chrono::steady_clock::time_point m_epoch;
+    uint64_t m_now = 0; // last tick whose slot has been fired
+    TimerId m_nextId = 1;
+    bool m_rearm = false; // an earlier deadline arrived while Run slept
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_thread;
+    bool m_running = false;
+};
+
+}
@@ -0,0 +1,96 @@
+#include "TransferLifecycle.h"
+#include "Logger.h"
+
+namespace ClipboardPush {
+
+TransferLifecycle::TransferLifecycle(const std::string& transferId, const std::set<std::string>& expectedPeers)
+    : m_id(transferId), m_expected(expectedPeers) {
+    m_history.push_back({ TransferPhase::Announced, std::chrono::steady_clock::now(), "" });
+}
+
+const char* TransferLifecycle::PhaseName(TransferPhase phase) {
+    switch (phase) {
+        case TransferPhase::Announced: return "announced";
+        case TransferPhase::LanServing: return "lan_serving";
+        case TransferPhase::Relaying: return "relaying";
+        case TransferPhase::Done: return "done";
+        default: return "failed";
+    }
+}
+
+TransferPhase TransferLifecycle::Phase() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_history.back().phase;
+}
+
+bool TransferLifecycle::IsTerminal() const {
+    TransferPhase p = Phase();
+    return p == TransferPhase::Done || p == TransferPhase::Failed;
+}
+
+bool TransferLifecycle::Advance(TransferPhase next, const char* reason) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    TransferPhase cur = m_history.back().phase;
+
+    bool allowed = false;
+    switch (cur) {
+        case TransferPhase::Announced:
+            allowed = next != TransferPhase::Announced;
+            break;
+        case TransferPhase::LanServing:
+            allowed = next == TransferPhase::Relaying || next == TransferPhase::Done || next == TransferPhase::Failed;
+            break;
+        case TransferPhase::Relaying:
+            allowed = next == TransferPhase::Done || next == TransferPhase::Failed;
+            break;
+        default:
+            break;
+    }
+    if (!allowed) return false;
+
+    m_history.push_back({ next, std::chrono::steady_clock::now(), reason ? reason : "" });
+    LOG_INFO("transfer %s: %s -> %s (%s)", m_id.c_str(), PhaseName(cur), PhaseName(next), reason ? reason : "");
+    return true;
+}
+
+bool TransferLifecycle::Acknowledge(const std::string& peerId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (peerId.empty()) m_anonymousAcks++;
+    else if (m_expected.empty() || m_expected.count(peerId)) m_acked.insert(peerId);
+    return AllAcknowledgedLocked();
+}
+
+bool TransferLifecycle::RetainPeers(const std::set<std::string>& present) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_expected.begin(); it != m_expected.end();) {
+        if (!present.count(*it) && !m_acked.count(*it)) it = m_expected.erase(it);
+        else ++it;
+    }
+    return AllAcknowledgedLocked();
+}
+
+bool TransferLifecycle::AllAcknowledged() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return AllAcknowledgedLocked();
+}
+
+bool TransferLifecycle::AllAcknowledgedLocked() const {
+    size_t acks = m_acked.size() + m_anonymousAcks;
+    size_t needed = m_expected.empty() ? 1 : m_expected.size();
+    return acks >= needed;
+}
+
+std::string TransferLifecycle::Timeline() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::string out;
+    auto start = m_history.front().at;
+    for (const auto& t : m_history) {
+        if (!out.empty()) out += ", ";
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(t.at - start).count();
+        out += std::string(PhaseName(t.phase)) + " +" + std::to_string(ms) + " ms";
+        if (!t.reason.empty()) out += " (" + t.reason + ")";
+    }
+    return out;
+}
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <chrono>
+
+namespace ClipboardPush {
+
+enum class TransferPhase {
+    Announced,   // offer sent, LAN copy still being published
+    LanServing,  // LAN copy complete, waiting for peers to pull it
+    Relaying,    // relay upload requested or in progress
+    Done,
+    Failed
+};
+
+// State of one outgoing transfer: legal transitions, a timestamp for every
+// transition, and which peers have acknowledged delivery.
+class TransferLifecycle {
+public:
+    // With no known peers, a single acknowledgement completes the transfer
+    TransferLifecycle(const std::string& transferId, const std::set<std::string>& expectedPeers);
+
+    TransferPhase Phase() const;
+    bool IsTerminal() const;
+
+    // Returns false (and changes nothing) for transitions the machine does
+    // not allow, e.g. leaving Done or going back to Announced
+    bool Advance(TransferPhase next, const char* reason);
+
+    // An empty peer ID is a legacy acknowledgement that doesn't name its
+    // sender; it counts for one expected peer. Returns AllAcknowledged().
+    bool Acknowledge(const std::string& peerId);
+    // Forgets expected peers that have left the room. Returns AllAcknowledged().
+    bool RetainPeers(const std::set<std::string>& present);
+    bool AllAcknowledged() const;
+
+    // "announced +0 ms, lan_serving +120 ms (pipeline), done +840 ms (acked)"
+    std::string Timeline() const;
+
+    static const char* PhaseName(TransferPhase phase);
+
+private:
+    struct Transition {
+        TransferPhase phase;
+        std::chrono::steady_clock::time_point at;
+        std::string reason;
+    };
+
+    bool AllAcknowledgedLocked() const;
+
+    mutable std::mutex m_mutex;
+    std::string m_id;
+    std::vector<Transition> m_history;
+    std::set<std::string> m_expected;
+    std::set<std::string> m_acked;
+    size_t m_anonymousAcks = 0;
+};
+
+}
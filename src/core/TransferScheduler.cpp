@@ -0,0 +1,219 @@
+#include "TransferScheduler.h"
+#include "Logger.h"
+#include "Metrics.h"
+
+namespace ClipboardPush {
+
+// Non-text limits add up to kWorkers - 1, so a text job never waits for a
+// slot behind images or files.
+static const size_t kWorkers = 6;
+static const size_t kClassLimits[] = { kWorkers, 2, 1, 1, 1 };
+
+TransferScheduler& TransferScheduler::Instance() {
+    static TransferScheduler instance;
+    return instance;
+}
+
+TransferClass TransferScheduler::Classify(const std::string& type, uint64_t bytes) {
+    if (type == "text" && bytes <= kTextBytes) return TransferClass::Text;
+    if (type == "image") return TransferClass::Image;
+    return bytes > kSmallFileBytes ? TransferClass::Bulk : TransferClass::SmallFile;
+}
+
+const char* TransferScheduler::ClassName(TransferClass cls) {
+    switch (cls) {
+        case TransferClass::Text: return "text";
+        case TransferClass::Image: return "image";
+        case TransferClass::SmallFile: return "file";
+        case TransferClass::Segment: return "segment";
+        default: return "bulk";
+    }
+}
+
+void TransferScheduler::Start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_workers.empty()) return;
+    m_stopping = false;
+    for (size_t i = 0; i < kWorkers; ++i) {
+        m_workers.emplace_back(&TransferScheduler::WorkerLoop, this);
+    }
+    LOG_INFO("Transfer scheduler started with %zu workers", kWorkers);
+}
+
+void TransferScheduler::Stop() {
+    std::vector<std::thread> workers;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+        for (auto& c : m_classes) c.byPeer.clear();
+        for (auto& r : m_running) *r.second.cancelled = true;
+        workers.swap(m_workers);
+        PublishLocked();
+    }
+    m_cv.notify_all();
+    // A worker may be inside a blocking network call; like LocalServer::Stop,
+    // don't hold up process exit waiting for it
+    for (auto& t : workers) t.detach();
+}
+
+TransferScheduler::JobId TransferScheduler::Submit(TransferClass cls, const std::string& peer, const std::string& label, Job job,
+    std::function<void()> dropped) {
+    Task task;
+    task.cls = cls;
+    task.peer = peer;
+    task.label = label;
+    task.job = std::move(job);
+    task.dropped = std::move(dropped);
+    task.cancelled = std::make_shared<std::atomic<bool>>(false);
+    task.queuedAt = std::chrono::steady_clock::now();
+    JobId id;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopping) return 0;
+        id = task.id = m_nextId++;
+        m_classes[(int)cls].byPeer[peer].push_back(std::move(task));
+        PublishLocked();
+    }
+    m_cv.notify_one();
+    LOG_DEBUG("Transfer queued: #%llu %s [%s] from %s", (unsigned long long)id, label.c_str(), ClassName(cls), peer.c_str());
+    return id;
+}
+
+bool TransferScheduler::Cancel(JobId id) {
+    std::function<void()> dropped;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto running = m_running.find(id);
+        if (running != m_running.end()) {
+            *running->second.cancelled = true;
+            return true;
+        }
+        bool found = false;
+        for (auto& c : m_classes) {
+            for (auto it = c.byPeer.begin(); it != c.byPeer.end(); ++it) {
+                auto& q = it->second;
+                auto t = std::find_if(q.begin(), q.end(), [id](const Task& task) { return task.id == id; });
+                if (t == q.end()) continue;
+                LOG_INFO("Transfer cancelled before start: %s", t->label.c_str());
+                dropped = std::move(t->dropped);
+                q.erase(t);
+                if (q.empty()) c.byPeer.erase(it);
+                PublishLocked();
+                found = true;
+                break;
+            }
+            if (found) break;
+        }
+        if (!found) return false;
+    }
+    // Outside the lock: it may well settle a transfer, which cancels jobs
+    if (dropped) dropped();
+    return true;
+}
+
+size_t TransferScheduler::CancelAll() {
+    std::vector<std::function<void()>> dropped;
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        count = m_running.size();
+        for (auto& r : m_running) *r.second.cancelled = true;
+        for (auto& c : m_classes) {
+            for (auto& q : c.byPeer) {
+                count += q.second.size();
+                for (auto& t : q.second) {
+                    if (t.dropped) dropped.push_back(std::move(t.dropped));
+                }
+            }
+            c.byPeer.clear();
+        }
+        PublishLocked();
+    }
+    if (count) LOG_INFO("Cancelled %zu transfer(s)", count);
+    for (auto& d : dropped) d();
+    return count;
+}
+
+TransferScheduler::Snapshot TransferScheduler::GetSnapshot() const {
+    Snapshot snap;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& r : m_running) {
+        snap.jobs.push_back({ r.first, r.second.cls, r.second.peer, r.second.label, true });
+        snap.running++;
+    }
+    for (const auto& c : m_classes) {
+        for (const auto& q : c.byPeer) {
+            for (const auto& t : q.second) {
+                snap.jobs.push_back({ t.id, t.cls, t.peer, t.label, false });
+                snap.queued++;
+            }
+        }
+    }
+    return snap;
+}
+
+bool TransferScheduler::PopLocked(Task& out) {
+    for (int i = 0; i < kClassCount; ++i) {
+        auto& c = m_classes[i];
+        if (c.byPeer.empty() || c.running >= kClassLimits[i]) continue;
+
+        // Next peer after the one served last, wrapping around
+        auto it = c.byPeer.upper_bound(c.lastPeer);
+        if (it == c.byPeer.end()) it = c.byPeer.begin();
+
+        out = std::move(it->second.front());
+        it->second.pop_front();
+        c.lastPeer = it->first;
+        if (it->second.empty()) c.byPeer.erase(it);
+        c.running++;
+        PublishLocked();
+        return true;
+    }
+    return false;
+}
+
+void TransferScheduler::PublishLocked() const {
+    for (int i = 0; i < kClassCount; ++i) {
+        size_t queued = 0;
+        for (const auto& q : m_classes[i].byPeer) queued += q.second.size();
+        Metrics::SchedulerQueued[i].Set((int64_t)queued);
+        Metrics::SchedulerRunning[i].Set((int64_t)m_classes[i].running);
+    }
+}
+
+void TransferScheduler::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        Task task;
+        m_cv.wait(lock, [&] { return m_stopping || PopLocked(task); });
+        if (m_stopping) return;
+
+        Job job = std::move(task.job);
+        auto dropped = std::move(task.dropped);
+        auto cancelled = task.cancelled;
+        JobId id = task.id;
+        TransferClass cls = task.cls;
+        Metrics::QueueWaitSeconds.Since(task.queuedAt);
+        m_running.emplace(id, std::move(task));
+        lock.unlock();
+
+        try {
+            // Cancelled between being picked and starting: never ran
+            if (!*cancelled) job(*cancelled);
+            else if (dropped) dropped();
+        } catch (const std::exception& e) {
+            LOG_ERROR("Transfer job failed: %s", e.what());
+        } catch (...) {
+            LOG_ERROR("Transfer job failed");
+        }
+
+        lock.lock();
+        m_running.erase(id);
+        m_classes[(int)cls].running--;
+        PublishLocked();
+        // A freed class slot may unblock a job another worker skipped
+        m_cv.notify_all();
+    }
+}
+
+}
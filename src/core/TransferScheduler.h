@@ -0,0 +1,113 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace ClipboardPush {
+
+// Priority classes, highest first
+enum class TransferClass {
+    Text = 0,
+    Image,
+    SmallFile,
+    Bulk,
+    // Relay segments of a bonded transfer. Its own pipeline or pull already
+    // holds the Bulk slot, so they need a slot of their own to overlap it.
+    Segment
+};
+
+// Fixed worker pool for transfer work: outgoing pushes, LAN pulls and relay
+// uploads/downloads. The highest class with a queued job that fits under its
+// concurrency limit runs next; within a class, peers take turns so one busy
+// sender cannot starve the others.
+class TransferScheduler {
+public:
+    using JobId = uint64_t;
+    // Long jobs should check `cancelled` between steps and return early
+    using Job = std::function<void(const std::atomic<bool>& cancelled)>;
+
+    struct JobInfo {
+        JobId id;
+        TransferClass cls;
+        std::string peer;
+        std::string label;
+        bool running;
+    };
+
+    struct Snapshot {
+        std::vector<JobInfo> jobs;
+        size_t running = 0;
+        size_t queued = 0;
+    };
+
+    static TransferScheduler& Instance();
+
+    // Files up to kSmallFileBytes (or of unknown size) are SmallFile. Text
+    // past kTextBytes goes by size like a file: it runs the chunk pipeline,
+    // and Text's limit is the whole pool.
+    static TransferClass Classify(const std::string& type, uint64_t bytes);
+    static const char* ClassName(TransferClass cls);
+
+    void Start();
+    // Cancels everything; workers finish their current step and exit
+    void Stop();
+
+    // `dropped` runs instead of the job if it is cancelled before it starts,
+    // so whatever the job would have settled or released isn't left hanging
+    JobId Submit(TransferClass cls, const std::string& peer, const std::string& label, Job job,
+        std::function<void()> dropped = nullptr);
+    // Queued jobs are dropped; running jobs see their cancel flag set
+    bool Cancel(JobId id);
+    size_t CancelAll();
+
+    Snapshot GetSnapshot() const;
+
+    static const uint64_t kTextBytes = 256 * 1024;
+    static const uint64_t kSmallFileBytes = 8 * 1024 * 1024;
+
+private:
+    TransferScheduler() = default;
+
+    static const int kClassCount = 5;
+
+    struct Task {
+        JobId id = 0;
+        TransferClass cls = TransferClass::Bulk;
+        std::string peer;
+        std::string label;
+        Job job;
+        std::function<void()> dropped;
+        std::shared_ptr<std::atomic<bool>> cancelled;
+        std::chrono::steady_clock::time_point queuedAt;
+    };
+
+    struct ClassQueue {
+        std::map<std::string, std::deque<Task>> byPeer;
+        std::string lastPeer; // round-robin cursor
+        size_t running = 0;
+    };
+
+    bool PopLocked(Task& out);
+    // Mirrors queue and running counts into the scheduler gauges
+    void PublishLocked() const;
+    void WorkerLoop();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    ClassQueue m_classes[kClassCount];
+    std::map<JobId, Task> m_running; // job callable is moved out while it runs
+    std::vector<std::thread> m_workers;
+    bool m_stopping = false;
+    JobId m_nextId = 1;
+};
+
+}
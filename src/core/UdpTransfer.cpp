@@ -0,0 +1,685 @@
+// MUST include winsock2 before windows.h
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include "UdpTransfer.h"
+#include "BlobStore.h"
+#include "Config.h"
+#include "Logger.h"
+#include "platform/MappedFile.h"
+#include <map>
+#include <deque>
+#include <memory>
+#include <random>
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+
+namespace ClipboardPush {
+
+// Wire format, little-endian. Every datagram starts with
+// [type u8][flags u8][reserved u16][session u32].
+enum PacketType : uint8_t {
+    kReq = 1,    // receiver: [room len u8][room][name len u8][name]
+    kMeta,       // sender:   [total u64][segment bytes u16][group u8]
+    kData,       // sender:   [seq u32][sent us u32][payload]
+    kParity,     // sender:   [group u32][sent us u32][XOR of the group's payloads]
+    kAck,        // receiver: [cum u32][bitmap u64][echo us u32][delay us u32]; flag 1 = repeat
+    kFin,        // receiver: done, or abort
+    kErr         // sender:   [code u8]
+};
+
+enum ErrCode : uint8_t { kNotReady = 1, kRefused = 2 };
+
+static const size_t kHeaderBytes = 8;
+static const size_t kSegmentBytes = 1400;        // payload; fits a 1500-byte MTU
+static const uint32_t kGroup = 8;                // data segments per parity segment
+static const size_t kMaxDatagram = 1500;
+static const uint64_t kMaxFetchBytes = 2ull * 1024 * 1024 * 1024; // the caller holds the plaintext
+
+// Congestion control
+static const double kTargetDelayUs = 20000;      // queueing delay LEDBAT aims for
+static const double kMinCwnd = 2 * kSegmentBytes;
+static const double kInitCwnd = 16 * kSegmentBytes;
+static const double kMaxCwnd = 8 * 1024 * 1024;
+static const double kPacingGain = 1.25;
+static const uint32_t kDupThresh = 3;
+static const int64_t kMinRtoUs = 50000;         // LAN RTTs are a millisecond or two
+static const int64_t kMaxRtoUs = 2000000;
+static const int64_t kBaseDelayWindowUs = 60000000;
+static const int64_t kSessionIdleUs = 10000000;
+static const int kMaxBurst = 64;                 // packets per pump before polling the socket again
+
+// Receiver
+static const int kAckEvery = 4;
+static const int64_t kAckDelayUs = 2000;
+static const int64_t kReAckUs = 10000;           // repeat the last ack when the sender goes quiet
+static const int64_t kReqIntervalUs = 100000;
+
+static int64_t NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void Put16(uint8_t* p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void Put32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; ++i) p[i] = (uint8_t)(v >> (8 * i)); }
+static void Put64(uint8_t* p, uint64_t v) { for (int i = 0; i < 8; ++i) p[i] = (uint8_t)(v >> (8 * i)); }
+static uint16_t Get16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static uint32_t Get32(const uint8_t* p) { uint32_t v = 0; for (int i = 3; i >= 0; --i) v = (v << 8) | p[i]; return v; }
+static uint64_t Get64(const uint8_t* p) { uint64_t v = 0; for (int i = 7; i >= 0; --i) v = (v << 8) | p[i]; return v; }
+
+static void PutHeader(uint8_t* p, PacketType type, uint8_t flags, uint32_t session) {
+    p[0] = type;
+    p[1] = flags;
+    Put16(p + 2, 0);
+    Put32(p + 4, session);
+}
+
+static size_t SegmentLen(uint64_t total, uint32_t seq) {
+    uint64_t off = (uint64_t)seq * kSegmentBytes;
+    return (size_t)std::min<uint64_t>(kSegmentBytes, total - off);
+}
+
+// ---------------------------------------------------------------- sender
+
+namespace {
+
+enum SegState : uint8_t { kUnsent = 0, kInFlight, kAcked, kLost };
+
+struct Session {
+    sockaddr_in peer = {};
+    uint32_t id = 0;
+    std::string blobId;
+    std::unique_ptr<Platform::MappedFile> file;
+    uint64_t total = 0;
+    uint32_t segs = 0;
+
+    std::vector<uint32_t> sentAt;  // low 32 bits of NowUs at the last transmission
+    std::vector<uint8_t> state;
+    std::deque<uint32_t> retransmit;
+    uint32_t nextNew = 0;
+    uint32_t cum = 0;              // every segment below is acked
+    uint32_t acked = 0;
+    uint32_t highest = 0;          // highest acked segment + 1
+    int64_t parityGroup = -1;      // group whose parity goes out next
+
+    double cwnd = kInitCwnd;
+    bool slowStart = true;
+    double inflight = 0;
+    double srtt = 0;
+    double rttvar = 0;
+    int64_t rto = kMinRtoUs;
+
+    uint32_t baseCur = 0, basePrev = 0;
+    bool haveBase = false;
+    int64_t baseRolled = 0;
+    uint32_t recentDelay[4] = {};
+    int recentCount = 0;
+
+    int64_t nextSend = 0;
+    int64_t lastHeard = 0;
+    int64_t lastProgress = 0;
+    int64_t lastReduction = 0;
+    bool finished = false;
+};
+
+}
+
+static std::string SessionKey(const sockaddr_in& from, uint32_t id) {
+    return std::to_string(from.sin_addr.s_addr) + ":" + std::to_string(from.sin_port) + ":" + std::to_string(id);
+}
+
+static void SendTo(SOCKET s, const sockaddr_in& to, const uint8_t* data, size_t len) {
+    sendto(s, (const char*)data, (int)len, 0, (const sockaddr*)&to, sizeof(to));
+}
+
+static void SendErr(SOCKET s, const sockaddr_in& to, uint32_t session, ErrCode code) {
+    uint8_t pkt[kHeaderBytes + 1];
+    PutHeader(pkt, kErr, 0, session);
+    pkt[kHeaderBytes] = code;
+    SendTo(s, to, pkt, sizeof(pkt));
+}
+
+static void SendMeta(SOCKET s, const Session& ss) {
+    uint8_t pkt[kHeaderBytes + 11];
+    PutHeader(pkt, kMeta, 0, ss.id);
+    Put64(pkt + kHeaderBytes, ss.total);
+    Put16(pkt + kHeaderBytes + 8, (uint16_t)kSegmentBytes);
+    pkt[kHeaderBytes + 10] = (uint8_t)kGroup;
+    SendTo(s, ss.peer, pkt, sizeof(pkt));
+}
+
+static void SendSegment(SOCKET s, Session& ss, uint32_t seq, int64_t now) {
+    uint8_t pkt[kHeaderBytes + 8 + kSegmentBytes];
+    size_t len = SegmentLen(ss.total, seq);
+    PutHeader(pkt, kData, 0, ss.id);
+    Put32(pkt + kHeaderBytes, seq);
+    Put32(pkt + kHeaderBytes + 4, (uint32_t)now);
+    memcpy(pkt + kHeaderBytes + 8, ss.file->Data() + (uint64_t)seq * kSegmentBytes, len);
+    SendTo(s, ss.peer, pkt, kHeaderBytes + 8 + len);
+
+    ss.sentAt[seq] = (uint32_t)now;
+    ss.state[seq] = kInFlight;
+    ss.inflight += len;
+}
+
+static void SendParity(SOCKET s, Session& ss, uint32_t group, int64_t now) {
+    uint8_t pkt[kHeaderBytes + 8 + kSegmentBytes] = {};
+    PutHeader(pkt, kParity, 0, ss.id);
+    Put32(pkt + kHeaderBytes, group);
+    Put32(pkt + kHeaderBytes + 4, (uint32_t)now);
+    uint8_t* out = pkt + kHeaderBytes + 8;
+    uint32_t first = group * kGroup;
+    uint32_t last = std::min(first + kGroup, ss.segs);
+    for (uint32_t seq = first; seq < last; ++seq) {
+        const uint8_t* in = ss.file->Data() + (uint64_t)seq * kSegmentBytes;
+        size_t len = SegmentLen(ss.total, seq);
+        for (size_t i = 0; i < len; ++i) out[i] ^= in[i];
+    }
+    SendTo(s, ss.peer, pkt, sizeof(pkt));
+}
+
+static int64_t PacingGapUs(const Session& ss, size_t bytes) {
+    double rtt = ss.srtt > 0 ? ss.srtt : 2000;
+    double bytesPerUs = kPacingGain * ss.cwnd / rtt;
+    return (int64_t)(bytes / bytesPerUs);
+}
+
+// Sends what the window and the pacer allow right now
+static void Pump(SOCKET s, Session& ss, int64_t now) {
+    for (int sent = 0; sent < kMaxBurst && now >= ss.nextSend; ++sent) {
+        size_t bytes = 0;
+        while (!ss.retransmit.empty() && ss.state[ss.retransmit.front()] == kAcked) ss.retransmit.pop_front();
+
+        if (!ss.retransmit.empty() && ss.inflight + kSegmentBytes <= ss.cwnd) {
+            uint32_t seq = ss.retransmit.front();
+            ss.retransmit.pop_front();
+            SendSegment(s, ss, seq, now);
+            bytes = SegmentLen(ss.total, seq);
+        } else if (ss.parityGroup >= 0) {
+            SendParity(s, ss, (uint32_t)ss.parityGroup, now);
+            ss.parityGroup = -1;
+            bytes = kSegmentBytes;
+        } else if (ss.nextNew < ss.segs && ss.inflight + kSegmentBytes <= ss.cwnd) {
+            uint32_t seq = ss.nextNew++;
+            SendSegment(s, ss, seq, now);
+            bytes = SegmentLen(ss.total, seq);
+            if (seq % kGroup == kGroup - 1 || seq == ss.segs - 1) ss.parityGroup = seq / kGroup;
+        } else {
+            return;
+        }
+        // Don't bank more than a millisecond of unused pacing credit
+        ss.nextSend = std::max(ss.nextSend, now - 1000) + PacingGapUs(ss, bytes);
+    }
+}
+
+static void MarkAcked(Session& ss, uint32_t seq, double& newlyAcked) {
+    if (seq >= ss.segs || ss.state[seq] == kAcked) return;
+    size_t len = SegmentLen(ss.total, seq);
+    if (ss.state[seq] == kInFlight) ss.inflight -= len;
+    ss.state[seq] = kAcked;
+    ss.acked++;
+    newlyAcked += len;
+    ss.highest = std::max(ss.highest, seq + 1);
+}
+
+// Wi-Fi drops packets at random; only loss that comes with a standing queue
+// is taken as congestion
+static void OnLoss(Session& ss, double queueing, int64_t now) {
+    if (queueing < kTargetDelayUs / 4) return;
+    ss.slowStart = false;
+    if (now - ss.lastReduction < (int64_t)std::max(ss.srtt, 1000.0)) return; // once per RTT
+    ss.cwnd = std::max(ss.cwnd / 2, kMinCwnd);
+    ss.lastReduction = now;
+}
+
+static void OnAck(Session& ss, const uint8_t* p, size_t len, int64_t now) {
+    if (len < kHeaderBytes + 20) return;
+    uint32_t cum = Get32(p + kHeaderBytes);
+    uint64_t bitmap = Get64(p + kHeaderBytes + 4);
+    uint32_t echo = Get32(p + kHeaderBytes + 12);
+    uint32_t delay = Get32(p + kHeaderBytes + 16);
+    bool repeat = (p[1] & 1) != 0; // its timestamps are stale
+    ss.lastHeard = now;
+
+    // RTT from the echoed send time of the packet that triggered this ack
+    uint32_t rtt = (uint32_t)now - echo;
+    if (!repeat && rtt < 10000000) {
+        if (ss.srtt == 0) {
+            ss.srtt = rtt;
+            ss.rttvar = rtt / 2.0;
+        } else {
+            ss.rttvar = 0.75 * ss.rttvar + 0.25 * std::abs(ss.srtt - rtt);
+            ss.srtt = 0.875 * ss.srtt + 0.125 * rtt;
+        }
+        ss.rto = std::min(std::max((int64_t)(ss.srtt + 4 * ss.rttvar), kMinRtoUs), kMaxRtoUs);
+    }
+
+    // One-way delay relative to the lowest seen recently. The two clocks
+    // differ by an unknown offset that cancels out of the difference.
+    if (repeat) delay = ss.recentCount ? ss.recentDelay[(ss.recentCount - 1) % 4] : ss.baseCur;
+    if (!ss.haveBase || now - ss.baseRolled > kBaseDelayWindowUs) {
+        ss.basePrev = ss.haveBase ? ss.baseCur : delay;
+        ss.baseCur = delay;
+        ss.baseRolled = now;
+        ss.haveBase = true;
+    }
+    if ((int32_t)(delay - ss.baseCur) < 0) ss.baseCur = delay;
+    uint32_t base = (int32_t)(ss.basePrev - ss.baseCur) < 0 ? ss.basePrev : ss.baseCur;
+    ss.recentDelay[ss.recentCount++ % 4] = delay;
+    double queueing = 1e18;
+    for (int i = 0; i < std::min(ss.recentCount, 4); ++i) {
+        queueing = std::min(queueing, (double)std::max<int32_t>(0, (int32_t)(ss.recentDelay[i] - base)));
+    }
+
+    double newlyAcked = 0;
+    for (uint32_t seq = ss.cum; seq < std::min(cum, ss.segs); ++seq) MarkAcked(ss, seq, newlyAcked);
+    ss.cum = std::max(ss.cum, cum);
+    for (int i = 0; i < 64; ++i) {
+        if (bitmap & (1ull << i)) MarkAcked(ss, cum + 1 + i, newlyAcked);
+    }
+    if (newlyAcked > 0) {
+        ss.lastProgress = now;
+        ss.rto = std::max(kMinRtoUs, std::min(ss.rto, (int64_t)(ss.srtt + 4 * ss.rttvar)));
+    }
+
+    // Anything sent before the packet this ack answers, and overtaken by
+    // kDupThresh later segments, was lost
+    bool lost = false;
+    if (ss.highest > kDupThresh) {
+        for (uint32_t seq = ss.cum; seq + kDupThresh < ss.highest; ++seq) {
+            if (ss.state[seq] != kInFlight || (int32_t)(echo - ss.sentAt[seq]) <= 0) continue;
+            ss.state[seq] = kLost;
+            ss.inflight -= SegmentLen(ss.total, seq);
+            ss.retransmit.push_back(seq);
+            lost = true;
+        }
+    }
+    if (lost) OnLoss(ss, queueing, now);
+
+    if (newlyAcked > 0) {
+        if (ss.slowStart && queueing > kTargetDelayUs / 2) ss.slowStart = false;
+        if (ss.slowStart) {
+            ss.cwnd += newlyAcked;
+        } else {
+            // LEDBAT: grow while queueing delay is under target, shrink above it
+            double offTarget = (kTargetDelayUs - queueing) / kTargetDelayUs;
+            ss.cwnd += offTarget * newlyAcked * kSegmentBytes / ss.cwnd;
+        }
+        ss.cwnd = std::min(std::max(ss.cwnd, kMinCwnd), kMaxCwnd);
+    }
+}
+
+// Nothing acked for a whole RTO: assume everything in flight is gone
+static void CheckRto(Session& ss, int64_t now) {
+    if (ss.inflight <= 0 || now - ss.lastProgress < ss.rto) return;
+    for (uint32_t seq = ss.cum; seq < ss.nextNew; ++seq) {
+        if (ss.state[seq] != kInFlight) continue;
+        ss.state[seq] = kLost;
+        ss.retransmit.push_back(seq);
+    }
+    std::sort(ss.retransmit.begin(), ss.retransmit.end());
+    ss.retransmit.erase(std::unique(ss.retransmit.begin(), ss.retransmit.end()), ss.retransmit.end());
+    ss.inflight = 0;
+    ss.cwnd = kMinCwnd;
+    ss.slowStart = false;
+    ss.lastProgress = now;
+    ss.rto = std::min(ss.rto * 2, kMaxRtoUs);
+}
+
+UdpTransfer& UdpTransfer::Instance() {
+    static UdpTransfer instance;
+    return instance;
+}
+
+bool UdpTransfer::Start(int port) {
+    if (m_running) return true;
+
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_SOCKET) {
+        WSACleanup();
+        return false;
+    }
+    sockaddr_in local = {};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = htons((unsigned short)port);
+    if (bind(s, (sockaddr*)&local, sizeof(local)) == SOCKET_ERROR) {
+        LOG_ERROR("UDP transfer: cannot bind port %d (%d)", port, WSAGetLastError());
+        closesocket(s);
+        WSACleanup();
+        return false;
+    }
+    u_long nonBlocking = 1;
+    ioctlsocket(s, FIONBIO, &nonBlocking);
+    int buf = 4 * 1024 * 1024;
+    setsockopt(s, SOL_SOCKET, SO_SNDBUF, (const char*)&buf, sizeof(buf));
+    setsockopt(s, SOL_SOCKET, SO_RCVBUF, (const char*)&buf, sizeof(buf));
+
+    m_port = port;
+    m_socket = (uintptr_t)s;
+    m_running = true;
+    m_thread = std::thread(&UdpTransfer::Run, this);
+    LOG_INFO("UDP transfer serving on port %d", port);
+    return true;
+}
+
+void UdpTransfer::Stop() {
+    m_running = false;
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void UdpTransfer::Run() {
+    SOCKET s = (SOCKET)m_socket;
+    std::map<std::string, Session> sessions;
+    uint8_t buf[kMaxDatagram];
+
+    auto finish = [](Session& ss) {
+        if (ss.file) ss.file->Close();
+        if (!ss.blobId.empty()) BlobStore::Instance().Release(ss.blobId);
+        ss.blobId.clear();
+    };
+
+    while (m_running) {
+        // Sleep until the earliest paced send, a datagram, or 20 ms
+        int64_t now = NowUs();
+        int64_t wait = 20000;
+        for (auto& kv : sessions) {
+            const Session& ss = kv.second;
+            bool canSend = ss.parityGroup >= 0 || ((!ss.retransmit.empty() || ss.nextNew < ss.segs) && ss.inflight + kSegmentBytes <= ss.cwnd);
+            if (canSend) wait = std::min(wait, std::max<int64_t>(0, ss.nextSend - now));
+        }
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(s, &readable);
+        timeval tv = { 0, (long)wait };
+        select((int)s + 1, &readable, NULL, NULL, &tv);
+
+        for (;;) {
+            sockaddr_in from = {};
+            socklen_t fromLen = sizeof(from);
+            int n = recvfrom(s, (char*)buf, sizeof(buf), 0, (sockaddr*)&from, &fromLen);
+            if (n < (int)kHeaderBytes) {
+                if (n < 0) break;
+                continue;
+            }
+            now = NowUs();
+            uint8_t type = buf[0];
+            uint32_t id = Get32(buf + 4);
+            std::string key = SessionKey(from, id);
+            auto it = sessions.find(key);
+
+            if (type == kReq) {
+                if (it != sessions.end()) {
+                    SendMeta(s, it->second); // our META was lost
+                    continue;
+                }
+                size_t pos = kHeaderBytes;
+                if ((size_t)n < pos + 1 || (size_t)n < pos + 1 + buf[pos]) continue;
+                std::string room((const char*)buf + pos + 1, buf[pos]);
+                pos += 1 + buf[pos];
+                if ((size_t)n < pos + 1 || (size_t)n < pos + 1 + buf[pos]) continue;
+                std::string name((const char*)buf + pos + 1, buf[pos]);
+
+                if (room != Config::Instance().Get()->room_id || !BlobStore::IsValidName(name)) {
+                    SendErr(s, from, id, kRefused);
+                    continue;
+                }
+                // Chunked transfers seal their blob only at the end; the receiver asks again
+                auto blob = BlobStore::Instance().Acquire(name);
+                if (!blob) {
+                    SendErr(s, from, id, kNotReady);
+                    continue;
+                }
+                auto file = std::make_unique<Platform::MappedFile>();
+                if (!file->Open(blob->path.wstring()) || file->Size() == 0) {
+                    BlobStore::Instance().Release(blob->id);
+                    SendErr(s, from, id, kRefused);
+                    continue;
+                }
+
+                Session& ss = sessions[key];
+                ss.peer = from;
+                ss.id = id;
+                ss.blobId = blob->id;
+                ss.total = file->Size();
+                ss.file = std::move(file);
+                ss.segs = (uint32_t)((ss.total + kSegmentBytes - 1) / kSegmentBytes);
+                ss.sentAt.assign(ss.segs, 0);
+                ss.state.assign(ss.segs, kUnsent);
+                ss.nextSend = ss.lastHeard = ss.lastProgress = now;
+                SendMeta(s, ss);
+                LOG_INFO("UDP transfer: sending %s (%llu bytes)", name.c_str(), (unsigned long long)ss.total);
+            } else if (it != sessions.end() && type == kAck) {
+                OnAck(it->second, buf, (size_t)n, now);
+            } else if (it != sessions.end() && type == kFin) {
+                it->second.finished = true;
+            }
+        }
+
+        now = NowUs();
+        for (auto it = sessions.begin(); it != sessions.end();) {
+            Session& ss = it->second;
+            if (ss.finished || ss.acked == ss.segs || now - ss.lastHeard > kSessionIdleUs) {
+                if (ss.acked == ss.segs) {
+                    LOG_INFO("UDP transfer: %s delivered, cwnd %.0f KB, srtt %.1f ms", ss.blobId.c_str(), ss.cwnd / 1024, ss.srtt / 1000);
+                }
+                finish(ss);
+                it = sessions.erase(it);
+                continue;
+            }
+            CheckRto(ss, now);
+            Pump(s, ss, now);
+            ++it;
+        }
+    }
+
+    for (auto& kv : sessions) finish(kv.second);
+    closesocket(s);
+    WSACleanup();
+}
+
+// ---------------------------------------------------------------- receiver
+
+bool UdpTransfer::Fetch(const std::string& host, int port, const std::string& name, const std::string& roomId,
+    std::chrono::milliseconds idleTimeout, const std::atomic<bool>& cancelled, const Sink& sink) {
+    if (name.size() > 255 || roomId.size() > 255) return false;
+
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+    SOCKET s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_SOCKET) {
+        WSACleanup();
+        return false;
+    }
+    struct Closer {
+        SOCKET s;
+        ~Closer() { closesocket(s); WSACleanup(); }
+    } closer{ s };
+
+    sockaddr_in server = {};
+    server.sin_family = AF_INET;
+    server.sin_port = htons((unsigned short)port);
+    if (inet_pton(AF_INET, host.c_str(), &server.sin_addr) != 1) return false;
+    // Only the server's datagrams get through
+    if (connect(s, (sockaddr*)&server, sizeof(server)) == SOCKET_ERROR) return false;
+    u_long nonBlocking = 1;
+    ioctlsocket(s, FIONBIO, &nonBlocking);
+    int sockBuf = 4 * 1024 * 1024;
+    setsockopt(s, SOL_SOCKET, SO_RCVBUF, (const char*)&sockBuf, sizeof(sockBuf));
+
+    std::random_device rd;
+    uint32_t session = ((uint32_t)rd() << 1) | 1;
+
+    std::vector<uint8_t> req(kHeaderBytes + 2 + roomId.size() + name.size());
+    PutHeader(req.data(), kReq, 0, session);
+    req[kHeaderBytes] = (uint8_t)roomId.size();
+    memcpy(req.data() + kHeaderBytes + 1, roomId.data(), roomId.size());
+    req[kHeaderBytes + 1 + roomId.size()] = (uint8_t)name.size();
+    memcpy(req.data() + kHeaderBytes + 2 + roomId.size(), name.data(), name.size());
+
+    auto sendFin = [&](uint8_t flags) {
+        uint8_t fin[kHeaderBytes];
+        PutHeader(fin, kFin, flags, session);
+        send(s, (const char*)fin, sizeof(fin), 0);
+    };
+
+    bool haveMeta = false;
+    uint64_t total = 0;
+    uint32_t segs = 0;
+    // Segments not yet handed to the sink. Whole parity groups go out in
+    // order once complete, so what is held is bounded by the sender's window
+    // (plus one group), not by the blob size.
+    std::map<uint32_t, std::vector<uint8_t>> held;
+    uint32_t delivered = 0;
+    bool sinkFailed = false;
+    std::vector<uint8_t> have;
+    uint32_t count = 0;
+    uint32_t cum = 0;
+    std::map<uint32_t, std::vector<uint8_t>> parity;
+
+    int64_t idleUs = std::chrono::duration_cast<std::chrono::microseconds>(idleTimeout).count();
+    int64_t lastHeard = NowUs();
+    int64_t lastReq = 0;
+    int64_t lastAck = 0;
+    int pending = 0;          // data packets since the last ack
+    bool ackNow = false;
+    uint32_t lastTs = 0;      // sender's timestamp on the newest data packet
+    int64_t lastTsAt = 0;     // and when it arrived
+    uint8_t buf[kMaxDatagram];
+
+    auto store = [&](uint32_t seq, const uint8_t* payload) {
+        if (seq >= segs || have[seq]) return;
+        held[seq].assign(payload, payload + SegmentLen(total, seq));
+        have[seq] = 1;
+        count++;
+        while (cum < segs && have[cum]) cum++;
+        // A group is only released once all of it is here, so a parity
+        // repair never needs a segment that has already gone to the sink
+        while (!sinkFailed && delivered < cum && (cum - delivered >= kGroup || cum == segs)) {
+            uint32_t end = std::min(delivered + kGroup, segs);
+            for (; delivered < end; ++delivered) {
+                auto it = held.find(delivered);
+                if (!sink(it->second.data(), it->second.size())) sinkFailed = true;
+                held.erase(it);
+            }
+        }
+    };
+    // One missing segment in a group is the parity XOR the rest
+    auto repair = [&](uint32_t group) {
+        auto p = parity.find(group);
+        if (p == parity.end()) return;
+        uint32_t first = group * kGroup;
+        uint32_t last = std::min(first + kGroup, segs);
+        uint32_t missing = segs;
+        for (uint32_t seq = first; seq < last; ++seq) {
+            if (have[seq]) continue;
+            if (missing != segs) return;
+            missing = seq;
+        }
+        if (missing != segs) {
+            std::vector<uint8_t> out = p->second;
+            for (uint32_t seq = first; seq < last; ++seq) {
+                if (seq == missing) continue;
+                const uint8_t* in = held[seq].data();
+                size_t len = SegmentLen(total, seq);
+                for (size_t i = 0; i < len; ++i) out[i] ^= in[i];
+            }
+            store(missing, out.data());
+            ackNow = true;
+        }
+        parity.erase(p);
+    };
+
+    for (;;) {
+        int64_t now = NowUs();
+        if (cancelled || sinkFailed) {
+            sendFin(1);
+            return false;
+        }
+        if (now - lastHeard > idleUs) {
+            LOG_WARNING("UDP transfer: %s timed out (%u/%u segments)", name.c_str(), count, segs);
+            sendFin(1);
+            return false;
+        }
+        if (!haveMeta && now - lastReq >= kReqIntervalUs) {
+            send(s, (const char*)req.data(), (int)req.size(), 0);
+            lastReq = now;
+        }
+
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(s, &readable);
+        timeval tv = { 0, pending > 0 ? (long)kAckDelayUs : (long)kReAckUs };
+        select((int)s + 1, &readable, NULL, NULL, &tv);
+
+        for (;;) {
+            int n = recv(s, (char*)buf, sizeof(buf), 0);
+            if (n < 0) break;
+            if (n < (int)kHeaderBytes || Get32(buf + 4) != session) continue;
+            lastHeard = NowUs();
+            uint8_t type = buf[0];
+
+            if (type == kErr && n > (int)kHeaderBytes) {
+                if (buf[kHeaderBytes] == kNotReady) continue;
+                LOG_WARNING("UDP transfer: %s refused by sender", name.c_str());
+                return false;
+            } else if (type == kMeta && !haveMeta && n >= (int)kHeaderBytes + 11) {
+                total = Get64(buf + kHeaderBytes);
+                if (total == 0 || total > kMaxFetchBytes || Get16(buf + kHeaderBytes + 8) != kSegmentBytes || buf[kHeaderBytes + 10] != kGroup) {
+                    sendFin(1);
+                    return false;
+                }
+                segs = (uint32_t)((total + kSegmentBytes - 1) / kSegmentBytes);
+                have.assign(segs, 0);
+                haveMeta = true;
+            } else if (type == kData && haveMeta && n > (int)kHeaderBytes + 8) {
+                uint32_t seq = Get32(buf + kHeaderBytes);
+                if (seq >= segs || (size_t)n - kHeaderBytes - 8 != SegmentLen(total, seq)) continue;
+                lastTs = Get32(buf + kHeaderBytes + 4);
+                lastTsAt = lastHeard;
+                if (seq != cum) ackNow = true; // a hole or a duplicate: tell the sender at once
+                store(seq, buf + kHeaderBytes + 8);
+                repair(seq / kGroup);
+                pending++;
+            } else if (type == kParity && haveMeta && n == (int)(kHeaderBytes + 8 + kSegmentBytes)) {
+                uint32_t group = Get32(buf + kHeaderBytes);
+                if ((uint64_t)group * kGroup >= segs) continue;
+                parity[group].assign(buf + kHeaderBytes + 8, buf + n);
+                repair(group);
+            }
+        }
+
+        if (haveMeta && count == segs && !sinkFailed) {
+            for (int i = 0; i < 3; ++i) sendFin(0);
+            return true;
+        }
+
+        now = NowUs();
+        // A lost ack at the end of a window would otherwise stall the sender
+        // until its retransmit timeout
+        bool reAck = haveMeta && lastAck > 0 && now - lastAck >= kReAckUs;
+        if ((pending > 0 && (ackNow || pending >= kAckEvery || now - lastAck >= kAckDelayUs)) || reAck) {
+            uint8_t ack[kHeaderBytes + 20];
+            PutHeader(ack, kAck, pending == 0 ? 1 : 0, session);
+            uint64_t bitmap = 0;
+            for (int i = 0; i < 64 && cum + 1 + i < segs; ++i) {
+                if (have[cum + 1 + i]) bitmap |= 1ull << i;
+            }
+            Put32(ack + kHeaderBytes, cum);
+            Put64(ack + kHeaderBytes + 4, bitmap);
+            Put32(ack + kHeaderBytes + 12, lastTs);
+            Put32(ack + kHeaderBytes + 16, (uint32_t)lastTsAt - lastTs);
+            send(s, (const char*)ack, sizeof(ack), 0);
+            lastAck = now;
+            pending = 0;
+            ackNow = false;
+        }
+
+        // Parity for groups that are already complete is dead weight
+        while (!parity.empty() && (uint64_t)(parity.begin()->first + 1) * kGroup <= cum) parity.erase(parity.begin());
+    }
+}
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+
+namespace ClipboardPush {
+
+// Optional LAN bulk transport over UDP, for Wi-Fi links where TCP loses most
+// of its throughput to random loss. A receiver asks the sender's server for
+// a blob by name and the server streams that blob's bytes, which are already
+// the sealed envelope, in fixed-size segments:
+// - selective acks: a cumulative ack plus a bitmap of the 64 segments after it
+// - LEDBAT delay-based congestion window with slow start, paced over the RTT
+// - one XOR parity segment per group of 8, so a single loss in a group is
+//   repaired without waiting for a retransmit
+// Nothing travels in clear. A corrupted or injected segment makes the GCM tag
+// check fail once the stream ends, and the caller falls back to HTTP.
+class UdpTransfer {
+public:
+    static UdpTransfer& Instance();
+
+    // Serves BlobStore blobs (by ID or alias) on UDP `port`
+    bool Start(int port);
+    void Stop();
+    // 0 when not serving
+    int Port() const { return m_running ? m_port : 0; }
+
+    // Receives the blob's bytes in order; returning false aborts the fetch
+    using Sink = std::function<bool(const uint8_t* data, size_t len)>;
+
+    // Blocks until the whole blob has gone through `sink`, which sees it as
+    // it arrives rather than once reassembled. False on refusal,
+    // cancellation, a sink failure or `idleTimeout` without a packet from the
+    // server; the sink may have seen part of the blob by then.
+    static bool Fetch(const std::string& host, int port, const std::string& name, const std::string& roomId,
+        std::chrono::milliseconds idleTimeout, const std::atomic<bool>& cancelled, const Sink& sink);
+
+private:
+    UdpTransfer() = default;
+
+    void Run();
+
+    int m_port = 0;
+    uintptr_t m_socket = 0;
+    std::thread m_thread;
+    std::atomic<bool> m_running{ false };
+};
+
+}
@@ -6,14 +6,12 @@
 #endif
 #include <winsock2.h>
 #include <ws2tcpip.h>
-#include <iphlpapi.h>
 #include <windows.h>
 #include <shellapi.h>
 
 #include <string>
 #include <vector>
 
-#pragma comment(lib, "iphlpapi.lib")
 #pragma comment(lib, "ws2_32.lib")
 #pragma comment(lib, "shell32.lib")
 
@@ -42,64 +40,6 @@ inline std::string ToUtf8(const std::wstring& wstr) {
     return strTo;
 }
 
-struct NetworkMetadata {
-    std::string private_ip = "127.0.0.1";
-    std::string cidr = "127.0.0.1/32";
-    std::string network_id_hash = "";
-    int network_epoch = 0;
-};
-
-inline NetworkMetadata GetNetworkMetadata() {
-    ULONG outBufLen = 15000;
-    std::vector<uint8_t> buffer(outBufLen);
-    PIP_ADAPTER_ADDRESSES pAddresses = reinterpret_cast<PIP_ADAPTER_ADDRESSES>(buffer.data());
-
-    NetworkMetadata meta;
-    int bestScore = -1;
-
-    if (GetAdaptersAddresses(AF_INET, GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST | GAA_FLAG_SKIP_DNS_SERVER, NULL, pAddresses, &outBufLen) == ERROR_SUCCESS) {
-        for (PIP_ADAPTER_ADDRESSES pCurrAddresses = pAddresses; pCurrAddresses != NULL; pCurrAddresses = pCurrAddresses->Next) {
-            if (pCurrAddresses->OperStatus != IfOperStatusUp) continue;
-            if (pCurrAddresses->IfType == IF_TYPE_SOFTWARE_LOOPBACK) continue;
-            
-            std::wstring desc = pCurrAddresses->Description;
-            if (desc.find(L"VMware") != std::wstring::npos || desc.find(L"VirtualBox") != std::wstring::npos) continue;
-
-            for (PIP_ADAPTER_UNICAST_ADDRESS pUnicast = pCurrAddresses->FirstUnicastAddress; pUnicast != NULL; pUnicast = pUnicast->Next) {
-                sockaddr_in* sa_in = reinterpret_cast<sockaddr_in*>(pUnicast->Address.lpSockaddr);
-                char addr[INET_ADDRSTRLEN];
-                inet_ntop(AF_INET, &(sa_in->sin_addr), addr, INET_ADDRSTRLEN);
-                
-                std::string ip(addr);
-                if (ip == "127.0.0.1") continue;
-
-                int score = 0;
-                if (ip.substr(0, 8) == "192.168.") score = 100;
-                else if (ip.substr(0, 3) == "10." && ip.substr(0, 7) != "10.100.") score = 90;
-                else if (ip.substr(0, 4) == "172.") score = 80;
-                else if (ip.substr(0, 7) == "100.64.") score = 10;
-                else score = 50;
-
-                if (score > bestScore) {
-                    bestScore = score;
-                    meta.private_ip = ip;
-                    
-                    // Calculate CIDR suffix manually
-                    meta.cidr = ip + "/" + std::to_string(pUnicast->OnLinkPrefixLength);
-                    
-                    // Use AdapterName as a simple unique network ID (GUID string)
-                    meta.network_id_hash = pCurrAddresses->AdapterName;
-                }
-            }
-        }
-    }
-    return meta;
-}
-
-inline std::string GetLocalIPAddress() {
-    return GetNetworkMetadata().private_ip;
-}
-
 inline std::string Trim(const std::string& s) {
     auto start = s.begin();
     while (start != s.end() && std::isspace((unsigned char)*start)) {
@@ -10,6 +10,8 @@
 #include "core/SocketIOService.h"
 #include "core/LocalServer.h"
 #include "platform/ClipboardMonitor.h"
+#include "platform/MappedFile.h"
+#include "platform/NetworkMonitor.h"
 #include "ui/TrayIcon.h"
 #include "ui/MainWindow.h"
 #include "ui/SettingsWindow.h"
@@ -19,17 +21,37 @@
 #include "core/Crypto.h"
 #include "core/Network.h"
 #include "core/Version.h"
+#include "core/Hash.h"
+#include "core/TextDelta.h"
+#include "core/Debouncer.h"
+#include "core/EchoCache.h"
+#include "core/Chunker.h"
+#include "core/ChunkStore.h"
+#include "core/ChunkPipeline.h"
+#include "core/BlobStore.h"
+#include "core/TransferScheduler.h"
+#include "core/TransferLifecycle.h"
+#include "core/TimerWheel.h"
+#include "core/RaceEstimator.h"
+#include "core/PeerStats.h"
+#include "core/Metrics.h"
+#include "core/LanDiscovery.h"
+#include "core/UdpTransfer.h"
+#include "core/NetworkInfo.h"
 #include <chrono>
 #include <iomanip>
 #include <sstream>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <map>
+#include <set>
 
 #include <filesystem>
 #include <fstream>
 
 #define WM_TRAYICON (WM_USER + 1)
+#define IDT_AUTO_PUSH 1
 
 using namespace ClipboardPush;
 namespace fs = std::filesystem;
@@ -37,25 +59,77 @@ namespace fs = std::filesystem;
 namespace ClipboardPush {
 
 // Global state for sync logic
-static bool g_isProcessingRemoteSync = false;
 static std::atomic<int> g_activePeerCount{ 0 };
 
+// Fingerprints of content applied from peers, consulted before auto-push
+static EchoCache g_echoCache{ 64, std::chrono::seconds(30) };
+
+// Transfers already delivered here; a racing LAN pull and relay download of
+// the same transfer_id must only be applied once
+static EchoCache g_receivedTransfers{ 256, std::chrono::minutes(10) };
+
+// Queued or running LAN pulls, so a relay delivery can cancel its loser
+static std::mutex g_incomingMutex;
+static std::map<std::string, TransferScheduler::JobId> g_incomingLanJobs;
+
+// Client IDs of the other devices in the room, from the last peer list
+static std::mutex g_peerMutex;
+static std::set<std::string> g_activePeerIds;
+
+static std::set<std::string> GetActivePeerIds() {
+    std::lock_guard<std::mutex> lock(g_peerMutex);
+    return g_activePeerIds;
+}
+
 struct PendingPush {
+    PendingPush(const std::string& id, const std::set<std::string>& peers) : transfer_id(id), peers(peers), life(id, peers) {}
+
     std::string room;
     std::string transfer_id;
+    std::set<std::string> peers;   // room members when the transfer was announced
     std::string file_id;
-    std::vector<uint8_t> data;
+    std::vector<uint8_t> key;
+    TransferSource source;         // plaintext, kept until the transfer settles
     std::string filename;
     std::string type;
-    std::atomic<bool> completed{ false };
-    std::atomic<bool> upload_requested{ false };
-    std::atomic<bool> upload_started{ false };
-    std::atomic<bool> need_relay{ false };
+    TransferLifecycle life;
+    std::chrono::steady_clock::time_point announcedAt = std::chrono::steady_clock::now();
+    bool lanDelivered = false;     // guarded by g_pendingMutex
+    bool lanOffered = true;        // false when peer history sent it straight to the relay
+
+    // Guarded by g_pendingMutex
+    TimerWheel::TimerId lanTimer = 0;
+    TimerWheel::TimerId graceTimer = 0;
+    TransferScheduler::JobId uploadJob = 0;
+    std::chrono::steady_clock::time_point relayStartedAt;
+    std::string blobId;            // whole-file envelope in BlobStore, pinned until settled
 };
 
 static std::mutex g_pendingMutex;
 static std::map<std::string, std::shared_ptr<PendingPush>> g_pendingPushes;
 
+// Coalesces WM_CLIPBOARDUPDATE bursts; only touched on the message thread
+static Debouncer g_autoPushDebouncer{ std::chrono::milliseconds(250), std::chrono::milliseconds(1000) };
+
+// Last text synced per room (sent or received), the base for delta pushes
+static std::mutex g_textBaseMutex;
+static std::map<std::string, std::string> g_lastSyncedText;
+
+// Deltas only pay off for larger clips that shrink substantially
+static const size_t kDeltaMinTextBytes = 1024;
+static const size_t kDeltaMaxRatio = 4;
+
+static std::string GetSyncedTextBase(const std::string& room) {
+    std::lock_guard<std::mutex> lock(g_textBaseMutex);
+    auto it = g_lastSyncedText.find(room);
+    return it != g_lastSyncedText.end() ? it->second : std::string();
+}
+
+static void SetSyncedTextBase(const std::string& room, const std::string& text) {
+    std::lock_guard<std::mutex> lock(g_textBaseMutex);
+    g_lastSyncedText[room] = text;
+}
+
 // --- Auto Update Logic ---
 void PerformAutoUpdate(const std::string& downloadUrl) {
     LOG_INFO("Starting auto-update from %s", downloadUrl.c_str());
@@ -165,87 +239,504 @@ void CheckForUpdates() {
 }
 
 void ProcessReceivedFile(const std::string& filePath, const std::string& filename, const std::string& type) {
-    auto& config = Config::Instance().Data();
+    auto config = Config::Instance().Get();
     
     LOG_INFO("Processing received file: %s", filename.c_str());
     ShowNotification(L"File Received", Utils::ToWide(filename));
 
     // Auto copy to clipboard
-    g_isProcessingRemoteSync = true;
-    if (type == "image" && config.auto_copy_image) {
-        Platform::Clipboard::SetImageFromFile(filePath);
-    } else if (config.auto_copy_file) {
+    if (type == "image" && config->auto_copy_image) {
+        if (Platform::Clipboard::SetImageFromFile(filePath)) {
+            g_echoCache.Remember(EchoCache::SequenceKey(Platform::Clipboard::GetSequenceNumber()));
+        }
+    } else if (config->auto_copy_file) {
+        g_echoCache.Remember(EchoCache::FilesKey({filePath}));
         Platform::Clipboard::SetFiles({filePath});
     }
-    
-    // Reset sync flag after a short delay
-    std::thread([]() {
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
-        g_isProcessingRemoteSync = false;
-    }).detach();
+}
+
+// Writes a received file into the download folder without overwriting existing files
+fs::path SaveReceivedFile(const std::vector<uint8_t>& data, const std::string& filename) {
+    auto config = Config::Instance().Get();
+    fs::path downloadDir(Utils::ToWide(config->download_path));
+    if (!fs::exists(downloadDir)) fs::create_directories(downloadDir);
+
+    // Handle duplicate filenames
+    fs::path filePath = downloadDir / Utils::ToWide(filename);
+    int count = 1;
+    std::wstring stem = filePath.stem().wstring();
+    std::wstring ext = filePath.extension().wstring();
+    while (fs::exists(filePath)) {
+        filePath = downloadDir / (stem + L"_" + std::to_wstring(count++) + ext);
+    }
+
+    std::ofstream ofs(filePath, std::ios::binary);
+    ofs.write((const char*)data.data(), data.size());
+    ofs.close();
+    return filePath;
+}
+
+// Puts text received from a peer (inline or via a text-typed transfer) on the clipboard
+void ApplyRemoteText(const std::string& text) {
+    auto config = Config::Instance().Get();
+    SetSyncedTextBase(config->room_id, text);
+    // Remember before writing so the WM_CLIPBOARDUPDATE can never win the race
+    g_echoCache.Remember(EchoCache::TextKey(text));
+    Platform::Clipboard::SetText(text);
+
+    std::wstring wMsg = Utils::ToWide(text.substr(0, 30));
+    if (text.length() > 30) wMsg += L"...";
+    ShowNotification(L"Clipboard Received", wMsg);
+}
+
+// Reassembles a chunked transfer, pulling only chunks missing from the local store.
+// `chunks` holds any manifest entries known up front; with a manifest URL the
+// rest is polled from the sender while it is still publishing. For bonded
+// transfers a Segment job downloads the sender's relay segments from the
+// back of the manifest while this one pulls LAN chunks from the front, so the
+// faster path ends up carrying more; a chunk that fails on one path is left to
+// the other. Every chunk is checked against its manifest entry whichever path
+// it came from.
+std::optional<std::vector<uint8_t>> PullChunks(nlohmann::json chunks, const std::string& manifestUrl, const std::string& chunkUrl,
+    size_t expectedSize, bool bonded, const ConfigData& config, const std::atomic<bool>& cancelled) {
+    auto key = Crypto::DecodeKey(config.room_key);
+    auto& store = ChunkStore::Instance();
+
+    std::map<std::string, std::string> headers;
+    headers["X-Room-ID"] = config.room_id;
+
+    enum SlotState { kFree, kTaken, kDone };
+    struct Slot {
+        std::string id;
+        size_t size = 0;
+        SlotState state = kFree;
+        bool lanFailed = false;
+        std::vector<uint8_t> plain;
+    };
+    struct Segment {
+        size_t first;
+        size_t count;
+        std::string url;
+        bool tried = false;
+    };
+
+    // Guarded by `mutex`
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<Slot> slots;
+    std::vector<Segment> segments;
+    size_t doneCount = 0;
+    size_t lanTaken = 0;   // reported to the sender so it cuts relay segments past it
+    bool complete = manifestUrl.empty();
+    bool failed = false;
+    size_t cachedChunks = 0, lanChunks = 0, relayChunks = 0;
+    size_t lanBytes = 0, relayBytes = 0;
+
+    auto verify = [&](const std::vector<uint8_t>& enc, const Slot& slot) -> std::optional<std::vector<uint8_t>> {
+        auto plain = Crypto::Decrypt(key, enc);
+        if (!plain || plain->size() != slot.size || ChunkStore::MakeId(key, plain->data(), plain->size()) != slot.id) return std::nullopt;
+        return plain;
+    };
+
+    auto addEntries = [&](const nlohmann::json& entries) {
+        for (const auto& c : entries) {
+            Slot slot;
+            slot.id = c.value("id", "");
+            slot.size = c.value("size", (size_t)0);
+            if (!ChunkStore::IsValidId(slot.id)) failed = true;
+            slots.push_back(std::move(slot));
+        }
+    };
+
+    auto allDone = [&]() { return complete && doneCount == slots.size(); };
+
+    auto started = std::chrono::steady_clock::now();
+    auto stallLimit = std::chrono::seconds(std::max(config.lan_timeout, 1));
+    auto lastProgress = started;
+    bonded = bonded && !manifestUrl.empty();
+
+    // Relay puller: newest untried segment whose chunks nobody has taken yet
+    auto pullSegments = [&](const std::atomic<bool>& relayCancelled) {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            Segment* pick = nullptr;
+            while (!failed && !cancelled && !relayCancelled && !allDone()) {
+                for (auto it = segments.rbegin(); it != segments.rend() && !pick; ++it) {
+                    if (it->tried || it->first + it->count > slots.size()) continue;
+                    bool free = true;
+                    for (size_t i = it->first; i < it->first + it->count && free; ++i) free = slots[i].state == kFree;
+                    if (free) pick = &*it;
+                }
+                if (pick) break;
+                cv.wait_for(lock, std::chrono::milliseconds(50));
+            }
+            if (!pick) return;
+
+            pick->tried = true;
+            Segment seg = *pick;
+            std::vector<Slot> want;
+            for (size_t i = seg.first; i < seg.first + seg.count; ++i) {
+                slots[i].state = kTaken;
+                want.push_back({ slots[i].id, slots[i].size });
+            }
+            lock.unlock();
+
+            // Each envelope is prefixed with its u32 little-endian length
+            std::vector<std::optional<std::vector<uint8_t>>> got(want.size());
+            auto blob = Network::HttpClient::Get(seg.url);
+            size_t pos = 0;
+            for (size_t k = 0; blob && k < want.size(); ++k) {
+                if (blob->size() - pos < 4) break;
+                const uint8_t* b = blob->data() + pos;
+                size_t len = (size_t)b[0] | ((size_t)b[1] << 8) | ((size_t)b[2] << 16) | ((size_t)b[3] << 24);
+                pos += 4;
+                if (blob->size() - pos < len) break;
+                std::vector<uint8_t> enc(blob->begin() + pos, blob->begin() + pos + len);
+                pos += len;
+                got[k] = verify(enc, want[k]);
+                if (got[k]) store.Put(want[k].id, enc);
+                else LOG_ERROR("Relay chunk %s failed verification", want[k].id.c_str());
+            }
+
+            lock.lock();
+            for (size_t k = 0; k < want.size(); ++k) {
+                Slot& slot = slots[seg.first + k];
+                if (got[k]) {
+                    slot.plain = std::move(*got[k]);
+                    slot.state = kDone;
+                    doneCount++;
+                    relayChunks++;
+                    relayBytes += slot.size;
+                    lastProgress = std::chrono::steady_clock::now();
+                } else {
+                    slot.state = kFree; // left to the LAN puller
+                }
+            }
+            cv.notify_all();
+        }
+    };
+
+    // It runs as its own scheduler job and borrows this frame, so it must be
+    // over (or dropped unstarted) before we return. Guarded by `mutex`.
+    bool relayActive = bonded;
+    auto relayDone = [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        relayActive = false;
+        cv.notify_all();
+    };
+    TransferScheduler::JobId relayJob = 0;
+    if (bonded) relayJob = TransferScheduler::Instance().Submit(TransferClass::Segment, config.room_id, "relay segments",
+        [&](const std::atomic<bool>& relayCancelled) {
+            try {
+                pullSegments(relayCancelled);
+            } catch (...) {
+                relayDone();
+                throw;
+            }
+            relayDone();
+        }, relayDone);
+
+    size_t lanCursor = 0;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (chunks.is_array()) addEntries(chunks);
+
+    while (!failed && !allDone()) {
+        if (cancelled) {
+            failed = true;
+            break;
+        }
+
+        // LAN puller: oldest chunk that is still free
+        while (lanCursor < slots.size() && slots[lanCursor].state == kDone) lanCursor++;
+        size_t idx = slots.size();
+        for (size_t i = lanCursor; i < slots.size(); ++i) {
+            if (slots[i].state == kFree && !slots[i].lanFailed) {
+                idx = i;
+                break;
+            }
+        }
+
+        if (idx < slots.size()) {
+            slots[idx].state = kTaken;
+            lanTaken = std::max(lanTaken, idx + 1);
+            Slot want{ slots[idx].id, slots[idx].size };
+            lock.unlock();
+
+            // Cached chunks are re-verified: the room key may have changed since
+            bool cached = false;
+            std::optional<std::vector<uint8_t>> plain;
+            if (auto hit = store.Get(want.id)) plain = verify(*hit, want);
+            if (plain) {
+                cached = true;
+            } else if (auto enc = Network::HttpClient::GetWithHeaders(chunkUrl + want.id, headers); enc && !enc->empty()) {
+                plain = verify(*enc, want);
+                if (plain) store.Put(want.id, *enc);
+                else LOG_ERROR("Chunk %s failed verification", want.id.c_str());
+            }
+
+            lock.lock();
+            Slot& slot = slots[idx];
+            if (plain) {
+                slot.plain = std::move(*plain);
+                slot.state = kDone;
+                doneCount++;
+                if (cached) {
+                    cachedChunks++;
+                } else {
+                    lanChunks++;
+                    lanBytes += slot.size;
+                }
+                lastProgress = std::chrono::steady_clock::now();
+            } else if (!bonded) {
+                failed = true;
+            } else {
+                slot.state = kFree;
+                slot.lanFailed = true;
+            }
+            cv.notify_all();
+            continue;
+        }
+
+        // Nothing for LAN to do: look for new chunks (and relay segments)
+        if (!complete || bonded) {
+            std::string url = manifestUrl + "?from=" + std::to_string(slots.size());
+            if (bonded) url += "&relay_from=" + std::to_string(segments.size()) + "&lan=" + std::to_string(lanTaken);
+            size_t before = slots.size() + segments.size();
+            lock.unlock();
+            auto res = Network::HttpClient::GetWithHeaders(url, headers);
+            lock.lock();
+            if (!res || res->empty()) {
+                failed = true;
+                break;
+            }
+            try {
+                auto body = nlohmann::json::parse(res->begin(), res->end());
+                if (body.value("failed", false)) {
+                    failed = true;
+                    break;
+                }
+                complete = body.value("complete", false);
+                addEntries(body.value("chunks", nlohmann::json::array()));
+                for (const auto& r : body.value("relay", nlohmann::json::array())) {
+                    segments.push_back({ r.value("first", (size_t)0), r.value("count", (size_t)0), r.value("url", "") });
+                }
+            } catch (...) {
+                failed = true;
+                break;
+            }
+            if (slots.size() + segments.size() != before) {
+                lastProgress = std::chrono::steady_clock::now();
+                cv.notify_all();
+                continue;
+            }
+        }
+
+        if (std::chrono::steady_clock::now() - lastProgress > stallLimit) {
+            LOG_WARNING("Chunked pull stalled");
+            failed = true;
+            break;
+        }
+        cv.wait_for(lock, std::chrono::milliseconds(50));
+    }
+    cv.notify_all();
+    lock.unlock();
+    if (relayJob) TransferScheduler::Instance().Cancel(relayJob);
+    lock.lock();
+    cv.wait(lock, [&] { return !relayActive; });
+    lock.unlock();
+    if (failed) return std::nullopt;
+
+    std::vector<uint8_t> out;
+    for (const auto& slot : slots) out.insert(out.end(), slot.plain.begin(), slot.plain.end());
+    if (expectedSize && out.size() != expectedSize) return std::nullopt;
+
+    auto ms = std::max<long long>(1, std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count());
+    LOG_INFO("Chunked pull: %zu chunks (%zu cached, %zu LAN, %zu relay), %zu KB LAN + %zu KB relay in %lld ms (%.1f MB/s)",
+        slots.size(), cachedChunks, lanChunks, relayChunks, lanBytes / 1024, relayBytes / 1024, ms,
+        (double)(lanBytes + relayBytes) / (1024.0 * 1024.0) / ((double)ms / 1000.0));
+    return out;
+}
+
+// Below this the UDP handshake costs more than TCP's loss sensitivity
+static const size_t kUdpMinBytes = 1024 * 1024;
+
+// Stagger between connect attempts to a peer's announced addresses (RFC 8305)
+static const auto kConnectStagger = std::chrono::milliseconds(250);
+
+// "http://host:port/path" -> "host"; IPv6 hosts come without their brackets
+static std::string HostOf(const std::string& url) {
+    size_t start = url.find("://");
+    if (start == std::string::npos) return "";
+    start += 3;
+    if (start < url.size() && url[start] == '[') {
+        size_t close = url.find(']', start);
+        return close == std::string::npos ? "" : url.substr(start + 1, close - start - 1);
+    }
+    size_t end = url.find_first_of(":/", start);
+    return url.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+// "http://host:port/path" -> port, 80 without one
+static int PortOf(const std::string& url) {
+    size_t start = url.find("://");
+    if (start == std::string::npos) return 0;
+    start += 3;
+    size_t hostEnd = start < url.size() && url[start] == '[' ? url.find(']', start) + 1 : url.find_first_of(":/", start);
+    if (hostEnd == 0 || hostEnd >= url.size() || url[hostEnd] != ':') return 80;
+    return atoi(url.c_str() + hostEnd + 1);
+}
+
+// Same URL pointing at `host` instead
+static std::string WithHost(const std::string& url, const std::string& host) {
+    std::string old = HostOf(url);
+    size_t start = url.find("://");
+    if (old.empty() || start == std::string::npos) return url;
+    start += 3;
+    bool bracketed = url[start] == '[';
+    std::string literal = host.find(':') != std::string::npos ? "[" + host + "]" : host;
+    return url.substr(0, start) + literal + url.substr(start + old.size() + (bracketed ? 2 : 0));
 }
 
 void HandleIncomingAnnouncement(const nlohmann::json& data) {
-    auto& config = Config::Instance().Data();
+    auto config = Config::Instance().Get();
     std::string transfer_id = data.value("transfer_id", "");
     std::string file_id = data.value("file_id", "");
     std::string filename = data.value("filename", "received_file");
     std::string local_url = data.value("local_url", "");
     std::string sender_id = data.value("sender_client_id", "unknown");
     std::string type = data.value("type", "file");
+    std::string chunk_url = data.value("chunk_url", "");
+    std::string manifest_url = data.value("manifest_url", "");
+    nlohmann::json chunks = data.value("chunks", nlohmann::json());
+    size_t size_bytes = data.value("size_bytes", (size_t)0);
+    bool bonded = data.value("bonded", false);
+    int udp_port = data.value("udp_port", 0);
+    std::vector<std::string> local_hosts;
+    for (const auto& h : data.value("local_hosts", nlohmann::json::array())) {
+        if (h.is_string() && !h.get<std::string>().empty()) local_hosts.push_back(h.get<std::string>());
+    }
 
     if (local_url.empty() || transfer_id.empty()) return;
 
     LOG_INFO("Receiver Mode: Peer announced file via LAN. ID: %s", transfer_id.c_str());
 
-    std::thread([transfer_id, file_id, filename, local_url, type, config]() {
-        // 1. Attempt LAN Pull
-        LOG_INFO("Attempting LAN pull from %s", local_url.c_str());
-        
-        // Add Room-ID header for security
-        std::map<std::string, std::string> headers;
-        headers["X-Room-ID"] = config.room_id;
-        
-        auto res = Network::HttpClient::GetWithHeaders(local_url, headers);
-        
-        if (res && !res->empty()) {
-            LOG_INFO("LAN Pull Successful. Decrypting...");
-            
-            // 2. Decrypt data
-            auto key = Crypto::DecodeKey(config.room_key);
-            auto decData = Crypto::Decrypt(key, *res);
-            if (!decData) {
-                LOG_ERROR("Failed to decrypt data pulled via LAN");
-                return;
+    auto cls = TransferScheduler::Classify(type, size_bytes);
+    std::lock_guard<std::mutex> jobsLock(g_incomingMutex);
+    g_incomingLanJobs[transfer_id] = TransferScheduler::Instance().Submit(cls, sender_id, filename,
+        [transfer_id, file_id, filename, sender_id, local_url, local_hosts, type, chunk_url, manifest_url, chunks, size_bytes, bonded, udp_port, config](const std::atomic<bool>& cancelled) {
+        auto started = std::chrono::steady_clock::now();
+        // A direct push usually lands before the announcement has made it through the relay
+        if (g_receivedTransfers.Contains(EchoCache::TransferKey(transfer_id))) {
+            LOG_INFO("Transfer %s already pushed to us, skipping LAN pull", transfer_id.c_str());
+            std::lock_guard<std::mutex> lock(g_incomingMutex);
+            g_incomingLanJobs.erase(transfer_id);
+            return;
+        }
+        auto key = Crypto::DecodeKey(config->room_key);
+        std::optional<std::vector<uint8_t>> decData;
+
+        // Multi-homed senders list every address; race them, last winner first
+        std::string lanUrl = local_url, chunkUrl = chunk_url, manifestUrl = manifest_url;
+        std::string host = HostOf(local_url);
+        if (local_hosts.size() > 1) {
+            std::vector<std::string> hosts = local_hosts;
+            auto known = std::find(hosts.begin(), hosts.end(), PeerStats::Instance().LanHost(sender_id));
+            if (known != hosts.end()) std::rotate(hosts.begin(), known, known + 1);
+            int won = Network::RaceConnect(hosts, PortOf(local_url), kConnectStagger, std::chrono::seconds(std::max(config->lan_timeout, 1)));
+            if (won >= 0 && hosts[won] != host) {
+                host = hosts[won];
+                lanUrl = WithHost(local_url, host);
+                if (!chunkUrl.empty()) chunkUrl = WithHost(chunk_url, host);
+                if (!manifestUrl.empty()) manifestUrl = WithHost(manifest_url, host);
             }
+            if (won >= 0) PeerStats::Instance().SetLanHost(sender_id, hosts[won]);
+        }
 
-            // 3. Save file
-            fs::path downloadDir(Utils::ToWide(config.download_path));
-            if (!fs::exists(downloadDir)) fs::create_directories(downloadDir);
-            
-            fs::path filePath = downloadDir / Utils::ToWide(filename);
-            // Handle duplicates
-            int count = 1;
-            std::wstring stem = filePath.stem().wstring();
-            std::wstring ext = filePath.extension().wstring();
-            while (fs::exists(filePath)) {
-                filePath = downloadDir / (stem + L"_" + std::to_wstring(count++) + ext);
+        // 0. Large whole-file transfers over the UDP transport when both sides
+        // enabled it (IPv4 only). Chunked ones go through the manifest instead:
+        // the UDP server can only send the blob once it is sealed, and the
+        // chunk store would not get to skip what we already hold.
+        bool chunkedOffer = (chunks.is_array() || !manifestUrl.empty()) && !chunkUrl.empty();
+        if (!chunkedOffer && udp_port > 0 && config->udp_transport && size_bytes >= kUdpMinBytes && !host.empty() && host.find(':') == std::string::npos) {
+            LOG_INFO("Attempting UDP pull from %s:%d", host.c_str(), udp_port);
+            auto idle = std::chrono::seconds(std::max(config->lan_timeout, 1));
+            // Decrypted as segments arrive, so the envelope is never held whole
+            Crypto::GcmDecryptor decryptor(key);
+            std::vector<uint8_t> plain;
+            bool ok = decryptor.IsValid() && UdpTransfer::Fetch(host, udp_port, transfer_id, config->room_id, idle, cancelled,
+                [&](const uint8_t* data, size_t len) { return decryptor.Update(data, len, plain); });
+            if (ok && decryptor.Finish(plain)) decData = std::move(plain);
+            if (!decData && !cancelled) LOG_WARNING("UDP pull failed, falling back to HTTP");
+        }
+
+        // 1. Chunked senders let us skip everything already in the local chunk store
+        if (!decData && chunkedOffer) {
+            LOG_INFO("Attempting chunked LAN pull (%s manifest)", manifestUrl.empty() ? "static" : "streaming");
+            decData = PullChunks(chunks, manifestUrl, chunkUrl, size_bytes, bonded, *config, cancelled);
+            if (!decData) LOG_WARNING("Chunked pull failed, pulling whole file");
+        }
+
+        // Past the only cancellable stage; a relay win is caught by Claim() below
+        {
+            std::lock_guard<std::mutex> lock(g_incomingMutex);
+            g_incomingLanJobs.erase(transfer_id);
+        }
+
+        if (cancelled) {
+            LOG_INFO("Incoming transfer cancelled: %s", transfer_id.c_str());
+            return;
+        }
+
+        if (!decData) {
+            LOG_INFO("Attempting LAN pull from %s", lanUrl.c_str());
+
+            // Add Room-ID header for security
+            std::map<std::string, std::string> headers;
+            headers["X-Room-ID"] = config->room_id;
+
+            auto res = Network::HttpClient::GetWithHeaders(lanUrl, headers);
+            if (res && !res->empty()) {
+                LOG_INFO("LAN Pull Successful. Decrypting...");
+
+                // 2. Decrypt data
+                decData = Crypto::Decrypt(key, *res);
+                if (!decData) {
+                    LOG_ERROR("Failed to decrypt data pulled via LAN");
+                    return;
+                }
             }
+        }
 
-            std::ofstream ofs(filePath, std::ios::binary);
-            ofs.write((char*)decData->data(), decData->size());
-            ofs.close();
+        // The relay copy may have won a race with this pull
+        if (decData && !g_receivedTransfers.Claim(EchoCache::TransferKey(transfer_id))) {
+            LOG_INFO("Transfer %s already delivered via relay, dropping LAN copy", transfer_id.c_str());
+            Metrics::DuplicateDrops.Inc();
+            return;
+        }
 
-            // 4. Process (UI & Clipboard)
-            ProcessReceivedFile(filePath.string(), filename, type);
+        if (decData) {
+            Metrics::LanPullSeconds.Since(started);
+            Metrics::ReceiveBytes.Record(decData->size());
+            if (type == "text") {
+                // Large clip routed through the file pipeline: straight to the clipboard
+                ApplyRemoteText(std::string(decData->begin(), decData->end()));
+            } else {
+                // 3. Save file
+                fs::path filePath = SaveReceivedFile(*decData, filename);
+
+                // 4. Process (UI & Clipboard)
+                ProcessReceivedFile(filePath.string(), filename, type);
+            }
 
             // 5. Send Success Signal
             nlohmann::json ack;
             ack["protocol_version"] = "4.0";
-            ack["room"] = config.room_id;
+            ack["room"] = config->room_id;
             ack["transfer_id"] = transfer_id;
             ack["file_id"] = file_id;
             ack["method"] = "lan";
+            ack["receiver_client_id"] = config->device_id;
             ack["received_at_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
             
             SocketIOService::Instance().Emit("file_sync_completed", ack);
@@ -256,7 +747,7 @@ void HandleIncomingAnnouncement(const nlohmann::json& data) {
             // 5. Send Fallback Signal
             nlohmann::json req;
             req["protocol_version"] = "4.0";
-            req["room"] = config.room_id;
+            req["room"] = config->room_id;
             req["transfer_id"] = transfer_id;
             req["file_id"] = file_id;
             req["reason"] = "lan_unreachable";
@@ -264,7 +755,40 @@ void HandleIncomingAnnouncement(const nlohmann::json& data) {
             
             SocketIOService::Instance().Emit("file_need_relay", req);
         }
-    }).detach();
+    });
+}
+
+// LocalServer hooks for files a sender pushed straight to our /upload
+static bool ClaimPushedTransfer(const std::string& transferId) {
+    if (!g_receivedTransfers.Claim(EchoCache::TransferKey(transferId))) {
+        Metrics::DuplicateDrops.Inc();
+        return false;
+    }
+    // A pull for the same transfer may be queued or running
+    std::lock_guard<std::mutex> lock(g_incomingMutex);
+    auto it = g_incomingLanJobs.find(transferId);
+    if (it != g_incomingLanJobs.end()) TransferScheduler::Instance().Cancel(it->second);
+    return true;
+}
+
+static void OnPushedFileReceived(const std::string& transferId, const std::string& fileId, const std::string& path,
+    const std::string& filename, const std::string& type) {
+    std::error_code ec;
+    auto size = fs::file_size(path, ec);
+    if (!ec) Metrics::ReceiveBytes.Record(size);
+    ProcessReceivedFile(path, filename, type);
+
+    auto config = Config::Instance().Get();
+    nlohmann::json ack;
+    ack["protocol_version"] = "4.0";
+    ack["room"] = config->room_id;
+    ack["transfer_id"] = transferId;
+    ack["file_id"] = fileId;
+    ack["method"] = "lan";
+    ack["receiver_client_id"] = config->device_id;
+    ack["received_at_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    SocketIOService::Instance().Emit("file_sync_completed", ack);
+    LOG_INFO("Sent file_sync_completed for pushed ID: %s", transferId.c_str());
 }
 
 void OnRemoteFileReceived(const nlohmann::json& data) {
@@ -272,51 +796,73 @@ void OnRemoteFileReceived(const nlohmann::json& data) {
         std::string url = data.value("download_url", "");
         std::string filename = data.value("filename", "received_file");
         std::string type = data.value("type", "file");
+        std::string transferId = data.value("transfer_id", "");
 
         if (url.empty()) return;
 
+        // Racing senders upload while the LAN offer is still open
+        if (!transferId.empty() && g_receivedTransfers.Contains(EchoCache::TransferKey(transferId))) {
+            LOG_INFO("Transfer %s already delivered over LAN, skipping relay download", transferId.c_str());
+            Metrics::DuplicateDrops.Inc();
+            return;
+        }
+
         LOG_INFO("Downloading file: %s", filename.c_str());
+        auto started = std::chrono::steady_clock::now();
         auto encData = Network::HttpClient::Get(url);
         if (!encData) {
             LOG_ERROR("Failed to download file");
             return;
         }
 
-        auto& config = Config::Instance().Data();
-        auto key = Crypto::DecodeKey(config.room_key);
+        auto config = Config::Instance().Get();
+        auto key = Crypto::DecodeKey(config->room_key);
         auto decData = Crypto::Decrypt(key, *encData);
         if (!decData) {
             LOG_ERROR("Failed to decrypt file");
             return;
         }
 
-        // Ensure download path exists
-        fs::path downloadDir(Utils::ToWide(config.download_path));
-        if (!fs::exists(downloadDir)) {
-            fs::create_directories(downloadDir);
+        if (!transferId.empty()) {
+            if (!g_receivedTransfers.Claim(EchoCache::TransferKey(transferId))) {
+                LOG_INFO("Transfer %s already delivered over LAN, dropping relay copy", transferId.c_str());
+                Metrics::DuplicateDrops.Inc();
+                return;
+            }
+            // The LAN pull for the same transfer lost the race
+            std::lock_guard<std::mutex> lock(g_incomingMutex);
+            auto it = g_incomingLanJobs.find(transferId);
+            if (it != g_incomingLanJobs.end()) TransferScheduler::Instance().Cancel(it->second);
         }
+        Metrics::RelayDownloadSeconds.Since(started);
+        Metrics::ReceiveBytes.Record(decData->size());
 
-        // Handle duplicate filenames
-        fs::path filePath = downloadDir / Utils::ToWide(filename);
-        int count = 1;
-        std::wstring stem = filePath.stem().wstring();
-        std::wstring ext = filePath.extension().wstring();
-        while (fs::exists(filePath)) {
-            filePath = downloadDir / (stem + L"_" + std::to_wstring(count++) + ext);
+        if (type == "text") {
+            ApplyRemoteText(std::string(decData->begin(), decData->end()));
+        } else {
+            fs::path filePath = SaveReceivedFile(*decData, filename);
+            ProcessReceivedFile(filePath.string(), filename, type);
         }
 
-        // Save file
-        std::ofstream outfile(filePath, std::ios::binary);
-                outfile.write((char*)decData->data(), decData->size());
-                outfile.close();
-        
-                ProcessReceivedFile(filePath.string(), filename, type);
-            } catch (const std::exception& e) {
+        // Tell a racing sender the relay path won so it stops serving LAN
+        if (!transferId.empty()) {
+            nlohmann::json ack;
+            ack["protocol_version"] = "4.0";
+            ack["room"] = config->room_id;
+            ack["transfer_id"] = transferId;
+            ack["method"] = "relay";
+            ack["receiver_client_id"] = config->device_id;
+            ack["received_at_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            SocketIOService::Instance().Emit("file_sync_completed", ack);
+        }
+    } catch (const std::exception& e) {
         LOG_ERROR("Error in file sync: %s", e.what());
     }
 }
 
-void PerformCloudUpload(const std::vector<uint8_t>& encData, const std::string& filename, const std::string& fileType);
+bool PerformCloudUpload(const BlobStore::Blob& blob, const std::string& filename, const std::string& fileType, const std::string& transferId);
+std::optional<std::string> UploadToRelay(const std::vector<uint8_t>& encData, const std::string& filename);
+void PushFileData(TransferSource source, const std::string& filename, const std::string& fileType, const std::atomic<bool>& cancelled);
 
 std::string GetCurrentTimestamp() {
     auto now = std::chrono::system_clock::now();
@@ -328,35 +874,72 @@ std::string GetCurrentTimestamp() {
     return ss.str();
 }
 
-bool PushText(const std::string& text) {
-    auto& config = Config::Instance().Data();
-    if (config.room_key.empty()) return false;
+// A non-empty `target` addresses the clip to one device; the relay still
+// broadcasts it, and everyone else drops it on arrival
+bool PushTextInternal(const std::string& text, bool allowDelta, const std::string& target = "") {
+    auto config = Config::Instance().Get();
+    if (config->room_key.empty()) return false;
+
+    auto key = Crypto::DecodeKey(config->room_key);
+
+    // Prefer a delta against the last synced clip when it is much smaller
+    std::vector<uint8_t> plain;
+    bool isDelta = false;
+    if (allowDelta && config->text_delta_sync && text.size() >= kDeltaMinTextBytes) {
+        std::string base = GetSyncedTextBase(config->room_id);
+        if (!base.empty()) {
+            auto delta = TextDelta::Encode(base, text);
+            if (delta.size() * kDeltaMaxRatio <= text.size()) {
+                plain = std::move(delta);
+                isDelta = true;
+            }
+        }
+    }
+
+    // Big clips would become one giant relay POST and Socket.IO event;
+    // send them as a text-typed transfer so LAN peers pull them directly.
+    size_t largeTextBytes = (size_t)std::max(config->large_text_threshold_kb, 1) * 1024;
+    if (!isDelta && target.empty() && text.size() > largeTextBytes) {
+        LOG_INFO("Text is %zu bytes, routing through file transfer", text.size());
+        std::string filename = "clip_" + std::to_string(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now())) + ".txt";
+        auto owned = std::make_shared<const std::string>(text);
+        auto cls = TransferScheduler::Classify("text", owned->size());
+        TransferScheduler::Instance().Submit(cls, config->device_id, filename, [owned, filename](const std::atomic<bool>& cancelled) {
+            PushFileData({ reinterpret_cast<const uint8_t*>(owned->data()), owned->size(), owned }, filename, "text", cancelled);
+        });
+        SetSyncedTextBase(config->room_id, text);
+        return true;
+    }
+
+    if (!isDelta) plain.assign(text.begin(), text.end());
 
-    auto key = Crypto::DecodeKey(config.room_key);
-    std::vector<uint8_t> plain(text.begin(), text.end());
     auto enc = Crypto::Encrypt(key, plain);
     
     if (enc) {
         std::string b64 = Crypto::ToBase64(*enc);
-        std::string url = config.relay_server_url + "/api/relay";
+        std::string url = config->relay_server_url + "/api/relay";
         
         nlohmann::json j;
-        j["room"] = config.room_id;
+        j["room"] = config->room_id;
         j["event"] = "clipboard_sync";
-        j["sender_id"] = config.device_id;
+        j["sender_id"] = config->device_id;
         
         nlohmann::json data;
-        data["room"] = config.room_id;
+        data["room"] = config->room_id;
         data["content"] = b64;
         data["encrypted"] = true;
         data["timestamp"] = GetCurrentTimestamp();
-        data["source"] = config.device_id;
+        data["source"] = config->device_id;
+        if (!target.empty()) data["target"] = target;
+        if (isDelta) data["encoding"] = "delta";
         
         j["data"] = data;
 
         auto res = Network::HttpClient::Post(url, j.dump());
         if (res.status == 200) {
-            LOG_INFO("Push success");
+            if (isDelta) LOG_INFO("Push success (delta: %zu of %zu bytes)", plain.size(), text.size());
+            else LOG_INFO("Push success");
+            SetSyncedTextBase(config->room_id, text);
             return true;
         } else {
             LOG_ERROR("Push failed: %d, Response: %s", res.status, res.body.c_str());
@@ -365,14 +948,377 @@ bool PushText(const std::string& text) {
     return false;
 }
 
-void PushFileData(const std::vector<uint8_t>& data, const std::string& filename, const std::string& fileType) {
-    auto& config = Config::Instance().Data();
-    if (config.room_key.empty()) return;
+bool PushText(const std::string& text) {
+    return PushTextInternal(text, true);
+}
 
-    // Encrypt data FIRST
-    auto key = Crypto::DecodeKey(config.room_key);
-    auto enc = Crypto::Encrypt(key, data);
-    if (!enc) return;
+// First 16 bytes of HMAC(room key, label), hex; empty without a key
+static std::string RoomTag(const std::string& roomKey, const std::string& label) {
+    if (roomKey.empty()) return "";
+    auto key = Crypto::DecodeKey(roomKey);
+    auto mac = Crypto::HmacSha256(key, (const uint8_t*)label.data(), label.size());
+    if (mac.size() < 16) return "";
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    for (size_t i = 0; i < 16; ++i) {
+        hex.push_back(digits[mac[i] >> 4]);
+        hex.push_back(digits[mac[i] & 0xF]);
+    }
+    return hex;
+}
+
+// Names the text a resync asks for: the delta's XXH64 target hash would let
+// the relay link clips, so it travels as a room-keyed HMAC of it instead
+static std::string ResyncTag(const std::string& roomKey, uint64_t targetHash) {
+    return RoomTag(roomKey, "text-resync:" + Hash::ToHex(targetHash));
+}
+
+// What LAN discovery beacons carry; devices in other rooms never match
+static LanDiscovery::Identity DiscoveryIdentity() {
+    auto config = Config::Instance().Get();
+    return { config->device_id, RoomTag(config->room_key, "lan-discovery:" + config->room_id) };
+}
+
+// Ask the delta's sender to resend in full; our base did not match theirs
+void RequestTextResync(const std::vector<uint8_t>& delta, const std::string& deltaSource) {
+    auto hdr = TextDelta::ReadHeader(delta);
+    if (!hdr || deltaSource.empty()) return;
+
+    auto config = Config::Instance().Get();
+    std::string tag = ResyncTag(config->room_key, hdr->target_hash);
+    if (tag.empty()) return;
+
+    nlohmann::json j;
+    j["room"] = config->room_id;
+    j["event"] = "clipboard_resync";
+    j["sender_id"] = config->device_id;
+
+    nlohmann::json data;
+    data["room"] = config->room_id;
+    data["target_tag"] = tag;
+    data["target_source"] = deltaSource;
+    data["source"] = config->device_id;
+    j["data"] = data;
+
+    std::string url = config->relay_server_url + "/api/relay";
+    TransferScheduler::Instance().Submit(TransferClass::Text, deltaSource, "resync request", [url, body = j.dump()](const std::atomic<bool>&) {
+        auto res = Network::HttpClient::Post(url, body);
+        if (res.status != 200) LOG_ERROR("Resync request failed: %d", res.status);
+    });
+}
+
+void OnRemoteTextReceived(const nlohmann::json& data) {
+    std::string content = data.value("content", "");
+    bool encrypted = data.value("encrypted", false);
+    if (content.empty()) return;
+
+    auto config = Config::Instance().Get();
+    // Resends answer one device's resync request
+    std::string target = data.value("target", "");
+    if (!target.empty() && target != config->device_id) return;
+
+    std::string finalText = content;
+
+    if (encrypted) {
+        auto key = Crypto::DecodeKey(config->room_key);
+        auto encData = Crypto::FromBase64(content);
+        auto dec = Crypto::Decrypt(key, encData);
+        if (!dec) {
+            LOG_ERROR("Failed to decrypt remote content");
+            return;
+        }
+
+        if (data.value("encoding", "") == "delta") {
+            auto text = TextDelta::Apply(GetSyncedTextBase(config->room_id), *dec);
+            if (!text) {
+                LOG_WARNING("Delta base mismatch, requesting full resend");
+                RequestTextResync(*dec, data.value("source", ""));
+                return;
+            }
+            finalText = std::move(*text);
+        } else {
+            finalText = std::string(dec->begin(), dec->end());
+        }
+    }
+
+    ApplyRemoteText(finalText);
+}
+
+// Below this size a transfer is sent whole; chunk bookkeeping would cost more than it saves
+static const size_t kChunkedMinBytes = 256 * 1024;
+// A discovered peer that doesn't accept a connection this fast is left to pull
+static const int kDirectPushConnectMs = 1000;
+// Bonded transfers (LAN and relay at once) only pay off for large payloads
+static const size_t kBondedMinBytes = 8 * 1024 * 1024;
+static const size_t kRelaySegmentBytes = 2 * 1024 * 1024;
+
+// How long LAN peers may keep pulling after the relay copy is up
+static const auto kRelayGrace = std::chrono::seconds(30);
+
+// Final transition of every outgoing transfer, whatever the outcome. Safe to
+// call more than once; only the first call does anything.
+static void SettlePush(const std::shared_ptr<PendingPush>& p, TransferPhase outcome, const char* reason) {
+    if (!p->life.Advance(outcome, reason)) return;
+
+    TransferScheduler::JobId upload;
+    bool lanDelivered;
+    std::string blobId;
+    {
+        std::lock_guard<std::mutex> lock(g_pendingMutex);
+        lanDelivered = p->lanDelivered;
+        TimerWheel::Instance().Cancel(p->lanTimer);
+        TimerWheel::Instance().Cancel(p->graceTimer);
+        upload = p->uploadJob;
+        blobId = std::move(p->blobId);
+        p->blobId.clear();
+        g_pendingPushes.erase(p->transfer_id);
+    }
+    // Every peer has it already; a queued or running relay upload is moot
+    if (upload) TransferScheduler::Instance().Cancel(upload);
+    if (!lanDelivered && upload && outcome == TransferPhase::Done) RaceEstimator::Instance().OnLanMissed();
+
+    // Stop publishing; the blob becomes evictable once nobody streams it
+    ChunkPipeline::Release(p->transfer_id);
+    BlobStore::Instance().RemoveAlias(p->transfer_id);
+    if (!blobId.empty()) BlobStore::Instance().Release(blobId);
+    LOG_INFO("transfer %s settled: %s", p->transfer_id.c_str(), p->life.Timeline().c_str());
+}
+
+// Hands a pinned blob to the transfer, or drops it if the transfer already
+// has one or has settled. Returns the transfer's blob ID.
+static std::string AttachBlob(const std::shared_ptr<PendingPush>& p, const std::string& blobId) {
+    std::lock_guard<std::mutex> lock(g_pendingMutex);
+    if (!p->blobId.empty() || p->life.IsTerminal()) {
+        BlobStore::Instance().Release(blobId);
+        return p->blobId;
+    }
+    p->blobId = blobId;
+    BlobStore::Instance().SetAlias(p->transfer_id, blobId);
+    return blobId;
+}
+
+static void StartRelay(const std::shared_ptr<PendingPush>& p, const char* reason) {
+    if (!p->life.Advance(TransferPhase::Relaying, reason)) return;
+    Metrics::LanFallbacks.Inc();
+
+    auto cls = TransferScheduler::Classify(p->type, p->source.size);
+    auto job = TransferScheduler::Instance().Submit(cls, p->room, p->filename, [p](const std::atomic<bool>& cancelled) {
+        std::string blobId;
+        {
+            std::lock_guard<std::mutex> lock(g_pendingMutex);
+            blobId = p->blobId;
+        }
+        // Chunked transfers get their blob from the pipeline; if that hasn't
+        // finished (or failed), seal it here
+        if (blobId.empty()) {
+            auto sealed = BlobStore::Instance().Put(p->key, p->source.data, p->source.size);
+            if (sealed) blobId = AttachBlob(p, sealed->id);
+        }
+        if (cancelled) {
+            SettlePush(p, TransferPhase::Failed, "cancelled");
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(g_pendingMutex);
+            p->relayStartedAt = std::chrono::steady_clock::now();
+        }
+        auto started = std::chrono::steady_clock::now();
+        auto blob = blobId.empty() ? std::nullopt : BlobStore::Instance().Acquire(blobId);
+        bool uploaded = blob && PerformCloudUpload(*blob, p->filename, p->type, p->transfer_id);
+        if (blob) BlobStore::Instance().Release(blob->id);
+        if (!uploaded) {
+            SettlePush(p, TransferPhase::Failed, "upload_failed");
+            return;
+        }
+        Metrics::RelayUploadSeconds.Since(started);
+        if (cancelled) {
+            SettlePush(p, TransferPhase::Failed, "cancelled");
+            return;
+        }
+        if (p->life.AllAcknowledged()) {
+            SettlePush(p, TransferPhase::Done, "acked");
+            return;
+        }
+        // Keep the LAN offer open a little longer for peers already pulling
+        auto timer = TimerWheel::Instance().Schedule(kRelayGrace, [p]() {
+            SettlePush(p, TransferPhase::Done, "relay_uploaded");
+        });
+        std::lock_guard<std::mutex> lock(g_pendingMutex);
+        p->graceTimer = timer;
+    }, [p]() {
+        // Dropped from the queue (Cancel/CancelAll): nothing else will settle
+        // it, and it still holds its blob pin and source mapping
+        SettlePush(p, TransferPhase::Failed, "cancelled");
+    });
+
+    std::lock_guard<std::mutex> lock(g_pendingMutex);
+    TimerWheel::Instance().Cancel(p->lanTimer);
+    p->uploadJob = job;
+}
+
+static void OnPushAcknowledged(const std::shared_ptr<PendingPush>& p, const std::string& peerId, const std::string& method) {
+    auto now = std::chrono::steady_clock::now();
+    if (method == "lan") {
+        Metrics::LanDeliveries.Inc();
+        bool first;
+        {
+            std::lock_guard<std::mutex> lock(g_pendingMutex);
+            first = !p->lanDelivered;
+            p->lanDelivered = true;
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - p->announcedAt);
+        if (first) RaceEstimator::Instance().OnLanDelivered(elapsed, p->source.size);
+        PeerStats::Instance().OnLanDelivered(peerId, elapsed, p->source.size);
+    } else if (method == "relay") {
+        Metrics::RelayDeliveries.Inc();
+        std::chrono::steady_clock::time_point started;
+        {
+            std::lock_guard<std::mutex> lock(g_pendingMutex);
+            started = p->relayStartedAt;
+        }
+        if (p->lanOffered) PeerStats::Instance().OnLanMissed(peerId);
+        if (started.time_since_epoch().count()) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - started);
+            PeerStats::Instance().OnRelayDelivered(peerId, elapsed, p->source.size);
+        }
+    }
+    if (p->life.Acknowledge(peerId)) SettlePush(p, TransferPhase::Done, method == "relay" ? "relay_acked" : "acked");
+}
+
+// Peers that left without acknowledging no longer hold a transfer open. A
+// transfer settled this way is logged as "peers_left", not "acked", so the
+// timeline shows that some peers never received it.
+static void OnPeersChanged(const std::set<std::string>& peers) {
+    std::vector<std::shared_ptr<PendingPush>> settled;
+    {
+        std::lock_guard<std::mutex> lock(g_pendingMutex);
+        for (auto& kv : g_pendingPushes) {
+            if (kv.second->life.RetainPeers(peers)) settled.push_back(kv.second);
+        }
+    }
+    for (auto& p : settled) SettlePush(p, TransferPhase::Done, "peers_left");
+}
+
+// Falls back to the relay once `delay` passes without the LAN path settling.
+// A bonded receiver that is still taking chunks over LAN re-arms the timer.
+static void ArmLanTimer(const std::shared_ptr<PendingPush>& p, std::chrono::milliseconds delay, const char* reason, size_t lanTaken) {
+    auto timer = TimerWheel::Instance().Schedule(delay, [p, delay, reason, lanTaken]() {
+        auto pipeline = ChunkPipeline::Find(p->transfer_id);
+        size_t taken = pipeline ? pipeline->LanTaken() : 0;
+        if (taken > lanTaken) {
+            ArmLanTimer(p, delay, reason, taken);
+            return;
+        }
+        StartRelay(p, reason);
+    });
+    std::lock_guard<std::mutex> lock(g_pendingMutex);
+    p->lanTimer = timer;
+}
+
+// Sender half of a bonded transfer: the manifest entries seen so far and which
+// of them already went to the relay. Only touched by the feed job chain.
+struct RelayFeed {
+    std::vector<ChunkPipeline::Entry> entries;
+    std::vector<bool> uploaded;
+};
+
+// Uploads one relay segment cut from the newest entries LAN receivers haven't
+// reached, then queues the next. One segment per job keeps the scheduler fair
+// to other transfers; while too little is published it retries on a timer.
+static void FeedRelaySegment(const std::shared_ptr<PendingPush>& p, const std::shared_ptr<RelayFeed>& feed) {
+    TransferScheduler::Instance().Submit(TransferClass::Segment, p->room, p->filename, [p, feed](const std::atomic<bool>& cancelled) {
+        auto pipeline = ChunkPipeline::Find(p->transfer_id);
+        if (cancelled || !pipeline || p->life.IsTerminal()) return;
+
+        bool complete = false, failed = false;
+        for (auto& e : pipeline->EntriesFrom(feed->entries.size(), complete, failed)) feed->entries.push_back(std::move(e));
+        if (failed) return;
+        feed->uploaded.resize(feed->entries.size(), false);
+
+        // Newest run of entries not uploaded yet, above what LAN has taken
+        size_t floor = pipeline->LanTaken();
+        size_t last = feed->entries.size();
+        while (last > floor && feed->uploaded[last - 1]) last--;
+        size_t first = last;
+        size_t bytes = 0;
+        while (first > floor && !feed->uploaded[first - 1] && bytes + feed->entries[first - 1].size <= kRelaySegmentBytes) {
+            bytes += feed->entries[--first].size;
+        }
+        if (first == last && complete) return; // LAN has reached everything else
+        if (first == last || (!complete && bytes < kRelaySegmentBytes)) {
+            TimerWheel::Instance().Schedule(std::chrono::milliseconds(200), [p, feed]() { FeedRelaySegment(p, feed); });
+            return;
+        }
+
+        std::vector<uint8_t> blob;
+        blob.reserve(bytes + (last - first) * 64);
+        for (size_t i = first; i < last; ++i) {
+            auto enc = ChunkStore::Instance().Get(feed->entries[i].id);
+            if (!enc) return; // evicted under us; LAN still has the rest
+            uint32_t len = (uint32_t)enc->size();
+            const uint8_t prefix[4] = { (uint8_t)len, (uint8_t)(len >> 8), (uint8_t)(len >> 16), (uint8_t)(len >> 24) };
+            blob.insert(blob.end(), prefix, prefix + 4);
+            blob.insert(blob.end(), enc->begin(), enc->end());
+        }
+
+        auto url = UploadToRelay(blob, p->transfer_id + "_" + std::to_string(first) + ".seg");
+        if (!url) {
+            LOG_WARNING("Relay segment upload failed for %s, LAN continues alone", p->transfer_id.c_str());
+            return;
+        }
+        for (size_t i = first; i < last; ++i) feed->uploaded[i] = true;
+        pipeline->AddRelayCopy({ first, last - first, *url });
+        LOG_DEBUG("transfer %s: relay segment %zu+%zu (%zu KB)", p->transfer_id.c_str(), first, last - first, bytes / 1024);
+
+        FeedRelaySegment(p, feed);
+    });
+}
+
+// Sender-initiated LAN delivery: streams the sealed blob into the /upload of
+// every peer LAN discovery can see, without waiting for the announcement to
+// travel through the relay and a pull to come back. The receiver acks over
+// the socket exactly as for a pull, so the LAN timer and relay fallback are
+// unchanged for peers that can't be reached this way.
+static void PushDirect(const std::shared_ptr<PendingPush>& p, const std::string& blobId) {
+    auto config = Config::Instance().Get();
+    auto cls = TransferScheduler::Classify(p->type, p->source.size);
+    for (const auto& peerId : p->peers) {
+        auto peer = LanDiscovery::Instance().Find(peerId);
+        if (!peer || !peer->Has("upload_enc")) continue;
+
+        std::map<std::string, std::string> headers;
+        headers["X-Room-ID"] = config->room_id;
+        headers["X-Encryption"] = "aes-256-gcm";
+        headers["X-Transfer-ID"] = p->transfer_id;
+        headers["X-File-ID"] = p->file_id;
+        headers["X-Transfer-Type"] = p->type;
+        std::string url = peer->BaseUrl() + "/upload";
+
+        TransferScheduler::Instance().Submit(cls, peerId, p->filename, [p, blobId, url, headers, peerId](const std::atomic<bool>& cancelled) {
+            if (cancelled || p->life.IsTerminal()) return;
+            auto blob = BlobStore::Instance().Acquire(blobId);
+            if (!blob) return;
+            auto res = Network::HttpClient::PostFile(url, headers, p->filename, blob->path, blob->size, kDirectPushConnectMs);
+            BlobStore::Instance().Release(blob->id);
+            if (res.status == 200) {
+                Metrics::DirectPushes.Inc();
+                LOG_INFO("Pushed %s straight to %s", p->transfer_id.c_str(), peerId.c_str());
+            } else {
+                Metrics::DirectPushFailures.Inc();
+                LOG_WARNING("Direct push of %s to %s failed (%d), peer can still pull", p->transfer_id.c_str(), peerId.c_str(), res.status);
+            }
+        });
+    }
+}
+
+// `source.owner` must keep the data alive; it is held until the transfer is
+// settled so the chunk pipeline and a late relay upload can both read it.
+void PushFileData(TransferSource source, const std::string& filename, const std::string& fileType, const std::atomic<bool>& cancelled) {
+    auto config = Config::Instance().Get();
+    if (config->room_key.empty()) return;
+
+    auto key = Crypto::DecodeKey(config->room_key);
+    Metrics::PushBytes.Record(source.size);
 
     // 1. Create Unique IDs (Stable for the whole process)
     auto now = std::chrono::system_clock::now();
@@ -380,96 +1326,128 @@ void PushFileData(const std::vector<uint8_t>& data, const std::string& filename,
     std::string file_id = "f_" + std::to_string(ms);
     std::string transfer_id = "tr_" + std::to_string(ms) + "_" + std::to_string(rand() % 100);
 
-    // 2. Save a local copy to temp folder for LAN sync
-    fs::path localPath;
-    try {
-        fs::path tempDir = fs::path(Utils::GetAppDir()) / L"temp";
-        if (!fs::exists(tempDir)) fs::create_directories(tempDir);
-        localPath = tempDir / Utils::ToWide(filename);
-        std::ofstream ofs(localPath, std::ios::binary);
-        ofs.write((char*)data.data(), data.size());
-        ofs.close();
-    } catch (...) {
-        LOG_ERROR("Failed to save temp copy for LAN sync");
-        return;
+    // Peer history decides how long LAN gets, or whether it is worth offering
+    auto peers = GetActivePeerIds();
+    auto lanTimeout = std::chrono::milliseconds(std::max(config->lan_timeout, 0) * 1000);
+    auto plan = PeerStats::Instance().Plan(peers, source.size, lanTimeout);
+
+    // 2. Large payloads are announced right away and published chunk by
+    // chunk (the pipeline seals the whole-file blob as it goes); small ones
+    // are sealed into the blob store up front
+    std::optional<BlobStore::Blob> blob;
+    bool chunked = !plan.skipLan && source.size >= kChunkedMinBytes;
+    bool bonded = chunked && config->bonded_transfer && source.size >= kBondedMinBytes;
+    if (!chunked) {
+        blob = BlobStore::Instance().Put(key, source.data, source.size);
+        if (!blob) {
+            LOG_ERROR("Failed to seal %s for sending", filename.c_str());
+            return;
+        }
     }
 
     // 3. Register in Pending Queue
-    auto pending = std::make_shared<PendingPush>();
-    pending->room = config.room_id;
+    auto pending = std::make_shared<PendingPush>(transfer_id, peers);
+    pending->room = config->room_id;
     pending->file_id = file_id;
-    pending->transfer_id = transfer_id;
-    pending->data = *enc;
+    pending->key = key;
+    pending->source = std::move(source);
     pending->filename = filename;
     pending->type = fileType;
     {
         std::lock_guard<std::mutex> lock(g_pendingMutex);
         g_pendingPushes[transfer_id] = pending;
     }
+    if (blob) AttachBlob(pending, blob->id);
+
+    if (plan.skipLan) {
+        LOG_INFO("Skipping LAN offer for %s (%s)", transfer_id.c_str(), plan.reason);
+        pending->lanOffered = false;
+        StartRelay(pending, plan.reason);
+        return;
+    }
+
+    std::shared_ptr<ChunkPipeline> pipeline;
+    if (chunked) {
+        // Runs inside Run() below, while this job's `cancelled` is still alive
+        pipeline = ChunkPipeline::Create(transfer_id, key, pending->source, true, [pending, &cancelled](bool ok, const std::string& blobId) {
+            if (!blobId.empty()) AttachBlob(pending, blobId);
+            if (ok) pending->life.Advance(TransferPhase::LanServing, "published");
+            else if (cancelled) SettlePush(pending, TransferPhase::Failed, "cancelled");
+            else if (!pending->life.IsTerminal()) StartRelay(pending, "publish_failed");
+        });
+    } else {
+        pending->life.Advance(TransferPhase::LanServing, "lan_copy_ready");
+        // Text must reach the clipboard, which /upload doesn't do
+        if (config->lan_direct_push && fileType != "text") PushDirect(pending, blob->id);
+    }
 
     // 4. Send Announcement (Protocol 4.0 schema)
     nlohmann::json announce;
     announce["protocol_version"] = "4.0";
-    announce["room"] = config.room_id;
+    announce["room"] = config->room_id;
     announce["transfer_id"] = transfer_id;
     announce["file_id"] = file_id;
     announce["filename"] = filename;
     announce["type"] = fileType;
-    announce["size_bytes"] = data.size();
-    announce["sender_client_id"] = config.device_id;
-    announce["local_url"] = "http://" + LocalServer::Instance().GetIP() + ":" + std::to_string(LocalServer::Instance().GetPort()) + "/files/" + filename;
+    announce["size_bytes"] = pending->source.size;
+    announce["sender_client_id"] = config->device_id;
+    // Whole-file pulls stream the blob; the transfer ID resolves to it once sealed
+    std::string base = "http://" + LocalServer::Instance().GetIP() + ":" + std::to_string(LocalServer::Instance().GetPort());
+    announce["local_url"] = base + "/blobs/" + transfer_id;
+    announce["local_hosts"] = LocalServer::Instance().GetAddresses();
     announce["sent_at_ms"] = ms;
+    if (chunked) {
+        announce["manifest_url"] = base + "/manifest/" + transfer_id;
+        announce["chunk_url"] = base + "/chunks/";
+        if (bonded) announce["bonded"] = true;
+    }
+    if (int udpPort = UdpTransfer::Instance().Port()) announce["udp_port"] = udpPort;
     
     SocketIOService::Instance().Emit("file_available", announce);
-    LOG_INFO("tx file_available: id=%s, room=%s", transfer_id.c_str(), config.room_id.c_str());
-
-    // 5. Start Background Decision Thread
-    int timeoutSecs = config.lan_timeout;
-    std::thread([pending, localPath, transfer_id, timeoutSecs]() {
-        // Wait for server command or app ack
-        for (int i = 0; i < timeoutSecs * 20; ++i) {
-            if (pending->completed || pending->upload_requested || pending->need_relay) break;
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-        }
+    LOG_INFO("tx file_available: id=%s, room=%s", transfer_id.c_str(), config->room_id.c_str());
+
+    // 5. Fall back to the relay if the LAN path hasn't settled in time;
+    // acks and server commands move the state machine on before that. When
+    // racing, the relay upload starts after a learned head start while the
+    // LAN offer stays open; whichever delivers first settles the transfer.
+    // Known peers get their own observed p99 instead of the global guess.
+    auto delay = lanTimeout;
+    const char* reason = "timeout";
+    if (plan.known) {
+        delay = plan.lanTimeout;
+        reason = plan.reason;
+    } else if (config->relay_race) {
+        delay = RaceEstimator::Instance().HeadStart(pending->source.size, lanTimeout);
+        reason = "race";
+    }
+    ArmLanTimer(pending, delay, reason, 0);
 
-        std::error_code ec;
-        if (pending->completed) {
-            LOG_INFO("LAN sync finished: id=%s", transfer_id.c_str());
-            fs::remove(localPath, ec);
-        } else {
-            // Idempotent Upload trigger
-            if (!pending->upload_started.exchange(true)) {
-                LOG_INFO("upload start: id=%s (reason: %s)", transfer_id.c_str(), 
-                    pending->upload_requested ? "server_directed" : (pending->need_relay ? "app_fallback" : "timeout"));
-                PerformCloudUpload(pending->data, pending->filename, pending->type);
-                LOG_INFO("upload end: id=%s", transfer_id.c_str());
-            }
-            std::this_thread::sleep_for(std::chrono::seconds(30));
-            fs::remove(localPath, ec);
-        }
+    // 6. Bonded: relay segments flow from the back while LAN pulls from the front
+    if (bonded) FeedRelaySegment(pending, std::make_shared<RelayFeed>());
 
-        // Cleanup from pending queue
-        {
-            std::lock_guard<std::mutex> lock(g_pendingMutex);
-            g_pendingPushes.erase(transfer_id);
-        }
-    }).detach();
+    // 7. Publish while holding this job's worker slot (chunk and seal run
+    // alongside), so the scheduler's class limits bound how many pipelines
+    // run at once
+    if (pipeline) pipeline->Run(cancelled);
 }
 
-void PerformCloudUpload(const std::vector<uint8_t>& encData, const std::string& filename, const std::string& fileType) {
-    auto& config = Config::Instance().Data();
-    
+// Stores `size` encrypted bytes on the relay, sent by `put` to the upload
+// URL it is handed; returns the download URL
+static std::optional<std::string> UploadToRelay(uint64_t size, const std::string& filename,
+    const std::function<Network::HttpResponse(const std::string& uploadUrl)>& put) {
+    auto config = Config::Instance().Get();
+
     // 1. Request upload auth
-    std::string authUrl = config.relay_server_url + "/api/file/upload_auth";
+    std::string authUrl = config->relay_server_url + "/api/file/upload_auth";
     nlohmann::json authPayload;
     authPayload["filename"] = filename;
-    authPayload["size"] = encData.size();
+    authPayload["size"] = size;
     authPayload["content_type"] = "application/octet-stream";
-    
+
     auto authRes = Network::HttpClient::Post(authUrl, authPayload.dump());
     if (authRes.status != 200) {
         LOG_ERROR("Upload auth failed: %d", authRes.status);
-        return;
+        return std::nullopt;
     }
 
     try {
@@ -477,65 +1455,99 @@ void PerformCloudUpload(const std::vector<uint8_t>& encData, const std::string&
         std::string uploadUrl = authJ.value("upload_url", "");
         std::string downloadUrl = authJ.value("download_url", "");
 
-        if (uploadUrl.empty()) return;
+        if (uploadUrl.empty()) return std::nullopt;
 
         // 2. Upload file
-        LOG_INFO("Uploading to cloud...");
-        auto putRes = Network::HttpClient::Put(uploadUrl, encData);
+        auto putRes = put(uploadUrl);
         if (putRes.status != 200) {
             LOG_ERROR("File upload failed: %d", putRes.status);
-            return;
+            return std::nullopt;
         }
+        return downloadUrl;
+    } catch (...) {
+        LOG_ERROR("Failed to process upload auth response");
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> UploadToRelay(const std::vector<uint8_t>& encData, const std::string& filename) {
+    return UploadToRelay(encData.size(), filename, [&](const std::string& uploadUrl) {
+        return Network::HttpClient::Put(uploadUrl, encData);
+    });
+}
 
+bool PerformCloudUpload(const BlobStore::Blob& blob, const std::string& filename, const std::string& fileType, const std::string& transferId) {
+    auto config = Config::Instance().Get();
+
+    LOG_INFO("Uploading to cloud...");
+    auto downloadUrl = UploadToRelay(blob.size, filename, [&](const std::string& uploadUrl) {
+        return Network::HttpClient::PutFile(uploadUrl, blob.path, blob.size);
+    });
+    if (!downloadUrl) return false;
+
+    try {
         // 3. Relay notification
-        std::string relayUrl = config.relay_server_url + "/api/relay";
+        std::string relayUrl = config->relay_server_url + "/api/relay";
         nlohmann::json relayPayload;
-        relayPayload["room"] = config.room_id;
+        relayPayload["room"] = config->room_id;
         relayPayload["event"] = "file_sync";
-        relayPayload["sender_id"] = config.device_id;
+        relayPayload["sender_id"] = config->device_id;
         
         nlohmann::json d;
-        d["room"] = config.room_id;
-        d["download_url"] = downloadUrl;
+        d["room"] = config->room_id;
+        d["download_url"] = *downloadUrl;
         d["filename"] = filename;
         d["type"] = fileType;
         d["timestamp"] = GetCurrentTimestamp();
+        // Lets a receiver that also pulled over LAN drop the duplicate
+        if (!transferId.empty()) d["transfer_id"] = transferId;
         relayPayload["data"] = d;
 
         Network::HttpClient::Post(relayUrl, relayPayload.dump());
         LOG_INFO("Cloud sync pushed successfully");
+        return true;
     } catch (...) {
         LOG_ERROR("Failed to process cloud upload");
     }
+    return false;
 }
 
 void PushImage(const std::vector<uint8_t>& pngData) {
     std::string filename = "img_" + std::to_string(std::chrono::system_clock::to_time_t(std::chrono::system_clock::now())) + ".png";
-    PushFileData(pngData, filename, "image");
+    auto owned = std::make_shared<const std::vector<uint8_t>>(pngData);
+    TransferScheduler::Instance().Submit(TransferClass::Image, Config::Instance().Get()->device_id, filename, [owned, filename](const std::atomic<bool>& cancelled) {
+        PushFileData({ owned->data(), owned->size(), owned }, filename, "image", cancelled);
+    });
 }
 
 void PushPhysicalFile(const std::string& filePath) {
     std::wstring wPath = Utils::ToWide(filePath);
-    std::ifstream file(wPath.c_str(), std::ios::binary);
-    if (!file.is_open()) {
-        LOG_ERROR("Failed to open file for pushing: %s", filePath.c_str());
-        return;
-    }
-
-    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
-    file.close();
-
     fs::path p(wPath);
     std::string utf8Filename = Utils::ToUtf8(p.filename().wstring());
-    PushFileData(data, utf8Filename, "file");
+
+    std::error_code ec;
+    uint64_t size = fs::file_size(p, ec);
+    auto cls = TransferScheduler::Classify("file", ec ? 0 : size);
+
+    TransferScheduler::Instance().Submit(cls, Config::Instance().Get()->device_id, utf8Filename, [wPath, filePath, utf8Filename](const std::atomic<bool>& cancelled) {
+        // Map the file and feed the view straight to the encryptor and chunker,
+        // instead of growing a heap copy of it first
+        auto file = std::make_shared<Platform::MappedFile>();
+        if (!file->Open(wPath)) {
+            LOG_ERROR("Failed to open file for pushing: %s", filePath.c_str());
+            return;
+        }
+        LOG_DEBUG("Ingesting %s (%zu bytes, %s)", filePath.c_str(), file->Size(), file->IsMapped() ? "mapped" : "buffered");
+        PushFileData({ file->Data(), file->Size(), file }, utf8Filename, "file", cancelled);
+    });
 }
 
 // Global Message Window handle
 HWND g_hMsgWnd = NULL;
 
 void ShowNotification(const std::wstring& title, const std::wstring& message, UI::NotificationStyle style) {
-    auto& config = Config::Instance().Data();
-    if (!config.show_notifications) return;
+    auto config = Config::Instance().Get();
+    if (!config->show_notifications) return;
 
     auto* data = new UI::NotificationData{ title, message, style };
     if (!PostMessageW(g_hMsgWnd, WM_SHOW_NOTIFICATION, 0, reinterpret_cast<LPARAM>(data))) {
@@ -543,6 +1555,70 @@ void ShowNotification(const std::wstring& title, const std::wstring& message, UI
     }
 }
 
+
+// Pushes whatever is on the clipboard now, so a burst of changes sends only the final content
+void AutoPushClipboard() {
+    if (g_activePeerCount <= 0) return;
+
+    auto config = Config::Instance().Get();
+    bool textEnabled = config->auto_push_text;
+    bool imgEnabled = config->auto_push_image;
+    bool fileEnabled = config->auto_push_file;
+
+    if (!textEnabled && !imgEnabled && !fileEnabled) return;
+
+    // Untouched since we applied a remote image: skip before paying for the PNG encode
+    if (g_echoCache.Take(EchoCache::SequenceKey(Platform::Clipboard::GetSequenceNumber()))) {
+        LOG_DEBUG("Clipboard still holds remotely applied content, auto-push skipped");
+        return;
+    }
+
+    LOG_INFO("Local clipboard changed. Auto-Push Config: Text=%d, Img=%d, File=%d", textEnabled, imgEnabled, fileEnabled);
+    auto cb = Platform::Clipboard::Get();
+
+    if ((cb.type == Platform::ClipboardType::Text && g_echoCache.Take(EchoCache::TextKey(cb.text))) ||
+        (cb.type == Platform::ClipboardType::Files && g_echoCache.Take(EchoCache::FilesKey(cb.files)))) {
+        LOG_DEBUG("Clipboard content matches a remote sync, auto-push skipped");
+        return;
+    }
+    
+    if (cb.type == Platform::ClipboardType::Text) {
+        if (textEnabled && !cb.text.empty()) {
+            LOG_INFO("Auto-pushing text...");
+            if (PushText(cb.text)) {
+                ShowNotification(L"Auto Pushed", L"Text content sent automatically", UI::NotificationStyle::Outbound);
+            } else {
+                LOG_ERROR("Auto-push failed (network error or empty key)");
+            }
+        } else {
+            LOG_INFO("Clipboard text ignored (Auto-Push Disabled or Empty)");
+        }
+    } else if (cb.type == Platform::ClipboardType::Image && imgEnabled) {
+        LOG_INFO("Auto-pushing image...");
+        PushImage(cb.image_data);
+        ShowNotification(L"Auto Pushed", L"Image content sent automatically", UI::NotificationStyle::Outbound);
+    } else if (cb.type == Platform::ClipboardType::Files && fileEnabled) {
+        LOG_INFO("Auto-pushing %zu file(s)...", cb.files.size());
+        for (const auto& file : cb.files) {
+            PushPhysicalFile(file);
+        }
+        ShowNotification(L"Auto Pushed", L"File(s) sent automatically", UI::NotificationStyle::Outbound);
+    }
+}
+
+// Takes in a settled network change (UI thread only). True if peers or the
+// relay need telling: our addresses changed, or we are on another network
+// even though the addresses are the same, e.g. another router handing out
+// the same subnet and lease. NetworkInfo bumps the epoch for the latter.
+bool RefreshNetwork() {
+    static int s_epoch = 0;
+    bool addressesChanged = LocalServer::Instance().RefreshAddresses();
+    int epoch = NetworkInfo::Instance().Snapshot().network_epoch;
+    bool moved = epoch != s_epoch;
+    s_epoch = epoch;
+    return addressesChanged || moved;
+}
+
 } // namespace ClipboardPush
 
 LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
@@ -556,14 +1632,43 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
         // immediate reconnect rather than waiting up to 45 s for the watchdog.
         if (wParam == PBT_APMRESUMEAUTOMATIC || wParam == PBT_APMRESUMESUSPEND) {
             LOG_INFO("System resumed from sleep. Forcing reconnect.");
-            auto& d = ClipboardPush::Config::Instance().Data();
+            auto d = ClipboardPush::Config::Instance().Get();
+            // We may have woken up on another network
+            ClipboardPush::NetworkInfo::Instance().Invalidate();
+            if (ClipboardPush::RefreshNetwork()) ClipboardPush::LanDiscovery::Instance().Refresh();
+            ClipboardPush::SocketIOService::Instance().Disconnect();
+            ClipboardPush::SocketIOService::Instance().Connect(d->relay_server_url, d->room_id, d->device_id);
+        }
+        return 0;
+    case WM_NETWORK_CHANGED:
+        // Posted by the network monitor once a change has settled. Announcements
+        // must stop naming the old addresses, LAN peers learned on the old
+        // network are gone, and the relay socket is most likely dead on the old
+        // route without knowing it yet.
+        if (ClipboardPush::RefreshNetwork()) {
+            LOG_INFO("Network changed. Re-announcing and reconnecting.");
+            auto d = ClipboardPush::Config::Instance().Get();
+            ClipboardPush::LanDiscovery::Instance().Refresh();
             ClipboardPush::SocketIOService::Instance().Disconnect();
-            ClipboardPush::SocketIOService::Instance().Connect(d.relay_server_url, d.room_id, d.device_id);
+            ClipboardPush::SocketIOService::Instance().Connect(d->relay_server_url, d->room_id, d->device_id);
         }
         return 0;
     case WM_SHOW_NOTIFICATION:
         ClipboardPush::UI::NotificationWindow::HandleMessage(lParam);
         break;
+    case WM_TIMER:
+        if (wParam == IDT_AUTO_PUSH) {
+            std::chrono::milliseconds wait;
+            if (ClipboardPush::g_autoPushDebouncer.Poll(std::chrono::steady_clock::now(), wait)) {
+                KillTimer(hWnd, IDT_AUTO_PUSH);
+                ClipboardPush::AutoPushClipboard();
+            } else if (ClipboardPush::g_autoPushDebouncer.Pending()) {
+                SetTimer(hWnd, IDT_AUTO_PUSH, (UINT)wait.count(), NULL);
+            } else {
+                KillTimer(hWnd, IDT_AUTO_PUSH);
+            }
+        }
+        break;
     case WM_TRAYICON:
         if (LOWORD(lParam) == WM_RBUTTONUP) {
             ClipboardPush::UI::TrayIcon::Instance().ShowContextMenu(hWnd);
@@ -603,71 +1708,70 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
                 }
             }
             break;
+        case IDM_TRAY_CANCEL_TRANSFERS:
+            {
+                size_t n = ClipboardPush::TransferScheduler::Instance().CancelAll();
+                ClipboardPush::UI::TrayIcon::Instance().ShowMessage(L"Transfers Cancelled", std::to_wstring(n) + L" transfer(s) cancelled");
+            }
+            break;
         case IDM_TRAY_AUTO_PUSH_TEXT:
             {
-                auto& d = Config::Instance().Data();
-                d.auto_push_text = !d.auto_push_text;
+                Config::Instance().Update([](ConfigData& d) { d.auto_push_text = !d.auto_push_text; });
                 Config::Instance().Save();
             }
             break;
         case IDM_TRAY_AUTO_PUSH_IMG:
             {
-                auto& d = Config::Instance().Data();
-                d.auto_push_image = !d.auto_push_image;
+                Config::Instance().Update([](ConfigData& d) { d.auto_push_image = !d.auto_push_image; });
                 Config::Instance().Save();
             }
             break;
         case IDM_TRAY_AUTO_PUSH_FILE:
             {
-                auto& d = Config::Instance().Data();
-                d.auto_push_file = !d.auto_push_file;
+                Config::Instance().Update([](ConfigData& d) { d.auto_push_file = !d.auto_push_file; });
                 Config::Instance().Save();
             }
             break;
         case IDM_TRAY_AUTO_COPY_IMG:
             {
-                auto& d = Config::Instance().Data();
-                d.auto_copy_image = !d.auto_copy_image;
+                Config::Instance().Update([](ConfigData& d) { d.auto_copy_image = !d.auto_copy_image; });
                 Config::Instance().Save();
             }
             break;
         case IDM_TRAY_AUTO_COPY_FILE:
             {
-                auto& d = Config::Instance().Data();
-                d.auto_copy_file = !d.auto_copy_file;
+                Config::Instance().Update([](ConfigData& d) { d.auto_copy_file = !d.auto_copy_file; });
                 Config::Instance().Save();
             }
             break;
         case IDM_TRAY_AUTO_START:
             {
-                auto& d = Config::Instance().Data();
-                d.auto_start = !d.auto_start;
-                ClipboardPush::Utils::SetAutoStart(d.auto_start);
+                // The registry entry follows through the config subscription
+                Config::Instance().Update([](ConfigData& d) { d.auto_start = !d.auto_start; });
                 Config::Instance().Save();
             }
             break;
         case IDM_TRAY_NOTIFICATIONS:
             {
-                auto& d = Config::Instance().Data();
-                d.show_notifications = !d.show_notifications;
+                Config::Instance().Update([](ConfigData& d) { d.show_notifications = !d.show_notifications; });
                 Config::Instance().Save();
             }
             break;
         case IDC_SETTINGS_RECONNECT:
             {
-                auto& d = ClipboardPush::Config::Instance().Data();
+                auto d = ClipboardPush::Config::Instance().Get();
                 ClipboardPush::SocketIOService::Instance().Disconnect();
-                ClipboardPush::SocketIOService::Instance().Connect(d.relay_server_url, d.room_id, d.device_id);
+                ClipboardPush::SocketIOService::Instance().Connect(d->relay_server_url, d->room_id, d->device_id);
             }
             break;
         case IDC_SETTINGS_SAVE:
             {
                 LOG_INFO("Settings saved signal received, updating components...");
-                auto& d = ClipboardPush::Config::Instance().Data();
-                ClipboardPush::Utils::SetAutoStart(d.auto_start);
-                ClipboardPush::Platform::Hotkey::Instance().Register(hWnd, d.push_hotkey);
+                auto d = ClipboardPush::Config::Instance().Get();
+                ClipboardPush::Platform::Hotkey::Instance().Register(hWnd, d->push_hotkey);
+                ClipboardPush::LanDiscovery::Instance().Refresh();
                 ClipboardPush::SocketIOService::Instance().Disconnect();
-                ClipboardPush::SocketIOService::Instance().Connect(d.relay_server_url, d.room_id, d.device_id);
+                ClipboardPush::SocketIOService::Instance().Connect(d->relay_server_url, d->room_id, d->device_id);
             }
             break;
         }
@@ -721,10 +1825,20 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
     } catch (...) {}
 
     ClipboardPush::Config::Instance().Load();
-    auto& data = ClipboardPush::Config::Instance().Data();
+    auto data = ClipboardPush::Config::Instance().Get();
+
+    // Chunk cache survives restarts so repeat transfers stay cheap
+    ClipboardPush::ChunkStore::Instance().Init(fs::path(Utils::GetAppDir()) / L"chunks", (uint64_t)std::max(data->chunk_cache_mb, 0) * 1024 * 1024);
+    ClipboardPush::BlobStore::Instance().Init(fs::path(Utils::GetAppDir()) / L"temp" / L"blobs", (uint64_t)std::max(data->blob_cache_mb, 0) * 1024 * 1024);
+    ClipboardPush::PeerStats::Instance().Load(fs::path(Utils::GetAppDir()) / L"peer_stats.json");
+    ClipboardPush::TransferScheduler::Instance().Start();
+    ClipboardPush::TimerWheel::Instance().Start();
     
-    // Sync auto-start state
-    ClipboardPush::Utils::SetAutoStart(data.auto_start);
+    // Sync auto-start state, now and whenever the setting changes
+    ClipboardPush::Utils::SetAutoStart(data->auto_start);
+    ClipboardPush::Config::Instance().Subscribe([](const ClipboardPush::ConfigData& before, const ClipboardPush::ConfigData& after) {
+        if (before.auto_start != after.auto_start) ClipboardPush::Utils::SetAutoStart(after.auto_start);
+    });
     
     // Create a dummy window to handle messages
     const wchar_t CLASS_NAME[] = L"ClipboardPushMessageWindow";
@@ -747,48 +1861,33 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
     ClipboardPush::UI::TrayIcon::Instance().Init(hWnd, hInstance);
 
     // Start Local Server for LAN Sync
+    ClipboardPush::LocalServer::Instance().SetPushHooks({ ClaimPushedTransfer, OnPushedFileReceived });
     ClipboardPush::LocalServer::Instance().Start();
+    if (ClipboardPush::Config::Instance().Get()->udp_transport) {
+        ClipboardPush::UdpTransfer::Instance().Start(ClipboardPush::LocalServer::Instance().GetPort());
+    }
+    if (ClipboardPush::Config::Instance().Get()->lan_discovery) {
+        ClipboardPush::LanDiscovery::Instance().Start(ClipboardPush::LocalServer::Instance().GetPort(), ClipboardPush::DiscoveryIdentity);
+    }
+    if (!ClipboardPush::Platform::NetworkMonitor::Instance().Start([]() {
+            ClipboardPush::NetworkInfo::Instance().Invalidate();
+            PostMessageW(g_hMsgWnd, WM_NETWORK_CHANGED, 0, 0);
+        })) {
+        LOG_WARNING("Network change notifications unavailable");
+    }
 
     // Setup Socket.IO
     auto& sio = ClipboardPush::SocketIOService::Instance();
     sio.SetCallbacks(
-        [](const std::string& content, bool encrypted) {
-            if (content.empty()) return;
-            
-            g_isProcessingRemoteSync = true;
-            std::string finalText = content;
-
-            if (encrypted) {
-                auto& config = ClipboardPush::Config::Instance().Data();
-                auto key = ClipboardPush::Crypto::DecodeKey(config.room_key);
-                auto encData = ClipboardPush::Crypto::FromBase64(content);
-                auto dec = ClipboardPush::Crypto::Decrypt(key, encData);
-                if (dec) {
-                    finalText = std::string(dec->begin(), dec->end());
-                } else {
-                    LOG_ERROR("Failed to decrypt remote content");
-                    g_isProcessingRemoteSync = false;
-                    return;
-                }
-            }
-
-            ClipboardPush::Platform::Clipboard::SetText(finalText);
-            
-            std::wstring wMsg = ClipboardPush::Utils::ToWide(finalText.substr(0, 30));
-            if (finalText.length() > 30) wMsg += L"...";
-            ClipboardPush::ShowNotification(L"Clipboard Received", wMsg);
-            
-            // Brief delay to ensure WM_CLIPBOARDUPDATE is ignored
-            std::thread([]() {
-                std::this_thread::sleep_for(std::chrono::milliseconds(500));
-                g_isProcessingRemoteSync = false;
-            }).detach();
+        [](const nlohmann::json& data) {
+            OnRemoteTextReceived(data);
         },
         [](const nlohmann::json& data) {
-            // Run in a separate thread to not block the socket service
-            std::thread([data]() {
+            // Queue on the transfer pool so the socket service is never blocked
+            auto cls = TransferScheduler::Classify(data.value("type", "file"), data.value("size", (uint64_t)0));
+            TransferScheduler::Instance().Submit(cls, data.value("sender_id", "relay"), data.value("filename", "file"), [data](const std::atomic<bool>&) {
                 OnRemoteFileReceived(data);
-            }).detach();
+            });
         },
         [](ConnectionStatus status) {
             std::wstring statusStr;
@@ -830,11 +1929,12 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
         }
     );
             sio.SetSignalingCallback([](const std::string& event, const nlohmann::json& data) {
-                auto& config = Config::Instance().Data();
+                auto config = Config::Instance().Get();
                 std::string room = data.value("room", "");
                 
                 if (event == "room_state_changed" || event == "client_list_update") {
                     std::vector<std::string> peerNames;
+                    std::set<std::string> peerIds;
                     const nlohmann::json* peersArr = nullptr;
 
                     if (event == "room_state_changed" && data.contains("peers") && data["peers"].is_array()) {
@@ -846,21 +1946,27 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
                     if (peersArr) {
                         for (const auto& peer : *peersArr) {
                             std::string cid = peer.value("client_id", "");
-                            if (!cid.empty() && cid != config.device_id) {
+                            if (!cid.empty() && cid != config->device_id) {
                                 std::string dname = peer.value("device_name", "");
                                 peerNames.push_back(Utils::FormatDisplayName(dname, cid));
+                                peerIds.insert(cid);
                             }
                         }
                     }
                                     LOG_INFO("%s: %zu active peers", event.c_str(), peerNames.size());
                                     g_activePeerCount = (int)peerNames.size();
+                                    {
+                                        std::lock_guard<std::mutex> lock(g_peerMutex);
+                                        g_activePeerIds = peerIds;
+                                    }
+                                    OnPeersChanged(peerIds);
                                     UI::MainWindow::Instance().UpdatePeerInfo(peerNames);
                                     UI::TrayIcon::Instance().SetPeerState(!peerNames.empty());
                                     return;                }
     
                 if (event == "peer_evicted") {            LOG_WARNING("Peer evicted from room. Re-joining...");
             SocketIOService::Instance().Disconnect();
-            SocketIOService::Instance().Connect(config.relay_server_url, config.room_id, config.device_id);
+            SocketIOService::Instance().Connect(config->relay_server_url, config->room_id, config->device_id);
             return;
         }
 
@@ -869,80 +1975,68 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
             return;
         }
 
+        if (event == "clipboard_resync") {
+            // Only the device that produced the delta answers, and only if it still holds that text
+            if (data.value("target_source", "") != config->device_id) return;
+            std::string current = GetSyncedTextBase(config->room_id);
+            if (current.empty()) return;
+            std::string tag = ResyncTag(config->room_key, Hash::XXH64(current));
+            if (tag.empty() || tag != data.value("target_tag", "")) return;
+            std::string requester = data.value("source", "");
+            if (requester.empty()) return;
+            LOG_INFO("Peer %s missed delta base, resending full text", requester.c_str());
+            TransferScheduler::Instance().Submit(TransferClass::Text, requester, "resync", [current, requester](const std::atomic<bool>&) {
+                PushTextInternal(current, false, requester);
+            });
+            return;
+        }
+
         std::string transfer_id = data.value("transfer_id", "");
         if (transfer_id.empty()) transfer_id = data.value("file_id", "");
         if (transfer_id.empty()) return;
 
         // Strict Matching: transfer_id + room
-        std::lock_guard<std::mutex> lock(g_pendingMutex);
-        if (g_pendingPushes.count(transfer_id)) {
-            auto pending = g_pendingPushes[transfer_id];
-            if (pending->room != room) return;
-
-            if (event == "transfer_command") {
-                std::string action = data.value("action", "");
-                std::string reason = data.value("reason", "none");
-                LOG_INFO("rx transfer_command: action=%s, reason=%s, id=%s", action.c_str(), reason.c_str(), transfer_id.c_str());
-                
-                if (action == "finish") {
-                    pending->completed = true;
-                } else if (action == "upload_relay") {
-                    pending->upload_requested = true;
-                }
-            } else if (event == "file_sync_completed") {
-                pending->completed = true;
-            } else if (event == "file_need_relay") {
-                pending->need_relay = true;
+        std::shared_ptr<PendingPush> pending;
+        {
+            std::lock_guard<std::mutex> lock(g_pendingMutex);
+            auto it = g_pendingPushes.find(transfer_id);
+            if (it == g_pendingPushes.end() || it->second->room != room) return;
+            pending = it->second;
+        }
+
+        if (event == "transfer_command") {
+            std::string action = data.value("action", "");
+            std::string reason = data.value("reason", "none");
+            LOG_INFO("rx transfer_command: action=%s, reason=%s, id=%s", action.c_str(), reason.c_str(), transfer_id.c_str());
+            
+            if (action == "finish") {
+                SettlePush(pending, TransferPhase::Done, "server_finish");
+            } else if (action == "upload_relay") {
+                StartRelay(pending, "server_directed");
             }
+        } else if (event == "file_sync_completed") {
+            OnPushAcknowledged(pending, data.value("receiver_client_id", ""), data.value("method", "lan"));
+        } else if (event == "file_need_relay") {
+            StartRelay(pending, "app_fallback");
         }
     });
 
-    sio.Connect(data.relay_server_url, data.room_id, data.device_id);
+    sio.Connect(data->relay_server_url, data->room_id, data->device_id);
 
     // Initial Update Check
     ClipboardPush::CheckForUpdates();
 
-    // Setup Clipboard Monitor
+    // Setup Clipboard Monitor. Changes only arm the debounce timer; the push
+    // itself runs from WM_TIMER once the burst has settled.
+    g_autoPushDebouncer.Configure(std::chrono::milliseconds(data->auto_push_debounce_ms), std::chrono::milliseconds(data->auto_push_max_delay_ms));
     ClipboardPush::Platform::ClipboardMonitor::Instance().SetCallback([]() {
-        if (g_isProcessingRemoteSync || g_activePeerCount <= 0) return;
-        
-        auto& config = Config::Instance().Data();
-        bool textEnabled = config.auto_push_text;
-        bool imgEnabled = config.auto_push_image;
-        bool fileEnabled = config.auto_push_file;
+        if (g_activePeerCount <= 0) return;
 
-        if (!textEnabled && !imgEnabled && !fileEnabled) return;
+        auto config = Config::Instance().Get();
+        if (!config->auto_push_text && !config->auto_push_image && !config->auto_push_file) return;
 
-        // Skip if no peers to receive (avoid wasted crypto/upload)
-        // We'll use a simple check: if MainWindow says we're waiting for peers
-        // Actually, let's keep it simple: if the push button would be disabled, skip.
-        // This is safe because SetCallback runs on main thread or we can check peer count.
-        
-        LOG_INFO("Local clipboard changed. Auto-Push Config: Text=%d, Img=%d, File=%d", textEnabled, imgEnabled, fileEnabled);
-        auto cb = ClipboardPush::Platform::Clipboard::Get();
-        
-        if (cb.type == ClipboardPush::Platform::ClipboardType::Text) {
-            if (textEnabled && !cb.text.empty()) {
-                LOG_INFO("Auto-pushing text...");
-                if (ClipboardPush::PushText(cb.text)) {
-                    ClipboardPush::ShowNotification(L"Auto Pushed", L"Text content sent automatically", ClipboardPush::UI::NotificationStyle::Outbound);
-                } else {
-                    LOG_ERROR("Auto-push failed (network error or empty key)");
-                }
-            } else {
-                LOG_INFO("Clipboard text ignored (Auto-Push Disabled or Empty)");
-            }
-        } else if (cb.type == ClipboardPush::Platform::ClipboardType::Image && imgEnabled) {
-            LOG_INFO("Auto-pushing image...");
-            ClipboardPush::PushImage(cb.image_data);
-            ClipboardPush::ShowNotification(L"Auto Pushed", L"Image content sent automatically", ClipboardPush::UI::NotificationStyle::Outbound);
-        } else if (cb.type == ClipboardPush::Platform::ClipboardType::Files && fileEnabled) {
-            LOG_INFO("Auto-pushing %zu file(s)...", cb.files.size());
-            for (const auto& file : cb.files) {
-                ClipboardPush::PushPhysicalFile(file);
-            }
-            ClipboardPush::ShowNotification(L"Auto Pushed", L"File(s) sent automatically", ClipboardPush::UI::NotificationStyle::Outbound);
-        }
+        auto wait = g_autoPushDebouncer.Signal(std::chrono::steady_clock::now());
+        SetTimer(g_hMsgWnd, IDT_AUTO_PUSH, (UINT)wait.count(), NULL);
     });
     ClipboardPush::Platform::ClipboardMonitor::Instance().Start(hWnd);
 
@@ -971,10 +2065,10 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
             ClipboardPush::ShowNotification(L"Clipboard Pushed", L"File(s) sent", ClipboardPush::UI::NotificationStyle::Outbound);
         }
     });
-    ClipboardPush::Platform::Hotkey::Instance().Register(hWnd, data.push_hotkey);
+    ClipboardPush::Platform::Hotkey::Instance().Register(hWnd, data->push_hotkey);
 
     // Show UI
-    if (!data.start_minimized) {
+    if (!data->start_minimized) {
         ClipboardPush::UI::MainWindow::Instance().Show();
     } else {
         ClipboardPush::ShowNotification(L"Clipboard Push v3.0", L"Running ultra-light in system tray!");
@@ -988,9 +2082,17 @@ int APIENTRY wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmd
     }
 
     ClipboardPush::Platform::ClipboardMonitor::Instance().Stop(hWnd);
+    ClipboardPush::Platform::NetworkMonitor::Instance().Stop();
+    ClipboardPush::TimerWheel::Instance().Stop();
+    ClipboardPush::TransferScheduler::Instance().Stop();
+    ClipboardPush::LanDiscovery::Instance().Stop();
+    ClipboardPush::UdpTransfer::Instance().Stop();
     ClipboardPush::LocalServer::Instance().Stop();
+    ClipboardPush::PeerStats::Instance().Save();
+    ClipboardPush::Config::Instance().Flush();
     ClipboardPush::UI::TrayIcon::Instance().Remove();
     ClipboardPush::Platform::Shutdown();
     LOG_INFO("--- Application Terminated Gracefully ---");
+    ClipboardPush::Logger::Shutdown();
     return 0;
 }
\ No newline at end of file
@@ -237,5 +237,9 @@ bool Clipboard::SetImageFromFile(const std::string& filePath) {
     return success;
 }
 
+uint32_t Clipboard::GetSequenceNumber() {
+    return (uint32_t)GetClipboardSequenceNumber();
+}
+
+}
 }
-}
\ No newline at end of file
@@ -23,6 +23,8 @@ public:
     static bool SetFiles(const std::vector<std::string>& files);
     static bool SetImage(const std::vector<uint8_t>& pngData);
     static bool SetImageFromFile(const std::string& filePath);
+    // Changes on every clipboard write, by any process
+    static uint32_t GetSequenceNumber();
 };
 
 }
@@ -0,0 +1,77 @@
+#include "MappedFile.h"
+#include "core/Logger.h"
+
+namespace ClipboardPush {
+namespace Platform {
+
+static const DWORD kReadBlockSize = 4 * 1024 * 1024;
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+bool MappedFile::Open(const std::wstring& path) {
+    Close();
+
+    // Share everything so pushing a file never blocks the app that owns it
+    m_file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (m_file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size = {};
+    if (GetFileType(m_file) == FILE_TYPE_DISK && GetFileSizeEx(m_file, &size) && size.QuadPart > 0 &&
+        (unsigned long long)size.QuadPart <= (unsigned long long)SIZE_MAX) {
+        m_mapping = CreateFileMappingW(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (m_mapping) {
+            m_view = (const uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+            if (m_view) {
+                m_size = (size_t)size.QuadPart;
+                return true;
+            }
+            CloseHandle(m_mapping);
+            m_mapping = NULL;
+        }
+        LOG_WARNING("File mapping failed (%lu), falling back to buffered read", GetLastError());
+    }
+
+    return ReadBuffered();
+}
+
+bool MappedFile::ReadBuffered() {
+    LARGE_INTEGER size = {};
+    if (GetFileSizeEx(m_file, &size) && size.QuadPart > 0) {
+        m_buffer.reserve((size_t)size.QuadPart);
+    }
+
+    // Size may be unknown (pipes) or change underneath us, so read to EOF
+    size_t used = 0;
+    for (;;) {
+        if (m_buffer.size() < used + kReadBlockSize) m_buffer.resize(used + kReadBlockSize);
+        DWORD read = 0;
+        if (!ReadFile(m_file, m_buffer.data() + used, kReadBlockSize, &read, NULL)) {
+            if (GetLastError() == ERROR_BROKEN_PIPE) break;
+            Close();
+            return false;
+        }
+        if (read == 0) break;
+        used += read;
+    }
+    m_buffer.resize(used);
+    m_size = used;
+    return true;
+}
+
+void MappedFile::Close() {
+    if (m_view) UnmapViewOfFile(m_view);
+    if (m_mapping) CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+    m_view = nullptr;
+    m_mapping = NULL;
+    m_file = INVALID_HANDLE_VALUE;
+    m_size = 0;
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+}
+
+}
+}
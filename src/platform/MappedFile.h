@@ -0,0 +1,38 @@
+#pragma once
+#include <windows.h>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace ClipboardPush {
+namespace Platform {
+
+// Read-only view of a whole file. Regular disk files are memory-mapped so
+// callers can hash/encrypt straight from the page cache; anything that cannot
+// be mapped (pipes, devices, empty files) is read in large blocks instead.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::wstring& path);
+    void Close();
+
+    const uint8_t* Data() const { return m_view ? m_view : m_buffer.data(); }
+    size_t Size() const { return m_size; }
+    bool IsMapped() const { return m_view != nullptr; }
+
+private:
+    bool ReadBuffered();
+
+    HANDLE m_file = INVALID_HANDLE_VALUE;
+    HANDLE m_mapping = NULL;
+    const uint8_t* m_view = nullptr;
+    size_t m_size = 0;
+    std::vector<uint8_t> m_buffer;
+};
+
+}
+}
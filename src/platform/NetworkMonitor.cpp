@@ -0,0 +1,197 @@
+#ifdef _WIN32
+// MUST include winsock2 before windows.h
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <iphlpapi.h>
+#include <netioapi.h>
+#else
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <atomic>
+#endif
+#include "NetworkMonitor.h"
+
+namespace ClipboardPush {
+namespace Platform {
+
+// A Wi-Fi roam or lease renewal settles well within this
+static const auto kSettle = std::chrono::milliseconds(1500);
+
+#ifdef _WIN32
+
+struct NetworkMonitor::Backend {
+    HANDLE interfaces = NULL;
+    HANDLE addresses = NULL;
+    HANDLE routes = NULL;
+
+    static VOID NETIOAPI_API_ OnInterface(PVOID ctx, PMIB_IPINTERFACE_ROW, MIB_NOTIFICATION_TYPE type) {
+        if (type != MibInitialNotification) static_cast<NetworkMonitor*>(ctx)->Notify();
+    }
+    static VOID NETIOAPI_API_ OnAddress(PVOID ctx, PMIB_UNICASTIPADDRESS_ROW, MIB_NOTIFICATION_TYPE type) {
+        if (type != MibInitialNotification) static_cast<NetworkMonitor*>(ctx)->Notify();
+    }
+    static VOID NETIOAPI_API_ OnRoute(PVOID ctx, PMIB_IPFORWARD_ROW2 row, MIB_NOTIFICATION_TYPE type) {
+        // Only the default route says which network we're on
+        if (type != MibInitialNotification && row && row->DestinationPrefix.PrefixLength == 0) {
+            static_cast<NetworkMonitor*>(ctx)->Notify();
+        }
+    }
+
+    bool Open(NetworkMonitor* owner) {
+        return NotifyIpInterfaceChange(AF_UNSPEC, OnInterface, owner, FALSE, &interfaces) == NO_ERROR &&
+            NotifyUnicastIpAddressChange(AF_UNSPEC, OnAddress, owner, FALSE, &addresses) == NO_ERROR &&
+            NotifyRouteChange2(AF_UNSPEC, OnRoute, owner, FALSE, &routes) == NO_ERROR;
+    }
+
+    // Blocks until callbacks in flight have returned
+    void Close() {
+        if (interfaces) CancelMibChangeNotify2(interfaces);
+        if (addresses) CancelMibChangeNotify2(addresses);
+        if (routes) CancelMibChangeNotify2(routes);
+        interfaces = addresses = routes = NULL;
+    }
+};
+
+#else
+
+struct NetworkMonitor::Backend {
+    int fd = -1;
+    std::thread reader;
+    std::atomic<bool> running{ false };
+
+    bool Open(NetworkMonitor* owner) {
+        fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+        if (fd < 0) return false;
+        sockaddr_nl local = {};
+        local.nl_family = AF_NETLINK;
+        local.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR | RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE;
+        if (bind(fd, (sockaddr*)&local, sizeof(local)) < 0) {
+            close(fd);
+            fd = -1;
+            return false;
+        }
+        running = true;
+        reader = std::thread([this, owner]() { Read(owner); });
+        return true;
+    }
+
+    void Read(NetworkMonitor* owner) {
+        alignas(nlmsghdr) char buf[16384];
+        while (running) {
+            pollfd p = { fd, POLLIN, 0 };
+            if (poll(&p, 1, 500) <= 0) continue;
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n < 0) {
+                // The kernel dropped messages for us: something changed
+                if (errno == ENOBUFS) owner->Notify();
+                continue;
+            }
+            bool changed = false;
+            for (nlmsghdr* h = (nlmsghdr*)buf; NLMSG_OK(h, (unsigned)n); h = NLMSG_NEXT(h, n)) {
+                switch (h->nlmsg_type) {
+                case RTM_NEWLINK:
+                case RTM_DELLINK:
+                case RTM_NEWADDR:
+                case RTM_DELADDR:
+                    changed = true;
+                    break;
+                case RTM_NEWROUTE:
+                case RTM_DELROUTE: {
+                    // Only the default route says which network we're on
+                    const rtmsg* rt = (const rtmsg*)NLMSG_DATA(h);
+                    if (rt->rtm_dst_len == 0 && rt->rtm_table == RT_TABLE_MAIN) changed = true;
+                    break;
+                }
+                }
+            }
+            if (changed) owner->Notify();
+        }
+    }
+
+    void Close() {
+        running = false;
+        if (reader.joinable()) reader.join();
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+};
+
+#endif
+
+NetworkMonitor& NetworkMonitor::Instance() {
+    static NetworkMonitor instance;
+    return instance;
+}
+
+NetworkMonitor::~NetworkMonitor() {
+    Stop();
+}
+
+bool NetworkMonitor::Start(Callback onChange) {
+    if (m_backend) return true;
+    m_onChange = std::move(onChange);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = true;
+        m_pending = false;
+    }
+    m_thread = std::thread(&NetworkMonitor::Run, this);
+
+    m_backend = std::make_unique<Backend>();
+    if (!m_backend->Open(this)) {
+        m_backend->Close();
+        m_backend.reset();
+        Stop();
+        return false;
+    }
+    return true;
+}
+
+void NetworkMonitor::Stop() {
+    if (m_backend) {
+        m_backend->Close();
+        m_backend.reset();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void NetworkMonitor::Notify() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending = true;
+        m_lastEvent = std::chrono::steady_clock::now();
+    }
+    m_cv.notify_all();
+}
+
+void NetworkMonitor::Run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running) {
+        m_cv.wait(lock, [this] { return !m_running || m_pending; });
+        if (!m_running) break;
+
+        // Let the burst finish; every new event pushes the deadline out
+        auto deadline = m_lastEvent + kSettle;
+        if (std::chrono::steady_clock::now() < deadline) {
+            m_cv.wait_until(lock, deadline, [this] { return !m_running; });
+            continue;
+        }
+
+        m_pending = false;
+        lock.unlock();
+        if (m_onChange) m_onChange();
+        lock.lock();
+    }
+}
+
+}
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+
+namespace ClipboardPush {
+namespace Platform {
+
+// Tells the app when the machine's addresses or default route changed: a
+// new Wi-Fi network, a DHCP lease, a cable or VPN coming up or going down.
+// The OS reports one change as a burst of interface, address and route
+// events, so the callback runs once the burst has been quiet for a moment,
+// on the monitor's own thread.
+//
+// Backends: IP Helper change notifications on Windows, an rtnetlink socket
+// elsewhere.
+class NetworkMonitor {
+public:
+    using Callback = std::function<void()>;
+
+    static NetworkMonitor& Instance();
+
+    // False if the OS refused the subscription; the app then relies on the
+    // relay watchdog and resume-from-sleep handling as before
+    bool Start(Callback onChange);
+    void Stop();
+
+    // Called by the backends for every raw event
+    void Notify();
+
+private:
+    NetworkMonitor() = default;
+    ~NetworkMonitor();
+
+    void Run();
+
+    struct Backend;
+    std::unique_ptr<Backend> m_backend;
+
+    Callback m_onChange;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_running = false;
+    bool m_pending = false;
+    std::chrono::steady_clock::time_point m_lastEvent;
+};
+
+}
+}
@@ -57,8 +57,8 @@ void MainWindow::SetStatus(const std::wstring& status) {
     SetWindowTextW(m_hWnd, title.c_str());
     
     // Also update hint text with current hotkey
-    auto& config = Config::Instance().Data();
-    std::wstring hint = L"Press " + Utils::ToWide(config.push_hotkey) + L" to push clipboard contents.";
+    auto config = Config::Instance().Get();
+    std::wstring hint = L"Press " + Utils::ToWide(config->push_hotkey) + L" to push clipboard contents.";
     SetDlgItemTextW(m_hWnd, IDC_MAIN_HINT, hint.c_str());
 }
 
@@ -86,8 +86,8 @@ void MainWindow::UpdatePeerInfo(const std::vector<std::string>& peerNames) {
     if (!canPush) {
         SetDlgItemTextW(m_hWnd, IDC_MAIN_HINT, L"Status: No peers connected. Connect your phone to enable pushing.");
     } else {
-        auto& config = Config::Instance().Data();
-        std::wstring hint = L"Ready to sync. Press " + Utils::ToWide(config.push_hotkey) + L" or use the button below.";
+        auto config = Config::Instance().Get();
+        std::wstring hint = L"Ready to sync. Press " + Utils::ToWide(config->push_hotkey) + L" or use the button below.";
         SetDlgItemTextW(m_hWnd, IDC_MAIN_HINT, hint.c_str());
     }
 }
@@ -20,6 +20,7 @@
 #define IDM_TRAY_AUTO_COPY_FILE 40009
 #define IDM_TRAY_AUTO_START     40010
 #define IDM_TRAY_NOTIFICATIONS  40011
+#define IDM_TRAY_CANCEL_TRANSFERS 40012
 
 // Dialog IDs
 #define IDD_MAINWINDOW          201
@@ -43,6 +44,7 @@
 
 // Custom Messages
 #define WM_SHOW_NOTIFICATION    (WM_USER + 2)
+#define WM_NETWORK_CHANGED      (WM_USER + 3)
 
 #define IDC_SETTINGS_FILES      2005
 #define IDC_SETTINGS_STARTUP    2006
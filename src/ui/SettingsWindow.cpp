@@ -45,7 +45,7 @@ LRESULT CALLBACK HotkeyEditSubclassProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPA
         isRecording = false;
         if (GetWindowTextLengthW(hWnd) == 0 || GetWindowTextLengthW(hWnd) > 20) {
             // Restore from config if empty
-            SetWindowTextW(hWnd, Utils::ToWide(Config::Instance().Data().push_hotkey).c_str());
+            SetWindowTextW(hWnd, Utils::ToWide(Config::Instance().Get()->push_hotkey).c_str());
         }
         return 0;
 
@@ -119,20 +119,20 @@ void SettingsWindow::SetUpdateAvailable(const std::string& version, const std::s
 }
 
 void SettingsWindow::LoadSettings() {
-    auto& data = Config::Instance().Data();
-    SetDlgItemTextW(m_hWnd, IDC_SETTINGS_PATH, Utils::ToWide(data.download_path).c_str());
-    SetDlgItemTextW(m_hWnd, IDC_SETTINGS_HOTKEY, Utils::ToWide(data.push_hotkey).c_str());
-    SetDlgItemInt(m_hWnd, IDC_SETTINGS_LAN_TIMEOUT, data.lan_timeout, FALSE);
-    SetDlgItemTextW(m_hWnd, IDC_SETTINGS_DEVICEID, Utils::ToWide(data.device_id).c_str());
+    auto data = Config::Instance().Get();
+    SetDlgItemTextW(m_hWnd, IDC_SETTINGS_PATH, Utils::ToWide(data->download_path).c_str());
+    SetDlgItemTextW(m_hWnd, IDC_SETTINGS_HOTKEY, Utils::ToWide(data->push_hotkey).c_str());
+    SetDlgItemInt(m_hWnd, IDC_SETTINGS_LAN_TIMEOUT, data->lan_timeout, FALSE);
+    SetDlgItemTextW(m_hWnd, IDC_SETTINGS_DEVICEID, Utils::ToWide(data->device_id).c_str());
     
-    CheckDlgButton(m_hWnd, IDC_SETTINGS_IMAGES, data.auto_copy_image ? BST_CHECKED : BST_UNCHECKED);
-    CheckDlgButton(m_hWnd, IDC_SETTINGS_FILES, data.auto_copy_file ? BST_CHECKED : BST_UNCHECKED);
-    CheckDlgButton(m_hWnd, IDC_SETTINGS_PUSH_TEXT, data.auto_push_text ? BST_CHECKED : BST_UNCHECKED);
-    CheckDlgButton(m_hWnd, IDC_SETTINGS_PUSH_IMAGE, data.auto_push_image ? BST_CHECKED : BST_UNCHECKED);
-    CheckDlgButton(m_hWnd, IDC_SETTINGS_PUSH_FILE, data.auto_push_file ? BST_CHECKED : BST_UNCHECKED);
-    CheckDlgButton(m_hWnd, IDC_SETTINGS_STARTUP, data.auto_start ? BST_CHECKED : BST_UNCHECKED);
-    CheckDlgButton(m_hWnd, IDC_SETTINGS_MINIMIZED, data.start_minimized ? BST_CHECKED : BST_UNCHECKED);
-    CheckDlgButton(m_hWnd, IDC_SETTINGS_NOTIFICATIONS, data.show_notifications ? BST_CHECKED : BST_UNCHECKED);
+    CheckDlgButton(m_hWnd, IDC_SETTINGS_IMAGES, data->auto_copy_image ? BST_CHECKED : BST_UNCHECKED);
+    CheckDlgButton(m_hWnd, IDC_SETTINGS_FILES, data->auto_copy_file ? BST_CHECKED : BST_UNCHECKED);
+    CheckDlgButton(m_hWnd, IDC_SETTINGS_PUSH_TEXT, data->auto_push_text ? BST_CHECKED : BST_UNCHECKED);
+    CheckDlgButton(m_hWnd, IDC_SETTINGS_PUSH_IMAGE, data->auto_push_image ? BST_CHECKED : BST_UNCHECKED);
+    CheckDlgButton(m_hWnd, IDC_SETTINGS_PUSH_FILE, data->auto_push_file ? BST_CHECKED : BST_UNCHECKED);
+    CheckDlgButton(m_hWnd, IDC_SETTINGS_STARTUP, data->auto_start ? BST_CHECKED : BST_UNCHECKED);
+    CheckDlgButton(m_hWnd, IDC_SETTINGS_MINIMIZED, data->start_minimized ? BST_CHECKED : BST_UNCHECKED);
+    CheckDlgButton(m_hWnd, IDC_SETTINGS_NOTIFICATIONS, data->show_notifications ? BST_CHECKED : BST_UNCHECKED);
 
     // Set Version Text
     if (m_newVersion.empty()) {
@@ -151,38 +151,43 @@ void SettingsWindow::LoadSettings() {
 
     // Update QR - using the requested JSON format
     nlohmann::json j;
-    j["key"] = data.room_key;
-    j["room"] = data.room_id;
-    j["server"] = data.relay_server_url;
+    j["key"] = data->room_key;
+    j["room"] = data->room_id;
+    j["server"] = data->relay_server_url;
     j["local_ip"] = LocalServer::Instance().GetIP();
     j["local_port"] = LocalServer::Instance().GetPort();
     UpdateQR(j.dump());
 }
 
 void SettingsWindow::SaveSettings() {
-    auto& data = Config::Instance().Data();
-    
     wchar_t buffer[MAX_PATH];
     GetDlgItemTextW(m_hWnd, IDC_SETTINGS_PATH, buffer, MAX_PATH);
-    data.download_path = Utils::ToUtf8(buffer);
+    std::string downloadPath = Utils::ToUtf8(buffer);
     
     GetDlgItemTextW(m_hWnd, IDC_SETTINGS_HOTKEY, buffer, MAX_PATH);
-    data.push_hotkey = Utils::ToUtf8(buffer);
+    std::string pushHotkey = Utils::ToUtf8(buffer);
 
-    data.lan_timeout = GetDlgItemInt(m_hWnd, IDC_SETTINGS_LAN_TIMEOUT, NULL, FALSE);
-    if (data.lan_timeout <= 0) data.lan_timeout = 10;
+    int lanTimeout = GetDlgItemInt(m_hWnd, IDC_SETTINGS_LAN_TIMEOUT, NULL, FALSE);
+    if (lanTimeout <= 0) lanTimeout = 10;
 
     GetDlgItemTextW(m_hWnd, IDC_SETTINGS_DEVICEID, buffer, MAX_PATH);
-    data.device_id = Utils::ToUtf8(buffer);
-    
-    data.auto_copy_image = (IsDlgButtonChecked(m_hWnd, IDC_SETTINGS_IMAGES) == BST_CHECKED);
-    data.auto_copy_file = (IsDlgButtonChecked(m_hWnd, IDC_SETTINGS_FILES) == BST_CHECKED);
-    data.auto_push_text = (IsDlgButtonChecked(m_hWnd, IDC_SETTINGS_PUSH_TEXT) == BST_CHECKED);
-    data.auto_push_image = (IsDlgButtonChecked(m_hWnd, IDC_SETTINGS_PUSH_IMAGE) == BST_CHECKED);
-    data.auto_push_file = (IsDlgButtonChecked(m_hWnd, IDC_SETTINGS_PUSH_FILE) == BST_CHECKED);
-    data.auto_start = (IsDlgButtonChecked(m_hWnd, IDC_SETTINGS_STARTUP) == BST_CHECKED);
-    data.start_minimized = (IsDlgButtonChecked(m_hWnd, IDC_SETTINGS_MINIMIZED) == BST_CHECKED);
-    data.show_notifications = (IsDlgButtonChecked(m_hWnd, IDC_SETTINGS_NOTIFICATIONS) == BST_CHECKED);
+    std::string deviceId = Utils::ToUtf8(buffer);
+
+    // Published as one snapshot, so no reader sees half of the dialog applied
+    Config::Instance().Update([&](ConfigData& data) {
+        data.download_path = downloadPath;
+        data.push_hotkey = pushHotkey;
+        data.lan_timeout = lanTimeout;
+        data.device_id = deviceId;
+        data.auto_copy_image = (IsDlgButtonChecked(m_hWnd, IDC_SETTINGS_IMAGES) == BST_CHECKED);
+        data.auto_copy_file = (IsDlgButtonChecked(m_hWnd, IDC_SETTINGS_FILES) == BST_CHECKED);
+        data.auto_push_text = (IsDlgButtonChecked(m_hWnd, IDC_SETTINGS_PUSH_TEXT) == BST_CHECKED);
+        data.auto_push_image = (IsDlgButtonChecked(m_hWnd, IDC_SETTINGS_PUSH_IMAGE) == BST_CHECKED);
+        data.auto_push_file = (IsDlgButtonChecked(m_hWnd, IDC_SETTINGS_PUSH_FILE) == BST_CHECKED);
+        data.auto_start = (IsDlgButtonChecked(m_hWnd, IDC_SETTINGS_STARTUP) == BST_CHECKED);
+        data.start_minimized = (IsDlgButtonChecked(m_hWnd, IDC_SETTINGS_MINIMIZED) == BST_CHECKED);
+        data.show_notifications = (IsDlgButtonChecked(m_hWnd, IDC_SETTINGS_NOTIFICATIONS) == BST_CHECKED);
+    });
     
     Config::Instance().Save();
     LOG_INFO("Settings saved");
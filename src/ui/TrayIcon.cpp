@@ -1,6 +1,7 @@
 #include "TrayIcon.h"
 #include "Resource.h"
 #include "core/Config.h"
+#include "core/TransferScheduler.h"
 #include <shellapi.h>
 
 #define WM_TRAYICON (WM_USER + 1)
@@ -63,18 +64,27 @@ void TrayIcon::ShowContextMenu(HWND hWnd) {
     HMENU hSubMenu = GetSubMenu(m_hMenu, 0);
     
     // Update check states before showing
-    auto& data = Config::Instance().Data();
-    CheckMenuItem(hSubMenu, IDM_TRAY_AUTO_PUSH_TEXT, MF_BYCOMMAND | (data.auto_push_text ? MF_CHECKED : MF_UNCHECKED));
-    CheckMenuItem(hSubMenu, IDM_TRAY_AUTO_PUSH_IMG, MF_BYCOMMAND | (data.auto_push_image ? MF_CHECKED : MF_UNCHECKED));
-    CheckMenuItem(hSubMenu, IDM_TRAY_AUTO_PUSH_FILE, MF_BYCOMMAND | (data.auto_push_file ? MF_CHECKED : MF_UNCHECKED));
-    CheckMenuItem(hSubMenu, IDM_TRAY_AUTO_COPY_IMG, MF_BYCOMMAND | (data.auto_copy_image ? MF_CHECKED : MF_UNCHECKED));
-    CheckMenuItem(hSubMenu, IDM_TRAY_AUTO_COPY_FILE, MF_BYCOMMAND | (data.auto_copy_file ? MF_CHECKED : MF_UNCHECKED));
-    CheckMenuItem(hSubMenu, IDM_TRAY_AUTO_START, MF_BYCOMMAND | (data.auto_start ? MF_CHECKED : MF_UNCHECKED));
-    CheckMenuItem(hSubMenu, IDM_TRAY_NOTIFICATIONS, MF_BYCOMMAND | (data.show_notifications ? MF_CHECKED : MF_UNCHECKED));
+    auto data = Config::Instance().Get();
+    CheckMenuItem(hSubMenu, IDM_TRAY_AUTO_PUSH_TEXT, MF_BYCOMMAND | (data->auto_push_text ? MF_CHECKED : MF_UNCHECKED));
+    CheckMenuItem(hSubMenu, IDM_TRAY_AUTO_PUSH_IMG, MF_BYCOMMAND | (data->auto_push_image ? MF_CHECKED : MF_UNCHECKED));
+    CheckMenuItem(hSubMenu, IDM_TRAY_AUTO_PUSH_FILE, MF_BYCOMMAND | (data->auto_push_file ? MF_CHECKED : MF_UNCHECKED));
+    CheckMenuItem(hSubMenu, IDM_TRAY_AUTO_COPY_IMG, MF_BYCOMMAND | (data->auto_copy_image ? MF_CHECKED : MF_UNCHECKED));
+    CheckMenuItem(hSubMenu, IDM_TRAY_AUTO_COPY_FILE, MF_BYCOMMAND | (data->auto_copy_file ? MF_CHECKED : MF_UNCHECKED));
+    CheckMenuItem(hSubMenu, IDM_TRAY_AUTO_START, MF_BYCOMMAND | (data->auto_start ? MF_CHECKED : MF_UNCHECKED));
+    CheckMenuItem(hSubMenu, IDM_TRAY_NOTIFICATIONS, MF_BYCOMMAND | (data->show_notifications ? MF_CHECKED : MF_UNCHECKED));
 
     // Disable Push if no active peers
     EnableMenuItem(hSubMenu, IDM_TRAY_PUSH, MF_BYCOMMAND | (m_hasPeers ? MF_ENABLED : MF_GRAYED));
 
+    // Show transfer queue state on the cancel item
+    auto snap = TransferScheduler::Instance().GetSnapshot();
+    std::wstring cancelText = L"Cancel Transfers";
+    if (snap.running || snap.queued) {
+        cancelText += L" (" + std::to_wstring(snap.running) + L" active, " + std::to_wstring(snap.queued) + L" queued)";
+    }
+    ModifyMenuW(hSubMenu, IDM_TRAY_CANCEL_TRANSFERS, MF_BYCOMMAND | MF_STRING, IDM_TRAY_CANCEL_TRANSFERS, cancelText.c_str());
+    EnableMenuItem(hSubMenu, IDM_TRAY_CANCEL_TRANSFERS, MF_BYCOMMAND | (snap.running || snap.queued ? MF_ENABLED : MF_GRAYED));
+
     SetForegroundWindow(hWnd);
     TrackPopupMenu(hSubMenu, TPM_RIGHTBUTTON, pt.x, pt.y, 0, hWnd, NULL);
 }
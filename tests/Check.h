@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdio>
+
+// Minimal assertions for the unit tests: a failed check is reported and
+// counted, and the test keeps going so one run shows every failure.
+namespace Check {
+
+inline int& Failures() {
+    static int failures = 0;
+    return failures;
+}
+
+inline int Result(const char* test) {
+    if (Failures()) fprintf(stderr, "%s: %d check(s) failed\n", test, Failures());
+    else printf("%s: all checks passed\n", test);
+    return Failures() ? 1 : 0;
+}
+
+}
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++Check::Failures(); \
+        } \
+    } while (0)
+
+#define CHECK_EQ(a, b) CHECK((a) == (b))
@@ -0,0 +1,104 @@
+#include "Check.h"
+#include "Crypto.h"
+#include <algorithm>
+
+using namespace ClipboardPush;
+
+static std::vector<uint8_t> Key() {
+    std::vector<uint8_t> key(32);
+    for (size_t i = 0; i < key.size(); ++i) key[i] = (uint8_t)(i * 7 + 1);
+    return key;
+}
+
+static std::vector<uint8_t> Payload(size_t n) {
+    std::vector<uint8_t> data(n);
+    uint32_t x = 2463534242u;
+    for (auto& b : data) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        b = (uint8_t)x;
+    }
+    return data;
+}
+
+// Streams `plain` through a GcmEncryptor in `piece`-byte Updates
+static std::vector<uint8_t> SealStreamed(const std::vector<uint8_t>& plain, size_t piece) {
+    Crypto::GcmEncryptor enc(Key());
+    CHECK(enc.IsValid());
+    std::vector<uint8_t> out(enc.Nonce(), enc.Nonce() + 12);
+    for (size_t pos = 0; pos < plain.size(); pos += piece) {
+        CHECK(enc.Update(plain.data() + pos, std::min(piece, plain.size() - pos), out));
+    }
+    CHECK(enc.Finish(out));
+    return out;
+}
+
+static std::optional<std::vector<uint8_t>> OpenStreamed(const std::vector<uint8_t>& envelope, size_t piece) {
+    Crypto::GcmDecryptor dec(Key());
+    CHECK(dec.IsValid());
+    std::vector<uint8_t> out;
+    for (size_t pos = 0; pos < envelope.size(); pos += piece) {
+        if (!dec.Update(envelope.data() + pos, std::min(piece, envelope.size() - pos), out)) return std::nullopt;
+    }
+    if (!dec.Finish(out)) return std::nullopt;
+    return out;
+}
+
+// The streaming classes and the one-shot calls produce and accept the same
+// envelope, whatever the piece sizes and however the payload ends
+static void RoundTrips() {
+    const size_t sizes[] = { 0, 1, 15, 16, 17, 4096, 100000 };
+    const size_t pieces[] = { 1, 7, 16, 4096, 1 << 20 };
+    for (size_t n : sizes) {
+        auto plain = Payload(n);
+        for (size_t piece : pieces) {
+            if (n > 4096 && piece == 1) continue;
+            auto sealed = SealStreamed(plain, piece);
+            CHECK_EQ(sealed.size(), n + 28);
+            auto oneShot = Crypto::Decrypt(Key(), sealed);
+            CHECK(oneShot.has_value() && *oneShot == plain);
+
+            auto envelope = Crypto::Encrypt(Key(), plain);
+            CHECK(envelope.has_value());
+            if (!envelope) continue;
+            auto streamed = OpenStreamed(*envelope, piece);
+            CHECK(streamed.has_value() && *streamed == plain);
+        }
+    }
+}
+
+static void RejectsTampering() {
+    auto plain = Payload(1000);
+    auto sealed = SealStreamed(plain, 100);
+
+    // Any flipped bit in the nonce, ciphertext or tag fails authentication
+    const size_t spots[] = { 0, 11, 12, 500, sealed.size() - 17, sealed.size() - 16, sealed.size() - 1 };
+    for (size_t at : spots) {
+        auto forged = sealed;
+        forged[at] ^= 0x01;
+        CHECK(!OpenStreamed(forged, 64));
+        CHECK(!Crypto::Decrypt(Key(), forged));
+    }
+
+    // Truncated envelopes, including ones cut inside the tag or nonce
+    const size_t lengths[] = { 0, 5, 12, 27, sealed.size() - 1 };
+    for (size_t n : lengths) {
+        std::vector<uint8_t> cut(sealed.begin(), sealed.begin() + n);
+        CHECK(!OpenStreamed(cut, 64));
+    }
+
+    // The wrong key
+    auto other = Key();
+    other[0] ^= 0xFF;
+    Crypto::GcmDecryptor dec(other);
+    std::vector<uint8_t> out;
+    CHECK(dec.Update(sealed.data(), sealed.size(), out));
+    CHECK(!dec.Finish(out));
+}
+
+int main() {
+    RoundTrips();
+    RejectsTampering();
+    return Check::Result("CryptoTest");
+}
@@ -0,0 +1,170 @@
+#include "Check.h"
+#include "Debouncer.h"
+#include <string>
+#include <vector>
+
+using namespace ClipboardPush;
+using Clock = Debouncer::Clock;
+using ms = std::chrono::milliseconds;
+
+// Stands in for the OS clipboard and the message window's one-shot timer,
+// wired the way main.cpp wires the real ones: every clipboard write signals
+// the debouncer and (re)arms the timer; when the timer fires, a due burst
+// pushes whatever the clipboard holds at that moment.
+class FakeClipboardSession {
+public:
+    FakeClipboardSession(ms quiet, ms maxDelay) : m_debouncer(quiet, maxDelay) {}
+
+    // An application writes the clipboard `at` ms into the session
+    void Write(int at, const std::string& content) {
+        m_writes.push_back({ at, content });
+    }
+
+    // Plays the writes in time order, 1 ms per step, for `duration` ms
+    void Run(int duration) {
+        size_t next = 0;
+        for (int t = 0; t <= duration; ++t) {
+            Clock::time_point now = m_start + ms(t);
+            while (next < m_writes.size() && m_writes[next].at == t) {
+                m_clipboard = m_writes[next++].content;
+                // ClipboardMonitor callback
+                ms wait = m_debouncer.Signal(now);
+                m_timer = now + wait;
+                m_timerArmed = true;
+            }
+            if (m_timerArmed && now >= m_timer) {
+                // WM_TIMER
+                ms wait;
+                if (m_debouncer.Poll(now, wait)) {
+                    m_timerArmed = false;
+                    pushes.push_back({ t, m_clipboard });
+                } else if (m_debouncer.Pending()) {
+                    m_timer = now + wait;
+                } else {
+                    m_timerArmed = false;
+                }
+            }
+        }
+    }
+
+    struct Push {
+        int at;
+        std::string content;
+    };
+    std::vector<Push> pushes;
+
+private:
+    struct Entry {
+        int at;
+        std::string content;
+    };
+
+    Debouncer m_debouncer;
+    Clock::time_point m_start = Clock::time_point() + std::chrono::hours(1);
+    std::vector<Entry> m_writes;
+    std::string m_clipboard;
+    Clock::time_point m_timer;
+    bool m_timerArmed = false;
+};
+
+static void SingleCopyPushesOnceAfterQuietWindow() {
+    FakeClipboardSession s(ms(250), ms(1000));
+    s.Write(10, "hello");
+    s.Run(2000);
+    CHECK_EQ(s.pushes.size(), 1u);
+    if (s.pushes.size() == 1) {
+        CHECK_EQ(s.pushes[0].at, 260);
+        CHECK_EQ(s.pushes[0].content, "hello");
+    }
+}
+
+static void MultiFormatWriteCollapsesToFinalContent() {
+    // Office-style copy: plain text, then HTML, then RTF within a few ms
+    FakeClipboardSession s(ms(250), ms(1000));
+    s.Write(0, "text");
+    s.Write(3, "text+html");
+    s.Write(9, "text+html+rtf");
+    s.Run(2000);
+    CHECK_EQ(s.pushes.size(), 1u);
+    if (s.pushes.size() == 1) {
+        CHECK_EQ(s.pushes[0].at, 259);
+        CHECK_EQ(s.pushes[0].content, "text+html+rtf");
+    }
+}
+
+static void MashingIsCappedByMaxLatency() {
+    // Ctrl+C every 100 ms for 3 s never goes quiet for 250 ms
+    FakeClipboardSession s(ms(250), ms(1000));
+    for (int t = 0; t < 3000; t += 100) s.Write(t, "copy " + std::to_string(t));
+    s.Run(5000);
+
+    CHECK(s.pushes.size() >= 3);
+    CHECK(s.pushes.size() <= 4);
+    // A burst starts with the first write after the previous push (at most
+    // 100 ms later) and is pushed no more than 1000 ms after that
+    int previous = -100;
+    for (const auto& p : s.pushes) {
+        CHECK(p.at - previous <= 1100);
+        previous = p.at;
+    }
+    // Latest wins: the final push carries the last copy
+    if (!s.pushes.empty()) CHECK_EQ(s.pushes.back().content, "copy 2900");
+}
+
+static void SeparateCopiesPushSeparately() {
+    FakeClipboardSession s(ms(250), ms(1000));
+    s.Write(0, "first");
+    s.Write(1000, "second");
+    s.Run(3000);
+    CHECK_EQ(s.pushes.size(), 2u);
+    if (s.pushes.size() == 2) {
+        CHECK_EQ(s.pushes[0].content, "first");
+        CHECK_EQ(s.pushes[1].content, "second");
+    }
+}
+
+static void ZeroQuietWindowPushesEveryWrite() {
+    FakeClipboardSession s(ms(0), ms(0));
+    s.Write(0, "a");
+    s.Write(50, "b");
+    s.Run(100);
+    CHECK_EQ(s.pushes.size(), 2u);
+}
+
+static void ConfigureClampsCapToQuietWindow() {
+    Debouncer d(ms(250), ms(1000));
+    d.Configure(ms(500), ms(100));
+    Clock::time_point t0;
+    // The cap can't undercut the quiet window
+    CHECK_EQ(d.Signal(t0).count(), 500);
+    ms wait;
+    CHECK(!d.Poll(t0 + ms(499), wait));
+    CHECK_EQ(wait.count(), 1);
+    CHECK(d.Poll(t0 + ms(500), wait));
+    CHECK(!d.Pending());
+
+    d.Configure(ms(-5), ms(-5));
+    CHECK_EQ(d.Signal(t0).count(), 0);
+}
+
+static void CancelDropsPendingBurst() {
+    Debouncer d(ms(250), ms(1000));
+    Clock::time_point t0;
+    d.Signal(t0);
+    CHECK(d.Pending());
+    d.Cancel();
+    ms wait;
+    CHECK(!d.Poll(t0 + ms(5000), wait));
+    CHECK_EQ(wait.count(), 0);
+}
+
+int main() {
+    SingleCopyPushesOnceAfterQuietWindow();
+    MultiFormatWriteCollapsesToFinalContent();
+    MashingIsCappedByMaxLatency();
+    SeparateCopiesPushSeparately();
+    ZeroQuietWindowPushesEveryWrite();
+    ConfigureClampsCapToQuietWindow();
+    CancelDropsPendingBurst();
+    return Check::Result("DebouncerTest");
+}
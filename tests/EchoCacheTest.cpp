@@ -0,0 +1,69 @@
+#include "Check.h"
+#include "EchoCache.h"
+
+using namespace ClipboardPush;
+using ms = std::chrono::milliseconds;
+
+static const EchoCache::Clock::time_point t0 = EchoCache::Clock::time_point() + std::chrono::hours(1);
+
+// Applying a remote clip suppresses the one clipboard change it causes,
+// not the user's own copy of the same text a moment later
+static void TakeSuppressesOneEcho() {
+    EchoCache cache(64, ms(30000));
+    uint64_t key = EchoCache::TextKey("hello");
+    cache.Remember(key, t0);
+    CHECK(cache.Take(key, t0 + ms(100)));
+    CHECK(!cache.Take(key, t0 + ms(5000)));
+    CHECK(!cache.Contains(key, t0 + ms(5000)));
+
+    // Applied twice, two echoes to absorb
+    cache.Remember(key, t0);
+    cache.Remember(key, t0);
+    CHECK(cache.Take(key, t0));
+    CHECK(cache.Take(key, t0));
+    CHECK(!cache.Take(key, t0));
+}
+
+static void EntriesExpire() {
+    EchoCache cache(64, ms(30000));
+    uint64_t key = EchoCache::FilesKey({ "C:\\Downloads\\a.png" });
+    cache.Remember(key, t0);
+    CHECK(cache.Contains(key, t0 + ms(29999)));
+    CHECK(!cache.Take(key, t0 + ms(30000)));
+}
+
+static void CapacityDropsOldest() {
+    EchoCache cache(2, ms(30000));
+    cache.Remember(1, t0);
+    cache.Remember(2, t0);
+    cache.Remember(3, t0);
+    CHECK(!cache.Contains(1, t0));
+    CHECK(cache.Contains(2, t0));
+    CHECK(cache.Contains(3, t0));
+}
+
+static void ClaimIsFirstComeOnly() {
+    EchoCache cache(256, ms(600000));
+    uint64_t key = EchoCache::TransferKey("tx_1");
+    CHECK(cache.Claim(key, t0));
+    CHECK(!cache.Claim(key, t0 + ms(10)));
+    // Claims aren't consumed by being looked at
+    CHECK(cache.Contains(key, t0 + ms(20)));
+    CHECK(!cache.Claim(key, t0 + ms(30)));
+}
+
+static void KeysNormalizeClipboardRoundTrips() {
+    CHECK_EQ(EchoCache::TextKey("a\r\nb"), EchoCache::TextKey("a\nb"));
+    CHECK_EQ(EchoCache::TextKey(std::string("a\0\0", 3)), EchoCache::TextKey("a"));
+    CHECK_EQ(EchoCache::FilesKey({ "C:/Dir/File.TXT" }), EchoCache::FilesKey({ "c:\\dir\\file.txt" }));
+    CHECK(EchoCache::TextKey("x") != EchoCache::TransferKey("x"));
+}
+
+int main() {
+    TakeSuppressesOneEcho();
+    EntriesExpire();
+    CapacityDropsOldest();
+    ClaimIsFirstComeOnly();
+    KeysNormalizeClipboardRoundTrips();
+    return Check::Result("EchoCacheTest");
+}
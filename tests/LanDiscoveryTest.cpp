@@ -0,0 +1,318 @@
+#include "Check.h"
+#include "PrivateNetwork.h"
+#include "LanDiscovery.h"
+#include "NetworkInfo.h"
+#include <nlohmann/json.hpp>
+#include <fstream>
+#include <set>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+using namespace ClipboardPush;
+using namespace std::chrono;
+
+#ifdef __linux__
+
+static const char* kGroup = "239.255.77.77";
+static const unsigned short kPort = 50077;
+
+// The identity the beacons carry; changed mid-test to move rooms
+static std::mutex g_identityMutex;
+static LanDiscovery::Identity g_identity{ "dev-a", "room-1" };
+
+static LanDiscovery::Identity CurrentIdentity() {
+    std::lock_guard<std::mutex> lock(g_identityMutex);
+    return g_identity;
+}
+
+// A second member of the group, standing in for another device
+class Member {
+public:
+    Member() {
+        m_socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        int on = 1;
+        setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        setsockopt(m_socket, IPPROTO_IP, IP_PKTINFO, &on, sizeof(on));
+        setsockopt(m_socket, IPPROTO_IP, IP_MULTICAST_LOOP, &on, sizeof(on));
+        sockaddr_in local = {};
+        local.sin_family = AF_INET;
+        local.sin_port = htons(kPort);
+        bind(m_socket, (sockaddr*)&local, sizeof(local));
+    }
+    ~Member() { close(m_socket); }
+
+    bool Join(const char* iface) {
+        ip_mreq mreq = {};
+        inet_pton(AF_INET, kGroup, &mreq.imr_multiaddr);
+        inet_pton(AF_INET, iface, &mreq.imr_interface);
+        return setsockopt(m_socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) == 0;
+    }
+
+    void Send(const char* iface, const nlohmann::json& beacon) {
+        in_addr addr = {};
+        inet_pton(AF_INET, iface, &addr);
+        setsockopt(m_socket, IPPROTO_IP, IP_MULTICAST_IF, &addr, sizeof(addr));
+        sockaddr_in group = {};
+        group.sin_family = AF_INET;
+        group.sin_port = htons(kPort);
+        inet_pton(AF_INET, kGroup, &group.sin_addr);
+        std::string data = beacon.dump();
+        sendto(m_socket, data.data(), data.size(), 0, (sockaddr*)&group, sizeof(group));
+    }
+
+    struct Heard {
+        nlohmann::json beacon;
+        unsigned ifindex = 0;
+    };
+
+    // Next beacon from device `id` within `timeout`; ours come back too
+    std::optional<Heard> Next(const std::string& id, milliseconds timeout) {
+        auto deadline = steady_clock::now() + timeout;
+        for (;;) {
+            auto left = duration_cast<milliseconds>(deadline - steady_clock::now());
+            if (left.count() <= 0) return std::nullopt;
+            pollfd pfd = { m_socket, POLLIN, 0 };
+            if (poll(&pfd, 1, (int)left.count()) <= 0) continue;
+
+            char buf[1500];
+            char control[256];
+            iovec iov = { buf, sizeof(buf) };
+            msghdr msg = {};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            ssize_t n = recvmsg(m_socket, &msg, 0);
+            if (n <= 0) continue;
+
+            Heard heard;
+            for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c; c = CMSG_NXTHDR(&msg, c)) {
+                if (c->cmsg_level == IPPROTO_IP && c->cmsg_type == IP_PKTINFO) {
+                    heard.ifindex = ((in_pktinfo*)CMSG_DATA(c))->ipi_ifindex;
+                }
+            }
+            heard.beacon = nlohmann::json::parse(buf, buf + n, nullptr, false);
+            if (heard.beacon.is_object() && heard.beacon.value("id", "") == id) return heard;
+        }
+    }
+
+    // True once device `id` has been heard on every interface in `want`;
+    // beacons still queued from before are skipped over
+    bool HeardOn(const std::string& id, std::set<unsigned> want, milliseconds timeout) {
+        auto deadline = steady_clock::now() + timeout;
+        while (!want.empty() && steady_clock::now() < deadline) {
+            auto left = duration_cast<milliseconds>(deadline - steady_clock::now());
+            if (auto heard = Next(id, left)) want.erase(heard->ifindex);
+        }
+        return want.empty();
+    }
+
+private:
+    int m_socket = -1;
+};
+
+static nlohmann::json Beacon(const std::string& id, const std::string& room, int port) {
+    nlohmann::json j;
+    j["app"] = "clipboard-push";
+    j["v"] = 1;
+    j["room"] = room;
+    j["id"] = id;
+    j["port"] = port;
+    j["caps"] = { "blobs", "chunks" };
+    return j;
+}
+
+template <typename Pred>
+static bool WaitFor(Pred pred, milliseconds timeout = milliseconds(4000)) {
+    auto deadline = steady_clock::now() + timeout;
+    while (!pred()) {
+        if (steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(milliseconds(20));
+    }
+    return true;
+}
+
+// Interfaces holding a membership of the discovery group, from /proc/net/igmp
+static std::set<std::string> JoinedInterfaces() {
+    std::set<std::string> out;
+    std::ifstream igmp("/proc/net/igmp");
+    std::string line, device;
+    while (std::getline(igmp, line)) {
+        if (line.empty()) continue;
+        if (line[0] != '\t') {
+            // "3\tcpa       :     2      V3"
+            size_t tab = line.find('\t');
+            size_t colon = line.find(':');
+            if (tab == std::string::npos || colon == std::string::npos) continue;
+            device = line.substr(tab + 1, colon - tab - 1);
+            device.erase(device.find_last_not_of(' ') + 1);
+        } else if (line.find("4D4DFFEF") != std::string::npos) {
+            out.insert(device); // 239.255.77.77, little-endian hex
+        }
+    }
+    return out;
+}
+
+// Loopback only: NetworkInfo offers nothing, so discovery falls back to the
+// default interface, and beacons go both ways through it
+static void Loopback(Member& member) {
+    auto& lan = LanDiscovery::Instance();
+
+    // Announces itself as soon as it starts
+    auto heard = member.Next("dev-a", milliseconds(3000));
+    CHECK(heard.has_value());
+    if (heard) {
+        CHECK_EQ(heard->beacon.value("room", ""), "room-1");
+        CHECK_EQ(heard->beacon.value("port", 0), 4000);
+        CHECK(heard->beacon.value("caps", nlohmann::json::array()).size() >= 4);
+        CHECK(!heard->beacon.contains("bye"));
+    }
+
+    // A device in the same room is picked up...
+    member.Send("127.0.0.1", Beacon("dev-b", "room-1", 5000));
+    CHECK(WaitFor([&] { return lan.Find("dev-b").has_value(); }));
+    auto peer = lan.Find("dev-b");
+    if (peer) {
+        CHECK_EQ(peer->ip, "127.0.0.1");
+        CHECK_EQ(peer->port, 5000);
+        CHECK_EQ(peer->BaseUrl(), "http://127.0.0.1:5000");
+        CHECK(peer->Has("chunks"));
+        CHECK(!peer->Has("upload"));
+    }
+    // ...and answered well before the next regular beacon is due
+    CHECK(member.Next("dev-a", milliseconds(2500)).has_value());
+
+    // Other rooms, our own ID and junk are ignored
+    member.Send("127.0.0.1", Beacon("dev-c", "room-2", 5001));
+    member.Send("127.0.0.1", Beacon("dev-a", "room-1", 5002));
+    auto bad = Beacon("dev-d", "room-1", 70000);
+    member.Send("127.0.0.1", bad);
+    std::this_thread::sleep_for(milliseconds(300));
+    CHECK(!lan.Find("dev-c"));
+    CHECK(!lan.Find("dev-d"));
+    CHECK_EQ(lan.Peers().size(), (size_t)1);
+
+    // A goodbye drops the peer right away
+    auto bye = Beacon("dev-b", "room-1", 5000);
+    bye["bye"] = true;
+    member.Send("127.0.0.1", bye);
+    CHECK(WaitFor([&] { return !lan.Find("dev-b"); }));
+
+    // A room change applies to the next beacon, no restart needed
+    {
+        std::lock_guard<std::mutex> lock(g_identityMutex);
+        g_identity.roomHash = "room-2";
+    }
+    lan.Refresh();
+    bool moved = false;
+    while (!moved && (heard = member.Next("dev-a", milliseconds(3000)))) moved = heard->beacon.value("room", "") == "room-2";
+    CHECK(moved);
+    member.Send("127.0.0.1", Beacon("dev-c", "room-2", 5001));
+    CHECK(WaitFor([&] { return lan.Find("dev-c").has_value(); }));
+}
+
+// Each usable interface gets its own membership and its own copy of every
+// beacon; a refresh follows interfaces as they come and go
+static void SeveralInterfaces(Member& member) {
+    auto& lan = LanDiscovery::Instance();
+
+    if (!PrivateNetwork::Ip("link add cpa type veth peer name cpb") ||
+        !PrivateNetwork::Ip("addr add 192.168.77.2/24 dev cpa") ||
+        !PrivateNetwork::Ip("link set cpa up") ||
+        !PrivateNetwork::Ip("link set cpb up") ||
+        !PrivateNetwork::Ip("link add cpc type veth peer name cpd") ||
+        !PrivateNetwork::Ip("addr add 10.20.0.5/16 dev cpc") ||
+        !PrivateNetwork::Ip("link set cpc up") ||
+        !PrivateNetwork::Ip("link set cpd up")) {
+        CHECK(!"could not set up veth pairs");
+        return;
+    }
+
+    // Until refreshed, discovery stays on the interfaces it had, and its
+    // peer table survives
+    std::this_thread::sleep_for(milliseconds(1200));
+    CHECK(JoinedInterfaces().count("cpa") == 0);
+    CHECK(lan.Find("dev-c").has_value());
+    member.Join("192.168.77.2");
+    member.Join("10.20.0.5");
+
+    NetworkInfo::Instance().Invalidate();
+    lan.Refresh();
+    CHECK(!lan.Find("dev-c"));
+    CHECK(WaitFor([] {
+        auto joined = JoinedInterfaces();
+        return joined.count("cpa") && joined.count("cpc");
+    }));
+
+    unsigned cpa = if_nametoindex("cpa"), cpc = if_nametoindex("cpc");
+    CHECK(member.HeardOn("dev-a", { cpa, cpc }, milliseconds(7000)));
+
+    // Heard from either subnet, a peer is kept once
+    member.Send("192.168.77.2", Beacon("dev-e", "room-2", 6000));
+    member.Send("10.20.0.5", Beacon("dev-e", "room-2", 6000));
+    CHECK(WaitFor([&] { return lan.Find("dev-e").has_value(); }));
+    CHECK_EQ(lan.Peers().size(), (size_t)1);
+
+    // One interface goes away and another appears
+    if (!PrivateNetwork::Ip("link del cpc") ||
+        !PrivateNetwork::Ip("link add cpe type veth peer name cpf") ||
+        !PrivateNetwork::Ip("addr add 10.30.0.5/24 dev cpe") ||
+        !PrivateNetwork::Ip("link set cpe up") ||
+        !PrivateNetwork::Ip("link set cpf up")) {
+        CHECK(!"could not swap interfaces");
+        return;
+    }
+    member.Join("10.30.0.5");
+    NetworkInfo::Instance().Invalidate();
+    lan.Refresh();
+    CHECK(WaitFor([] {
+        auto joined = JoinedInterfaces();
+        return joined.count("cpa") && joined.count("cpe") && !joined.count("cpc");
+    }));
+
+    unsigned cpe = if_nametoindex("cpe");
+    CHECK(member.HeardOn("dev-a", { cpa, cpe }, milliseconds(7000)));
+}
+
+static void Run() {
+    // Loopback carries multicast when nothing else does
+    if (!PrivateNetwork::Ip("link set lo multicast on") || !PrivateNetwork::Ip("route add 224.0.0.0/4 dev lo")) {
+        CHECK(!"could not route multicast over loopback");
+        return;
+    }
+
+    Member member;
+    CHECK(member.Join("0.0.0.0"));
+    LanDiscovery::Instance().Start(4000, CurrentIdentity);
+
+    Loopback(member);
+    SeveralInterfaces(member);
+
+    // Stopping says goodbye
+    LanDiscovery::Instance().Stop();
+    bool bye = false;
+    while (auto heard = member.Next("dev-a", milliseconds(500))) {
+        if (heard->beacon.value("bye", false)) bye = true;
+    }
+    CHECK(bye);
+}
+
+#endif
+
+int main() {
+#ifdef __linux__
+    // Binds the real discovery port and multicasts, so only in a private namespace
+    if (PrivateNetwork::Enter()) Run();
+    else PrivateNetwork::Skip("LAN discovery cases");
+#else
+    PrivateNetwork::Skip("LAN discovery cases");
+#endif
+    return Check::Result("LanDiscoveryTest");
+}
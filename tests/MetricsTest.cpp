@@ -0,0 +1,50 @@
+#include "Check.h"
+#include "Metrics.h"
+
+using namespace ClipboardPush;
+
+// Cumulative count of one exported bucket line, or -1 if it isn't there
+static long long BucketCount(const std::string& text, const std::string& series) {
+    std::string prefix = series + " ";
+    size_t pos = text.find(prefix);
+    if (pos == std::string::npos) return -1;
+    return std::stoll(text.substr(pos + prefix.size()));
+}
+
+static std::string Bucket(const char* le) {
+    return std::string("clipboard_push_transfer_bytes_bucket{direction=\"out\",le=\"") + le + "\"}";
+}
+
+// A value equal to a bound is inside it, one past it isn't (Prometheus le
+// semantics); values below the first exported bound fold into it
+static void BoundsAreInclusive() {
+    Metrics::PushBytes.Record(0);
+    Metrics::PushBytes.Record(1);
+    Metrics::PushBytes.Record(1024);
+    Metrics::PushBytes.Record(1025);
+    Metrics::PushBytes.Record(2048);
+    Metrics::PushBytes.Record(1ULL << 40);
+
+    std::string text = Metrics::Render();
+    CHECK_EQ(BucketCount(text, Bucket("1024")), 3);
+    CHECK_EQ(BucketCount(text, Bucket("2048")), 5);
+    CHECK_EQ(BucketCount(text, Bucket("4096")), 5);
+    CHECK_EQ(BucketCount(text, Bucket("+Inf")), 6);
+    CHECK_EQ(BucketCount(text, "clipboard_push_transfer_bytes_count{direction=\"out\"}"), 6);
+}
+
+// Scaled histograms export scaled bounds: 2^20 us is 1.048576 s
+static void ScaledBounds() {
+    Metrics::LanPullSeconds.Record(1 << 20);
+    Metrics::LanPullSeconds.Record((1 << 20) + 1);
+    std::string text = Metrics::Render();
+    std::string series = "clipboard_push_stage_seconds_bucket{stage=\"lan_pull\",le=\"";
+    CHECK_EQ(BucketCount(text, series + "1.048576\"}"), 1);
+    CHECK_EQ(BucketCount(text, series + "2.097152\"}"), 2);
+}
+
+int main() {
+    BoundsAreInclusive();
+    ScaledBounds();
+    return Check::Result("MetricsTest");
+}
@@ -0,0 +1,109 @@
+#include "Check.h"
+#include "PrivateNetwork.h"
+#include "NetworkInfo.h"
+#include "Hash.h"
+#include <algorithm>
+
+using namespace ClipboardPush;
+
+static bool Contains(const std::vector<std::string>& v, const std::string& s) {
+    return std::find(v.begin(), v.end(), s) != v.end();
+}
+
+// Whatever this machine is connected to
+static void HostInvariants() {
+    NetworkMetadata m = NetworkInfo::Query();
+    CHECK(!m.private_ip.empty());
+    CHECK(m.addresses.size() <= 8);
+    CHECK(!Contains(m.addresses, "127.0.0.1"));
+    for (const auto& a : m.addresses) CHECK(a.rfind("169.254.", 0) != 0);
+    if (m.private_ip != "127.0.0.1") {
+        // private_ip is the best-ranked IPv4 address
+        auto v4 = std::find_if(m.addresses.begin(), m.addresses.end(), [](const std::string& a) { return a.find(':') == std::string::npos; });
+        CHECK(v4 != m.addresses.end() && *v4 == m.private_ip);
+        CHECK(m.cidr.rfind(m.private_ip + "/", 0) == 0);
+        CHECK(!m.network_id_hash.empty());
+    }
+
+    // Same network, same answer; an invalidation alone doesn't bump the epoch
+    NetworkMetadata a = NetworkInfo::Instance().Snapshot();
+    NetworkInfo::Instance().Invalidate();
+    NetworkMetadata b = NetworkInfo::Instance().Snapshot();
+    CHECK_EQ(a.network_id_hash, b.network_id_hash);
+    CHECK_EQ(a.network_epoch, b.network_epoch);
+    CHECK(a.addresses == b.addresses);
+}
+
+// Built up step by step in a private namespace
+static void ControlledNetwork() {
+    // Only loopback: nothing to offer peers
+    NetworkMetadata empty = NetworkInfo::Query();
+    CHECK_EQ(empty.private_ip, "127.0.0.1");
+    CHECK(empty.addresses.empty());
+    CHECK(empty.network_id_hash.empty());
+
+    if (!PrivateNetwork::Ip("link add cpa type veth peer name cpb") ||
+        !PrivateNetwork::Ip("addr add 10.20.0.5/16 dev cpa") ||
+        !PrivateNetwork::Ip("addr add 192.168.77.2/24 dev cpa") ||
+        !PrivateNetwork::Ip("addr add fd00:77::2/64 dev cpa nodad") ||
+        !PrivateNetwork::Ip("link set cpa up") ||
+        !PrivateNetwork::Ip("link set cpb up") ||
+        !PrivateNetwork::Ip("route add default via 192.168.77.1 dev cpa")) {
+        CHECK(!"could not set up veth pair");
+        return;
+    }
+
+    // Home-router range first, then 10/8, then unique-local IPv6
+    NetworkMetadata m = NetworkInfo::Query();
+    CHECK_EQ(m.private_ip, "192.168.77.2");
+    CHECK_EQ(m.cidr, "192.168.77.2/24");
+    CHECK((m.addresses == std::vector<std::string>{ "192.168.77.2", "10.20.0.5", "fd00:77::2" }));
+    // No neighbour entry for the gateway yet: identified by its IP
+    CHECK_EQ(m.network_id_hash, Hash::ToHex(Hash::XXH64("192.168.77.1|192.168.77.0/24")));
+
+    NetworkInfo& info = NetworkInfo::Instance();
+    info.Invalidate();
+    int epoch = info.Snapshot().network_epoch;
+
+    // The gateway's MAC identifies the network once it's known
+    PrivateNetwork::Ip("neigh add 192.168.77.1 lladdr 02:00:00:00:00:01 dev cpa");
+    CHECK_EQ(info.Snapshot().network_id_hash, m.network_id_hash); // cached until invalidated
+    info.Invalidate();
+    NetworkMetadata first = info.Snapshot();
+    CHECK_EQ(first.network_id_hash, Hash::ToHex(Hash::XXH64("02:00:00:00:00:01|192.168.77.0/24")));
+    CHECK_EQ(first.network_epoch, epoch + 1);
+
+    // Another router handing out the same subnet is another network
+    PrivateNetwork::Ip("neigh replace 192.168.77.1 lladdr 02:00:00:00:00:02 dev cpa");
+    info.Invalidate();
+    NetworkMetadata second = info.Snapshot();
+    CHECK(second.network_id_hash != first.network_id_hash);
+    CHECK_EQ(second.private_ip, first.private_ip);
+    CHECK_EQ(second.network_epoch, epoch + 2);
+
+    // A new lease on the same network keeps the ID
+    PrivateNetwork::Ip("addr del 192.168.77.2/24 dev cpa");
+    PrivateNetwork::Ip("addr add 192.168.77.9/24 dev cpa");
+    PrivateNetwork::Ip("route replace default via 192.168.77.1 dev cpa");
+    PrivateNetwork::Ip("neigh replace 192.168.77.1 lladdr 02:00:00:00:00:02 dev cpa");
+    info.Invalidate();
+    NetworkMetadata renewed = info.Snapshot();
+    CHECK_EQ(renewed.private_ip, "192.168.77.9");
+    CHECK_EQ(renewed.network_id_hash, second.network_id_hash);
+    CHECK_EQ(renewed.network_epoch, epoch + 2);
+
+    // Interfaces that only reach local VMs or containers aren't offered
+    if (PrivateNetwork::Ip("link add docker0 type veth peer name dockerpeer")) {
+        PrivateNetwork::Ip("addr add 172.17.0.1/16 dev docker0");
+        PrivateNetwork::Ip("link set docker0 up");
+        PrivateNetwork::Ip("link set dockerpeer up");
+        CHECK(!Contains(NetworkInfo::Query().addresses, "172.17.0.1"));
+    }
+}
+
+int main() {
+    HostInvariants();
+    if (PrivateNetwork::Enter()) ControlledNetwork();
+    else PrivateNetwork::Skip("controlled network cases");
+    return Check::Result("NetworkInfoTest");
+}
@@ -0,0 +1,84 @@
+#include "Check.h"
+#include "PrivateNetwork.h"
+#include "platform/NetworkMonitor.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace ClipboardPush;
+using Clock = std::chrono::steady_clock;
+using ms = std::chrono::milliseconds;
+
+// The monitor's settle time, plus slack for a loaded test machine
+static const ms kSettle(1500);
+static const ms kSlack(700);
+
+static std::mutex g_mutex;
+static std::vector<Clock::time_point> g_calls;
+
+static size_t Calls() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_calls.size();
+}
+
+static Clock::time_point LastCall() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_calls.empty() ? Clock::time_point() : g_calls.back();
+}
+
+// A burst of raw events yields one callback, once the burst has been quiet
+static void BurstCollapsesToOneCallback() {
+    size_t before = Calls();
+    Clock::time_point last;
+    for (int i = 0; i < 5; ++i) {
+        Platform::NetworkMonitor::Instance().Notify();
+        last = Clock::now();
+        std::this_thread::sleep_for(ms(200));
+    }
+    std::this_thread::sleep_for(kSettle + kSlack);
+    CHECK_EQ(Calls(), before + 1);
+    CHECK(LastCall() - last >= kSettle);
+    CHECK(LastCall() - last < kSettle + kSlack);
+}
+
+// Real kernel events inside a private namespace
+static void KernelEvents() {
+    size_t before = Calls();
+    // Another network's route says nothing about which network we're on
+    PrivateNetwork::Ip("route add 10.9.0.0/16 dev lo");
+    std::this_thread::sleep_for(kSettle + kSlack);
+    CHECK_EQ(Calls(), before);
+
+    PrivateNetwork::Ip("addr add 10.66.0.1/24 dev lo");
+    std::this_thread::sleep_for(kSettle + kSlack);
+    CHECK_EQ(Calls(), before + 1);
+
+    PrivateNetwork::Ip("route add default dev lo");
+    std::this_thread::sleep_for(kSettle + kSlack);
+    CHECK_EQ(Calls(), before + 2);
+}
+
+int main() {
+    // Before Start, so the monitor's socket lives in the namespace
+    bool isolated = PrivateNetwork::Enter();
+
+    bool started = Platform::NetworkMonitor::Instance().Start([]() {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        g_calls.push_back(Clock::now());
+    });
+    CHECK(started);
+
+    BurstCollapsesToOneCallback();
+    if (isolated) KernelEvents();
+    else PrivateNetwork::Skip("kernel event cases");
+
+    Platform::NetworkMonitor::Instance().Stop();
+    // Stopped: raw events no longer reach the callback
+    size_t stopped = Calls();
+    Platform::NetworkMonitor::Instance().Notify();
+    std::this_thread::sleep_for(kSettle + kSlack);
+    CHECK_EQ(Calls(), stopped);
+
+    return Check::Result("NetworkMonitorTest");
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+// Tests that need real interface, address and route changes run them in a
+// private Linux network namespace, where they can't disturb the host. That
+// takes root (or CAP_SYS_ADMIN + CAP_NET_ADMIN) and iproute2; elsewhere those
+// parts are skipped.
+namespace PrivateNetwork {
+
+// Moves the calling thread, and every thread or process it starts later,
+// into a fresh namespace holding only a loopback interface, brought up
+inline bool Enter() {
+#ifdef __linux__
+    if (geteuid() != 0) return false;
+    if (system("ip -V >/dev/null 2>&1") != 0) return false;
+    if (unshare(CLONE_NEWNET) != 0) return false;
+    return system("ip link set lo up") == 0;
+#else
+    return false;
+#endif
+}
+
+// Runs an `ip` command inside the namespace
+inline bool Ip(const std::string& args) {
+    std::string cmd = "ip " + args + " >/dev/null 2>&1";
+    if (system(cmd.c_str()) == 0) return true;
+    fprintf(stderr, "command failed: %s\n", cmd.c_str());
+    return false;
+}
+
+inline void Skip(const char* what) {
+    printf("skipped %s: needs root and iproute2 on Linux\n", what);
+}
+
+}
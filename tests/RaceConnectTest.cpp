@@ -0,0 +1,131 @@
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+#include "Check.h"
+#include "PrivateNetwork.h"
+#include "Network.h"
+#include "Logger.h"
+
+using namespace ClipboardPush;
+using ms = std::chrono::milliseconds;
+
+// Listening TCP socket on 127.0.0.1; connects complete from the backlog,
+// nothing is ever accepted
+class Listener {
+public:
+    Listener() {
+        m_fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(m_fd, (sockaddr*)&addr, sizeof(addr));
+        listen(m_fd, 16);
+        socklen_t len = sizeof(addr);
+        getsockname(m_fd, (sockaddr*)&addr, &len);
+        m_port = ntohs(addr.sin_port);
+    }
+    ~Listener() {
+#ifdef _WIN32
+        closesocket(m_fd);
+#else
+        close(m_fd);
+#endif
+    }
+    int Port() const { return m_port; }
+
+private:
+#ifdef _WIN32
+    SOCKET m_fd;
+#else
+    int m_fd;
+#endif
+    int m_port = 0;
+};
+
+struct Outcome {
+    int winner;
+    long long elapsedMs;
+};
+
+static Outcome Race(const std::vector<std::string>& hosts, int port, ms stagger, ms timeout) {
+    auto start = std::chrono::steady_clock::now();
+    int winner = Network::RaceConnect(hosts, port, stagger, timeout);
+    auto elapsed = std::chrono::duration_cast<ms>(std::chrono::steady_clock::now() - start).count();
+    return { winner, elapsed };
+}
+
+// Loopback only: a bound port answers, other 127/8 addresses refuse
+static void LoopbackCases() {
+    Listener server;
+    int port = server.Port();
+    const ms stagger(1000), timeout(5000);
+
+    CHECK_EQ(Network::RaceConnect({}, port, stagger, timeout), -1);
+    // One candidate isn't raced at all
+    CHECK_EQ(Network::RaceConnect({ "203.0.113.9" }, port, stagger, timeout), 0);
+
+    // The remembered winner listed first connects without waiting for the rest
+    auto first = Race({ "127.0.0.1", "127.0.0.3" }, port, stagger, timeout);
+    CHECK_EQ(first.winner, 0);
+    CHECK(first.elapsedMs < 500);
+
+    // Unparseable hosts are skipped, not waited on
+    auto garbage = Race({ "not-an-ip", "127.0.0.1" }, port, stagger, timeout);
+    CHECK_EQ(garbage.winner, 1);
+    CHECK(garbage.elapsedMs < 500);
+
+    auto refusedFirst = Race({ "127.0.0.3", "127.0.0.1" }, port, stagger, timeout);
+    CHECK_EQ(refusedFirst.winner, 1);
+#ifndef _WIN32
+    // A refusal starts the next attempt at once (Windows retries refused
+    // loopback SYNs for a couple of seconds, so only the result counts there)
+    CHECK(refusedFirst.elapsedMs < 500);
+
+    auto allRefused = Race({ "127.0.0.3", "127.0.0.4" }, port, stagger, timeout);
+    CHECK_EQ(allRefused.winner, -1);
+    CHECK(allRefused.elapsedMs < 500);
+#endif
+}
+
+// A silent host (its link is up, nobody answers ARP) stalls its connect;
+// the race must move on after one stagger rather than wait it out
+static void SilentHostCases() {
+    if (!PrivateNetwork::Ip("link add cpa type veth peer name cpb") ||
+        !PrivateNetwork::Ip("addr add 10.77.0.1/24 dev cpa") ||
+        !PrivateNetwork::Ip("link set cpa up") ||
+        !PrivateNetwork::Ip("link set cpb up")) {
+        CHECK(!"could not set up veth pair");
+        return;
+    }
+    Listener server;
+    int port = server.Port();
+
+    auto staggered = Race({ "10.77.0.2", "127.0.0.1" }, port, ms(300), ms(5000));
+    CHECK_EQ(staggered.winner, 1);
+    CHECK(staggered.elapsedMs >= 280);
+    CHECK(staggered.elapsedMs < 800);
+
+    auto silent = Race({ "10.77.0.2", "10.77.0.3" }, port, ms(100), ms(500));
+    CHECK_EQ(silent.winner, -1);
+    CHECK(silent.elapsedMs >= 480);
+    CHECK(silent.elapsedMs < 1000);
+}
+
+int main() {
+#ifdef _WIN32
+    WSADATA wsa;
+    WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+    bool isolated = PrivateNetwork::Enter();
+    LoopbackCases();
+    if (isolated) SilentHostCases();
+    else PrivateNetwork::Skip("silent-host cases");
+    Logger::Shutdown();
+    return Check::Result("RaceConnectTest");
+}
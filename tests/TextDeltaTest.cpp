@@ -0,0 +1,144 @@
+#include "Check.h"
+#include "TextDelta.h"
+#include "Hash.h"
+
+using namespace ClipboardPush;
+
+static std::string Lines(int first, int count) {
+    std::string s;
+    for (int i = first; i < first + count; ++i) s += "line " + std::to_string(i) + " of the clipboard text\n";
+    return s;
+}
+
+static void RoundTrips() {
+    std::string base = Lines(0, 400);
+    const std::string targets[] = {
+        base,
+        Lines(0, 200) + "an edit in the middle\n" + Lines(200, 200),
+        Lines(0, 400) + Lines(0, 400),   // copies repeat the base
+        Lines(50, 300),
+        "nothing in common",
+        "",
+    };
+    for (const auto& target : targets) {
+        auto delta = TextDelta::Encode(base, target);
+        auto out = TextDelta::Apply(base, delta);
+        CHECK(out.has_value());
+        if (out) CHECK(*out == target);
+    }
+
+    // A small edit to a long clip is worth sending as a delta
+    auto delta = TextDelta::Encode(base, targets[1]);
+    CHECK(delta.size() * 10 < targets[1].size());
+
+    auto hdr = TextDelta::ReadHeader(delta);
+    CHECK(hdr.has_value());
+    if (hdr) {
+        CHECK_EQ(hdr->base_hash, Hash::XXH64(base));
+        CHECK_EQ(hdr->target_hash, Hash::XXH64(targets[1]));
+        CHECK_EQ(hdr->target_len, (uint64_t)targets[1].size());
+    }
+}
+
+static void RejectsOtherBase() {
+    std::string base = Lines(0, 100);
+    auto delta = TextDelta::Encode(base, Lines(0, 101));
+    CHECK(!TextDelta::Apply(Lines(1, 100), delta));
+}
+
+static void PutVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+// Header for `base` claiming a target of `len` bytes hashing to `hash`
+static std::vector<uint8_t> Header(const std::string& base, uint64_t hash, uint64_t len) {
+    std::vector<uint8_t> out = { 'C', 'P', 'D', '1' };
+    uint64_t baseHash = Hash::XXH64(base);
+    for (int i = 0; i < 8; ++i) out.push_back((uint8_t)(baseHash >> (i * 8)));
+    for (int i = 0; i < 8; ++i) out.push_back((uint8_t)(hash >> (i * 8)));
+    PutVarint(out, len);
+    return out;
+}
+
+static void RejectsMalformed() {
+    std::string base = Lines(0, 100);
+    auto good = TextDelta::Encode(base, Lines(0, 50) + "x" + Lines(50, 50));
+    CHECK(TextDelta::Apply(base, good).has_value());
+
+    // Every truncation fails cleanly
+    for (size_t n = 0; n < good.size(); ++n) {
+        std::vector<uint8_t> cut(good.begin(), good.begin() + n);
+        CHECK(!TextDelta::Apply(base, cut));
+    }
+
+    auto badMagic = good;
+    badMagic[0] = 'X';
+    CHECK(!TextDelta::ReadHeader(badMagic));
+    CHECK(!TextDelta::Apply(base, badMagic));
+
+    // Unknown op
+    auto d = Header(base, Hash::XXH64(std::string("ab")), 2);
+    d.push_back('Z');
+    CHECK(!TextDelta::Apply(base, d));
+
+    // Copy past the end of the base
+    d = Header(base, 0, 10);
+    d.push_back('C');
+    PutVarint(d, base.size() - 5);
+    PutVarint(d, 10);
+    CHECK(!TextDelta::Apply(base, d));
+
+    // Insert longer than what follows it
+    d = Header(base, 0, 100);
+    d.push_back('I');
+    PutVarint(d, 100);
+    d.push_back('a');
+    CHECK(!TextDelta::Apply(base, d));
+
+    // Output past the declared length
+    std::string ab = "ab";
+    d = Header(base, Hash::XXH64(ab), 1);
+    d.push_back('I');
+    PutVarint(d, 2);
+    d.insert(d.end(), ab.begin(), ab.end());
+    CHECK(!TextDelta::Apply(base, d));
+
+    // Right length, wrong content
+    d = Header(base, Hash::XXH64(std::string("ba")), 2);
+    d.push_back('I');
+    PutVarint(d, 2);
+    d.insert(d.end(), ab.begin(), ab.end());
+    CHECK(!TextDelta::Apply(base, d));
+}
+
+// A header claiming an absurd length must not size an allocation
+static void RejectsHugeTargetLength() {
+    std::string base = Lines(0, 10);
+    auto d = Header(base, 0, ~0ull);
+    d.push_back('I');
+    PutVarint(d, 1);
+    d.push_back('a');
+    CHECK(!TextDelta::Apply(base, d));
+
+    d = Header(base, 0, TextDelta::kMaxTargetBytes + 1);
+    CHECK(!TextDelta::Apply(base, d));
+
+    // Just under the cap is still only trusted as far as the ops go
+    d = Header(base, 0, TextDelta::kMaxTargetBytes);
+    d.push_back('C');
+    PutVarint(d, 0);
+    PutVarint(d, base.size());
+    CHECK(!TextDelta::Apply(base, d));
+}
+
+int main() {
+    RoundTrips();
+    RejectsOtherBase();
+    RejectsMalformed();
+    RejectsHugeTargetLength();
+    return Check::Result("TextDeltaTest");
+}